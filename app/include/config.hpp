@@ -32,27 +32,86 @@ struct AppConfig {
     std::string ply_path;
 
     /** The path where meshes are saved. Set to the empty string to disable meshing. Set to `"."`
-     * for the current directory.
+     * for the current directory. With a finite se::MapConfig::active_radius the mesh saved at the
+     * end of the run covers only the active region, the rest is written to finalised_mesh_path.
      */
     std::string mesh_path;
 
     /** The path where slice meshes are saved. Set to the empty string to disable slice meshing. Set
-     * to `"."` for the current directory.
+     * to `"."` for the current directory. Not supported in submap mode.
      */
     std::string slice_path;
 
+    /** The path where renders of the TSDF raycast from the current pose are saved as `render_N.png`
+     * every rendering_rate frames. Set to the empty string to disable rendering. Set to `"."` for
+     * the current directory. Not supported in submap mode.
+     */
+    std::string render_path;
+
     /** The path where structure meshes are saved. Set to the empty string to disable structure
-     * meshing. Set to `"."` for the current directory.
+     * meshing. Set to `"."` for the current directory. Not supported in submap mode.
      */
     std::string structure_path;
 
+    /** The directory where tiled multi-LOD meshes are written, see se::io::TiledMeshWriter. Only the
+     * tiles that changed are rewritten each time. Set to the empty string to disable tiled meshing.
+     * Not supported in submap mode.
+     */
+    std::string tile_path;
+
+    /** The directory where the map changes are written after each integration, see
+     * se::io::ChangeFeed. The file `delta_N.bin` contains the voxels changed by frame N and is only
+     * written if a voxel changed. Set to the empty string to disable the change feed. Not
+     * supported in submap mode.
+     */
+    std::string change_feed_path;
+
+    /** The directory where the meshes of the blocks leaving the active region are written, see
+     * se::ActiveWindow and se::MapConfig::active_radius. The file `finalised_N.ply` contains the
+     * blocks finalised before integrating frame N, or after integrating the batch ending at frame N
+     * with integration_batch_size above 1. Set to the empty string to disable it. Not supported in
+     * submap mode.
+     */
+    std::string finalised_mesh_path;
+
+    /** Serve live metrics in the Prometheus text format, see se::MetricsExporter. Set to a TCP port,
+     * e.g. `"9464"`, to listen on the loopback interface or to the path of a Unix domain socket. Set
+     * to the empty string to disable the metrics exporter.
+     */
+    std::string metrics_endpoint;
+
+    /** Show the GUI. When false no visualization data is prepared, e.g. for running without a
+     * display or for benchmarking.
+     */
+    bool enable_gui = true;
+
+    /** Remove flying pixels and isolated noise from the depth images and smooth them before
+     * integration, see se::preprocessor::remove_flying_pixels() and
+     * se::preprocessor::bilateral_filter(). This avoids allocating blocks in free space around
+     * depth discontinuities and for depth noise. Rendered depth images, e.g. those of Replica, have
+     * neither, so there the filter only adds its own cost.
+     */
+    bool enable_depth_filter = false;
+
+    /** The maximum depth difference, relative to the pixel depth, of neighbouring pixels on the
+     * same surface when filtering depth images.
+     */
+    float depth_filter_max_jump = 0.03f;
+
     /** Integrate a 3D reconstruction every integration_rate frames.
      */
     int integration_rate = 1;
 
+    /** Buffer this many integrated frames and fuse them in a single pass over the union of their
+     * blocks, see se::integrator::integrate(). 1 integrates each frame on its own. The active
+     * region is moved after each batch, so a batch should cover less motion than
+     * se::MapConfig::active_radius.
+     */
+    int integration_batch_size = 1;
+
     /** Render the 3D reconstruction every rendering_rate frames.
      *
-     * \note AppConfig::enable_render == true (default) required.
+     * \note A non-empty AppConfig::render_path is required.
      *
      * Special cases:
      * If rendering_rate == 0 the volume is only rendered for configuration::max_frame.
@@ -60,6 +119,19 @@ struct AppConfig {
      */
     int rendering_rate = 4;
 
+    /** Raycast only every raycast_subsampling_factor-th pixel along each image axis when rendering
+     * and upsample the rest, see se::raycaster::raycast_volume_subsampled(). Set to 1 to raycast
+     * every pixel.
+     */
+    int raycast_subsampling_factor = 1;
+
+    /** Raycast each render around the surface of the previous render, see
+     * se::raycaster::raycast_volume_reprojected(). The previous render is rendering_rate frames
+     * old, so this pays off when rendering often during smooth motion. It takes precedence over
+     * raycast_subsampling_factor except for the first render.
+     */
+    bool enable_raycast_reprojection = false;
+
     /** Mesh the 3D reconstruction every meshing_rate frames.
      *
      * Special cases:
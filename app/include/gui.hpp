@@ -13,7 +13,7 @@
 
 class GUI {
     public:
-    GUI(gs::DataQueue& data_queue, std::atomic<bool>& stop_signal, int width, int height) : data_queue_(data_queue), stop_signal_(stop_signal), img_width_(width), img_height_(height)
+    GUI(gs::DataMailbox& data_mailbox, std::atomic<bool>& stop_signal, int width, int height) : data_mailbox_(data_mailbox), stop_signal_(stop_signal), img_width_(width), img_height_(height)
     {
     }
 
@@ -25,7 +25,7 @@ class GUI {
     bool onWindowClose();
     void cleanUp();
 
-    gs::DataQueue& data_queue_;
+    gs::DataMailbox& data_mailbox_;
     std::atomic<bool>& stop_signal_;
 
     int img_width_;
@@ -27,6 +27,8 @@ Config<DataConfigT, SensorConfigT>::Config(const std::string& yaml_file) : data(
     sensor.readYaml(yaml_file);
     reader.readYaml(yaml_file);
     app.readYaml(yaml_file);
+    // The reader downsamples the images so the sensor must match their resolution.
+    sensor.downsample(reader.downsampling_factor);
 }
 
 
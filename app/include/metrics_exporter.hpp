@@ -0,0 +1,113 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Smart Robotics Lab, Technical University of Munich
+ * SPDX-FileCopyrightText: 2024 Jiaxin Wei
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef SE_METRICS_EXPORTER_HPP
+#define SE_METRICS_EXPORTER_HPP
+
+#include <array>
+#include <atomic>
+#include <map>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "se/common/perfstats.hpp"
+
+namespace se {
+
+/** Serve the current performance statistics of a running session in the Prometheus text
+ * exposition format over HTTP.
+ *
+ * The integration loop calls publish() once per frame, which copies the latest values and the
+ * duration quantiles into an immutable snapshot and swaps it in with std::atomic_store(). A
+ * separate thread accepts the scrape requests and formats the latest snapshot, so it never reads
+ * PerfStats while it's being modified. The shared_ptr atomics are implemented with a lock in
+ * libstdc++, so publish() may wait for a scrape, but only while it copies the snapshot pointer.
+ *
+ * All PerfStats are exported as gauges named `gsfusion_<stat name>` with their unit appended.
+ * Durations are additionally exported as summaries with the 0.5, 0.9 and 0.99 quantiles of the
+ * last frames.
+ */
+class MetricsExporter {
+    public:
+    struct Metric {
+        std::string name;
+        /** The Prometheus metric type, "gauge" or "counter". */
+        std::string type;
+        double value;
+        std::string help;
+    };
+
+    /**
+     * \param[in] endpoint    A TCP port to listen on the loopback interface, e.g. `"9464"`, or
+     *                        the path of a Unix domain socket, e.g. `"/tmp/gsfusion.sock"`.
+     * \param[in] window_size The number of frames the duration quantiles are computed over.
+     */
+    MetricsExporter(const std::string& endpoint, const size_t window_size = 1000);
+
+    ~MetricsExporter();
+
+    MetricsExporter(const MetricsExporter&) = delete;
+    MetricsExporter& operator=(const MetricsExporter&) = delete;
+
+    /** Return whether the endpoint was opened successfully and requests are being served.
+     */
+    bool isRunning() const
+    {
+        return listen_fd_ >= 0;
+    }
+
+    /** Publish the latest values of \p perfstats and the metrics in \p extra_metrics. Must be called
+     * from the thread sampling \p perfstats.
+     */
+    void publish(const PerfStats& perfstats, const std::vector<Metric>& extra_metrics = {});
+
+    private:
+    struct Latency {
+        std::vector<double> window;
+        size_t next_idx = 0;
+        double sum = 0.0;
+        size_t count = 0;
+    };
+
+    struct Summary {
+        std::string name;
+        size_t window_size;
+        std::array<double, 3> quantiles;
+        double sum;
+        size_t count;
+    };
+
+    struct Snapshot {
+        std::vector<Metric> metrics;
+        std::vector<Summary> summaries;
+    };
+
+    /** The quantiles reported for each latency summary. */
+    static constexpr std::array<double, 3> quantiles_ = {0.5, 0.9, 0.99};
+
+    void serve();
+
+    static std::string render(const Snapshot& snapshot);
+
+    const std::string endpoint_;
+    const size_t window_size_;
+    int listen_fd_;
+    bool is_unix_socket_;
+    /** Only accessed by publish(). */
+    std::map<std::string, Latency> latencies_;
+    /** Scratch buffer for computing the quantiles, only accessed by publish(). */
+    std::vector<double> quantile_window_;
+    /** Accessed through std::atomic_load() and std::atomic_store() only. */
+    std::shared_ptr<const Snapshot> snapshot_;
+    std::atomic<bool> stop_;
+    std::thread thread_;
+};
+
+} // namespace se
+
+#endif // SE_METRICS_EXPORTER_HPP
@@ -11,10 +11,12 @@
 #define __READER_BASE_HPP
 
 #include <Eigen/Core>
+#include <Eigen/Geometry>
+#include <Eigen/StdVector>
 #include <chrono>
 #include <cstdint>
-#include <fstream>
 #include <string>
+#include <vector>
 
 #include "se/common/colour_types.hpp"
 #include "se/common/str_utils.hpp"
@@ -29,6 +31,10 @@ enum class ReaderType {
     REPLICA,
     /** Use the se::ScanNetppReader. */
     SCANNETPP,
+    /** Use the se::ShmReader. */
+    SHM,
+    /** Use the se::VideoReader. */
+    VIDEO,
     UNKNOWN
 };
 
@@ -43,7 +49,8 @@ struct ReaderConfig {
     ReaderType reader_type = se::ReaderType::REPLICA;
 
     /** The path to the dataset. This might be a path to a file or a directory depending on the
-     * reader type.
+     * reader type. For se::ReaderType::SHM it's the name of the shared-memory object starting with
+     * a slash, e.g. `/gsfusion_frames`.
      */
     std::string sequence_path;
 
@@ -84,6 +91,22 @@ struct ReaderConfig {
      */
     int verbose = 0;
 
+    /** The number of contiguous shards the sequence is split into. Each shard can be read, and
+     * mapped, by a separate process so that long sequences are processed in parallel.
+     */
+    int num_shards = 1;
+
+    /** The index of the shard to read, in the interval [0, se::ReaderConfig::num_shards).
+     */
+    int shard = 0;
+
+    /** The factor the depth and colour images are downsampled by while reading, a power of 2. Depth
+     * is downsampled without mixing depth discontinuities and colour by block averaging. The
+     * sensor configuration read by se::Config is scaled to match so that the whole pipeline runs at
+     * the lower resolution.
+     */
+    int downsampling_factor = 1;
+
     /** Reads the struct members from the "reader" node of a YAML file. Members not present in the
      * YAML file aren't modified.
      */
@@ -127,6 +150,10 @@ std::ostream& operator<<(std::ostream& os, const ReaderStatus& s);
  *       at the derived class constructor.
  *     - The value of se::Reader::status_ should only be set in derived class
  *       constructors and se::Reader::restart() if applicable.
+ *     - Derived classes that convert the ground truth of their dataset should
+ *       store it with se::Reader::appendPose() in their constructor. Otherwise
+ *       the ground truth file is parsed with the format described in
+ *       se::Reader::getPose() on the first pose request.
  */
 class Reader {
     public:
@@ -225,11 +252,54 @@ class Reader {
      */
     ReaderStatus nextData(Image<float>& depth_image, Image<rgb_t>& colour_image, Image<semantics_t>& class_id_image, Eigen::Matrix4f& T_WB);
 
+    /** Read the depth image of the provided frame number without waiting to
+     * respect se::ReaderConfig::fps. Reading continues from the next frame
+     * when calling nextData() afterwards.
+     *
+     * \param[in]  frame       The frame number to read.
+     * \param[out] depth_image The depth image of the frame.
+     * \return An appropriate status code.
+     */
+    ReaderStatus readFrame(const size_t frame, Image<float>& depth_image);
+
+    /** Read the depth and colour images of the provided frame number without
+     * waiting to respect se::ReaderConfig::fps. Reading continues from the
+     * next frame when calling nextData() afterwards.
+     *
+     * \param[in]  frame        The frame number to read.
+     * \param[out] depth_image  The depth image of the frame.
+     * \param[out] colour_image The colour image of the frame.
+     * \return An appropriate status code.
+     */
+    ReaderStatus readFrame(const size_t frame, Image<float>& depth_image, Image<rgb_t>& colour_image);
+
+    /** Read the depth and colour images and ground truth pose of the provided
+     * frame number without waiting to respect se::ReaderConfig::fps. Reading
+     * continues from the next frame when calling nextData() afterwards.
+     *
+     * \param[in]  frame        The frame number to read.
+     * \param[out] depth_image  The depth image of the frame.
+     * \param[out] colour_image The colour image of the frame.
+     * \param[out] T_WB         The ground truth pose of the frame.
+     * \return An appropriate status code.
+     */
+    ReaderStatus readFrame(const size_t frame, Image<float>& depth_image, Image<rgb_t>& colour_image, Eigen::Matrix4f& T_WB);
+
+    /** Make the next call to one of the nextData() functions read the
+     * provided frame number.
+     *
+     * \param[in] frame The frame number to read next.
+     * \return se::ReaderStatus::eof if \p frame is past the end of the
+     *         sequence, se::ReaderStatus::ok otherwise.
+     */
+    ReaderStatus seek(const size_t frame);
+
     /** Read the ground truth pose at the provided frame number.
      * Each line in the ground truth file should correspond to a single
      * depth/colour image pair and have a format<br>
      * `... tx ty tz qx qy qz qw`,<br>
      * that is the pose is encoded in the last 7 columns of the line.
+     * The poses are read once into memory so this is a constant-time lookup.
      *
      * \param[in]  frame The frame number of the requested ground truth pose.
      * \param[out] T_WB  The ground truth pose.
@@ -269,20 +339,35 @@ class Reader {
      */
     size_t frame() const;
 
-    /** The total number of frames in the current dataset.
+    /** The number of frames in the shard of the current dataset being read.
+     * This is the total number of frames in the dataset unless
+     * se::ReaderConfig::num_shards is greater than 1.
      *
-     * \return The total number of frames. Returns 0 if the number of frames
-     *         is unknown (e.g. for camera input).
+     * \return The number of frames. Returns 0 if the number of frames is
+     *         unknown (e.g. for camera input).
      */
     size_t numFrames() const;
 
-    /** The dimensions of the depth images.
+    /** The number of the first frame of the shard being read.
+     *
+     * \return The number of the first frame.
+     */
+    size_t shardBegin() const;
+
+    /** One past the number of the last frame of the shard being read.
+     *
+     * \return One past the number of the last frame. Returns SIZE_MAX if the
+     *         number of frames is unknown (e.g. for camera input).
+     */
+    size_t shardEnd() const;
+
+    /** The dimensions of the depth images after downsampling.
      *
      * \return A 2D vector containing the width and height of the images.
      */
     Eigen::Vector2i depthImageRes() const;
 
-    /** The dimensions of the colour images.
+    /** The dimensions of the colour images after downsampling.
      *
      * \return A 2D vector containing the width and height of the images.
      */
@@ -325,7 +410,7 @@ class Reader {
     protected:
     std::string sequence_path_;
     std::string ground_truth_file_;
-    std::ifstream ground_truth_fs_;
+    /** The dimensions of the images in the dataset, before downsampling. */
     Eigen::Vector2i depth_image_res_;
     Eigen::Vector2i colour_image_res_;
     Eigen::Vector2i class_id_image_res_;
@@ -335,6 +420,9 @@ class Reader {
     int verbose_;
     bool is_live_reader_;
     ReaderStatus status_;
+    int num_shards_;
+    int shard_;
+    int downsampling_factor_;
     /** The frame_ is initialized to SIZE_MAX, so that when first incremented
      * it becomes 0. Unsigned integer overflow is defined behaviour in C/C++
      * so this is safe to do.
@@ -345,21 +433,14 @@ class Reader {
     bool has_semantics_;
 
 
-    /** Read the ground truth pose at the provided frame number.
-     * Each line in the ground truth file should correspond to a single
-     * depth/colour image pair and have a format<br>
-     * `... tx ty tz qx qy qz qw`,<br>
-     * that is the pose is encoded in the last 7 columns of the line.
-     *
-     * \note Use getPose(...) to request a pose. It keeps track of the ground_truth_frame_
-     *       and ifstream state.
+    /** Append the ground truth pose of the next frame to the in-memory pose
+     * table. Poses with non-finite elements or a non-unit quaternion are
+     * stored as invalid and result in se::ReaderStatus::skip when requested.
      *
-     * \param[out] T_WB      The ground truth pose.
-     * \param[in]  frame     The frame number of the requested ground truth pose.
-     * \param[in]  delimiter The character delimiting columns in the file. Defaults to space.
-     * \return An appropriate status code.
+     * \param[in] position    The position of the body in the world frame.
+     * \param[in] orientation The orientation of the body in the world frame.
      */
-    ReaderStatus readPose(Eigen::Matrix4f& T_WB, const size_t frame, const char delimiter = ' ');
+    void appendPose(const Eigen::Vector3f& position, const Eigen::Quaternionf& orientation);
 
 
     /** Read the next ground truth pose.
@@ -391,8 +472,20 @@ class Reader {
 
 
     private:
-    size_t ground_truth_frame_;
     char ground_truth_delimiter_;
+    /** Whether the pose table has been filled, either by a derived class or by
+     * parsing the ground truth file.
+     */
+    bool poses_loaded_;
+    std::vector<Eigen::Matrix4f, Eigen::aligned_allocator<Eigen::Matrix4f>> poses_;
+    std::vector<bool> pose_valid_;
+    /** The images read at the dataset resolution when downsampling. */
+    Image<float> native_depth_image_;
+    Image<rgb_t> native_colour_image_;
+    /** The intermediate depth images of the successive halvings. */
+    Image<float> half_depth_images_[2];
+    /** The maximum depth difference in metres between averaged pixels when downsampling depth. */
+    static constexpr float downsampling_depth_threshold_ = 0.1f;
     std::chrono::steady_clock::time_point prev_frame_timestamp_;
 
     /** Prepare for reading the next frame.
@@ -403,6 +496,11 @@ class Reader {
      */
     void nextFrame();
 
+    /** Call nextFrame() and then skip to the first frame of the shard being
+     * read if needed.
+     */
+    void nextShardFrame();
+
     /** Read the next depth image.
      *
      * \param[out] depth_image The next depth image.
@@ -410,7 +508,28 @@ class Reader {
      */
     virtual ReaderStatus nextDepth(Image<float>& depth_image) = 0;
 
+    /** Parse the ground truth file into the pose table.
+     *
+     * \return An appropriate status code.
+     */
+    ReaderStatus loadPoses();
+
     ReaderStatus nextData(Image<float>& depth_image, Image<rgb_t>* colour_image, Image<semantics_t>* class_id_image, Eigen::Matrix4f* T_WB);
+
+    ReaderStatus readFrame(const size_t frame, Image<float>& depth_image, Image<rgb_t>* colour_image, Image<semantics_t>* class_id_image, Eigen::Matrix4f* T_WB);
+
+    /** Read the depth image of the current frame, downsampling it if needed.
+     */
+    ReaderStatus readDepth(Image<float>& depth_image);
+
+    /** Read the colour image of the current frame, downsampling it if needed.
+     */
+    ReaderStatus readColour(Image<rgb_t>& colour_image);
+
+    /** Read the data of the current frame without incrementing the frame
+     * number.
+     */
+    ReaderStatus readData(Image<float>& depth_image, Image<rgb_t>* colour_image, Image<semantics_t>* class_id_image, Eigen::Matrix4f* T_WB);
 };
 
 } // namespace se
@@ -0,0 +1,86 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Smart Robotics Lab, Technical University of Munich
+ * SPDX-FileCopyrightText: 2024 Jiaxin Wei
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef __READER_SHM_HPP
+#define __READER_SHM_HPP
+
+
+#include <Eigen/Core>
+#include <cstdint>
+#include <string>
+
+#include "reader_base.hpp"
+#include "se/image/image.hpp"
+#include "shm_frame_ring.h"
+
+
+namespace se {
+
+/** Reader for frames published by a sensor driver in a POSIX shared-memory ring, see
+ * shm_frame_ring.h. The se::ReaderConfig::sequence_path is the name of the shared-memory object,
+ * e.g. `/gsfusion_frames`.
+ *
+ * Frames are read in order. When the reader falls behind the producer, the oldest frames are
+ * overwritten and skipped. Each image is copied once from the ring into the output se::Image. The
+ * output must not alias the ring because the producer may overwrite a slot at any time.
+ */
+class ShmReader : public Reader {
+    public:
+    /** Construct a ShmReader from a ReaderConfig. Wait for the producer to create the ring if it
+     * doesn't exist yet.
+     *
+     * \param[in] c The configuration struct to use.
+     */
+    ShmReader(const ReaderConfig& c);
+
+    ~ShmReader();
+
+
+    /** Restart reading from the oldest frame in the ring. */
+    void restart();
+
+
+    /** The name of the reader.
+     *
+     * \return The string `"ShmReader"`.
+     */
+    std::string name() const;
+
+
+    /** The number of frames overwritten by the producer before they could be read.
+     */
+    size_t numDropped() const;
+
+    EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+
+    private:
+    /** The time to wait for the producer to create the ring. */
+    static constexpr int attach_timeout_ms_ = 10000;
+    /** The time to wait for a frame before checking whether the stream was closed. */
+    static constexpr int frame_timeout_ms_ = 1000;
+
+    gsf_ring_header* ring_;
+    size_t ring_size_;
+    /** The ring frame number read by the next call to nextDepth(). */
+    uint64_t next_frame_;
+    /** The ring frame number of the last depth image read. */
+    uint64_t current_frame_;
+    size_t num_dropped_;
+
+    /** Return the number of the oldest frame in the ring that is safe to read. */
+    uint64_t oldestFrame() const;
+
+    ReaderStatus nextDepth(Image<float>& depth_image);
+
+    ReaderStatus nextColour(Image<rgb_t>& colour_image);
+
+    ReaderStatus nextPose(Eigen::Matrix4f& T_WB);
+};
+
+} // namespace se
+
+
+#endif
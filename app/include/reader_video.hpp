@@ -0,0 +1,108 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Smart Robotics Lab, Technical University of Munich
+ * SPDX-FileCopyrightText: 2024 Jiaxin Wei
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef __READER_VIDEO_HPP
+#define __READER_VIDEO_HPP
+
+
+#include <Eigen/Core>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "reader_base.hpp"
+#include "se/image/image.hpp"
+
+
+namespace se {
+
+/** Reader for sequences stored as streams instead of one image file per frame. The
+ * se::ReaderConfig::sequence_path must be a directory containing:
+ * - `depth.bin`: a 16-byte header with the magic `GSD1` followed by the little-endian uint32
+ *   width, height and a reserved 0, then the depth frames as packed little-endian uint16
+ *   row-major images.
+ * - Optionally `rgb.mkv`, `rgb.mp4` or `rgb.avi`: the colour frames in any video container and
+ *   codec OpenCV can decode.
+ *
+ * Frame i of both streams corresponds to line i of the ground truth file. Both streams are
+ * decoded sequentially on a dedicated thread a few frames ahead of the pipeline.
+ */
+class VideoReader : public Reader {
+    public:
+    /** Construct a VideoReader from a ReaderConfig.
+     *
+     * \param[in] c The configuration struct to use.
+     */
+    VideoReader(const ReaderConfig& c);
+
+    ~VideoReader();
+
+
+    /** Restart reading from the beginning. */
+    void restart();
+
+
+    /** The name of the reader.
+     *
+     * \return The string `"VideoReader"`.
+     */
+    std::string name() const;
+
+    EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+
+    private:
+    static constexpr float video_inverse_scale_ = 1.0f / 1000.0f;
+    static constexpr char depth_magic_[4] = {'G', 'S', 'D', '1'};
+    static constexpr size_t depth_header_size_ = 16;
+    /** The maximum number of frames decoded ahead of the pipeline. */
+    static constexpr size_t queue_capacity_ = 4;
+
+    struct DecodedFrame {
+        size_t frame;
+        bool valid;
+        Image<float> depth;
+        Image<rgb_t> colour;
+    };
+
+    float inverse_scale_;
+    std::string depth_filename_;
+    std::string colour_filename_;
+
+    std::thread decoder_;
+    std::mutex mutex_;
+    /** Notified when a frame is decoded. */
+    std::condition_variable decoded_cv_;
+    /** Notified when a frame is taken from the queue or the decoder must stop. */
+    std::condition_variable space_cv_;
+    bool stop_decoder_;
+    std::deque<DecodedFrame> decoded_frames_;
+    /** Frames whose images are reused by the decoder. */
+    std::vector<DecodedFrame> free_frames_;
+    /** The number of the frame the next decoded frame will have. */
+    size_t next_decoded_frame_;
+    /** The frame returned by the last call to nextDepth(), holding its colour image. */
+    DecodedFrame current_frame_;
+
+    /** Start decoding both streams sequentially from \p start_frame. */
+    void startDecoder(const size_t start_frame);
+
+    void stopDecoder();
+
+    void decode(const size_t start_frame);
+
+    ReaderStatus nextDepth(Image<float>& depth_image);
+
+    ReaderStatus nextColour(Image<rgb_t>& colour_image);
+};
+
+} // namespace se
+
+
+#endif
@@ -0,0 +1,239 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Smart Robotics Lab, Technical University of Munich
+ * SPDX-FileCopyrightText: 2024 Jiaxin Wei
+ * SPDX-License-Identifier: MIT
+ */
+
+/* Shared-memory frame ring between sensor drivers and se::ShmReader.
+ *
+ * A producer creates the ring with gsf_ring_create(), writes frames with gsf_ring_publish() and
+ * ends the stream with gsf_ring_close(). The ring holds the latest num_slots frames. The producer
+ * never blocks; when the consumer falls behind, the oldest frames are overwritten. Each slot
+ * carries a sequence lock so that consumers detect slots overwritten while they were being read.
+ * Consumers sleep in gsf_ring_wait() on a futex that is incremented on every publish.
+ *
+ * Depth is stored as float metres and colour as packed 8-bit RGB. Only libc is needed and the
+ * header compiles as both C99 and C++.
+ */
+
+#ifndef GSF_SHM_FRAME_RING_H
+#define GSF_SHM_FRAME_RING_H
+
+#include <fcntl.h>
+#include <limits.h>
+#include <linux/futex.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define GSF_RING_MAGIC 0x52465347u /* "GSFR" */
+#define GSF_RING_VERSION 1u
+
+/* Bits of gsf_ring_slot::flags. */
+#define GSF_FRAME_HAS_COLOUR 0x1u
+#define GSF_FRAME_HAS_POSE 0x2u
+
+typedef struct gsf_ring_header {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t num_slots;
+    uint32_t depth_width;
+    uint32_t depth_height;
+    /* 0 if the producer has no colour camera. */
+    uint32_t colour_width;
+    uint32_t colour_height;
+    /* Set to 1 by gsf_ring_close() at the end of the stream. */
+    uint32_t closed;
+    /* The bytes between consecutive slots, a multiple of 64. */
+    uint64_t slot_size;
+    /* The number of frames published so far. Frame n is stored in slot n % num_slots. */
+    uint64_t write_count;
+    /* Futex word incremented on every publish and on close. */
+    uint32_t wake;
+    uint32_t padding[3];
+} gsf_ring_header;
+
+typedef struct gsf_ring_slot {
+    /* 2 * frame + 1 while frame is being written, 2 * frame + 2 once it is complete. */
+    uint64_t seq;
+    uint64_t frame;
+    /* The capture time in seconds. */
+    double timestamp;
+    uint32_t flags;
+    /* The column-major body to world transformation, valid if GSF_FRAME_HAS_POSE is set. */
+    float T_WB[16];
+    uint32_t padding[9];
+    /* Followed by depth_width * depth_height floats and colour_width * colour_height * 3 bytes. */
+} gsf_ring_slot;
+
+
+static inline uint64_t gsf_ring_slot_size(uint32_t depth_width, uint32_t depth_height, uint32_t colour_width, uint32_t colour_height)
+{
+    const uint64_t size = sizeof(gsf_ring_slot) + (uint64_t) depth_width * depth_height * sizeof(float) + (uint64_t) colour_width * colour_height * 3;
+    return (size + 63) & ~(uint64_t) 63;
+}
+
+
+static inline uint64_t gsf_ring_size(const gsf_ring_header* ring)
+{
+    return sizeof(gsf_ring_header) + ring->num_slots * ring->slot_size;
+}
+
+
+static inline gsf_ring_slot* gsf_ring_slot_at(gsf_ring_header* ring, uint64_t frame)
+{
+    return (gsf_ring_slot*) ((char*) ring + sizeof(gsf_ring_header) + (frame % ring->num_slots) * ring->slot_size);
+}
+
+
+static inline float* gsf_slot_depth(gsf_ring_slot* slot)
+{
+    return (float*) (slot + 1);
+}
+
+
+static inline uint8_t* gsf_slot_colour(const gsf_ring_header* ring, gsf_ring_slot* slot)
+{
+    return (uint8_t*) (gsf_slot_depth(slot) + (uint64_t) ring->depth_width * ring->depth_height);
+}
+
+
+/* Return whether frame is still stored intact in its slot. Call after reading the slot data. */
+static inline int gsf_slot_valid(gsf_ring_slot* slot, uint64_t frame)
+{
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    return __atomic_load_n(&slot->seq, __ATOMIC_RELAXED) == 2 * frame + 2;
+}
+
+
+/* Create the shared-memory object name, e.g. "/gsfusion_frames", and map it. Return NULL on
+ * error. num_slots must be at least 2 and colour_width/colour_height 0 if there is no colour.
+ *
+ * An existing object of the right size, e.g. left by a producer that crashed, is reused without
+ * truncating it. An existing object of another size is unlinked and replaced, since shrinking it
+ * would raise SIGBUS in consumers still mapping it.
+ */
+static inline gsf_ring_header*
+gsf_ring_create(const char* name, uint32_t num_slots, uint32_t depth_width, uint32_t depth_height, uint32_t colour_width, uint32_t colour_height)
+{
+    if (num_slots < 2) {
+        return NULL;
+    }
+    gsf_ring_header header;
+    memset(&header, 0, sizeof(header));
+    header.num_slots = num_slots;
+    header.depth_width = depth_width;
+    header.depth_height = depth_height;
+    header.colour_width = colour_width;
+    header.colour_height = colour_height;
+    header.slot_size = gsf_ring_slot_size(depth_width, depth_height, colour_width, colour_height);
+    const uint64_t size = gsf_ring_size(&header);
+    int fd = shm_open(name, O_CREAT | O_RDWR, 0600);
+    if (fd < 0) {
+        return NULL;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        return NULL;
+    }
+    if (st.st_size != 0 && (uint64_t) st.st_size != size) {
+        close(fd);
+        shm_unlink(name);
+        fd = shm_open(name, O_CREAT | O_EXCL | O_RDWR, 0600);
+        if (fd < 0) {
+            return NULL;
+        }
+        st.st_size = 0;
+    }
+    if ((uint64_t) st.st_size != size && ftruncate(fd, size) != 0) {
+        close(fd);
+        shm_unlink(name);
+        return NULL;
+    }
+    void* data = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        shm_unlink(name);
+        return NULL;
+    }
+    gsf_ring_header* ring = (gsf_ring_header*) data;
+    memcpy(ring, &header, sizeof(header));
+    /* Consumers only attach once the magic is visible. */
+    __atomic_store_n(&ring->version, GSF_RING_VERSION, __ATOMIC_RELAXED);
+    __atomic_store_n(&ring->magic, GSF_RING_MAGIC, __ATOMIC_RELEASE);
+    return ring;
+}
+
+
+static inline void gsf_ring_wake(gsf_ring_header* ring)
+{
+    __atomic_add_fetch(&ring->wake, 1, __ATOMIC_RELEASE);
+    syscall(SYS_futex, &ring->wake, FUTEX_WAKE, INT_MAX, NULL, NULL, 0);
+}
+
+
+/* Publish a frame, overwriting the oldest one. colour and T_WB may be NULL. There must be a single
+ * producer per ring.
+ */
+static inline void gsf_ring_publish(gsf_ring_header* ring, const float* depth, const uint8_t* colour, const float* T_WB, double timestamp)
+{
+    const uint64_t frame = __atomic_load_n(&ring->write_count, __ATOMIC_RELAXED);
+    gsf_ring_slot* slot = gsf_ring_slot_at(ring, frame);
+    __atomic_store_n(&slot->seq, 2 * frame + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    slot->frame = frame;
+    slot->timestamp = timestamp;
+    slot->flags = 0;
+    memcpy(gsf_slot_depth(slot), depth, (uint64_t) ring->depth_width * ring->depth_height * sizeof(float));
+    if (colour && ring->colour_width > 0) {
+        memcpy(gsf_slot_colour(ring, slot), colour, (uint64_t) ring->colour_width * ring->colour_height * 3);
+        slot->flags |= GSF_FRAME_HAS_COLOUR;
+    }
+    if (T_WB) {
+        memcpy(slot->T_WB, T_WB, sizeof(slot->T_WB));
+        slot->flags |= GSF_FRAME_HAS_POSE;
+    }
+    __atomic_store_n(&slot->seq, 2 * frame + 2, __ATOMIC_RELEASE);
+    __atomic_store_n(&ring->write_count, frame + 1, __ATOMIC_RELEASE);
+    gsf_ring_wake(ring);
+}
+
+
+/* Mark the end of the stream, unmap the ring and remove its name. Attached consumers read the
+ * remaining frames and then stop.
+ */
+static inline void gsf_ring_close(gsf_ring_header* ring, const char* name)
+{
+    __atomic_store_n(&ring->closed, 1, __ATOMIC_RELEASE);
+    gsf_ring_wake(ring);
+    munmap(ring, gsf_ring_size(ring));
+    shm_unlink(name);
+}
+
+
+/* Sleep until the futex word differs from wake_value or timeout_ms elapses. Load wake_value before
+ * checking ring->write_count to avoid missing a wake-up.
+ */
+static inline void gsf_ring_wait(gsf_ring_header* ring, uint32_t wake_value, int timeout_ms)
+{
+    struct timespec timeout;
+    timeout.tv_sec = timeout_ms / 1000;
+    timeout.tv_nsec = (long) (timeout_ms % 1000) * 1000000;
+    syscall(SYS_futex, &ring->wake, FUTEX_WAIT, wake_value, &timeout, NULL, 0);
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* GSF_SHM_FRAME_RING_H */
@@ -0,0 +1,257 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Smart Robotics Lab, Technical University of Munich
+ * SPDX-FileCopyrightText: 2024 Jiaxin Wei
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include <algorithm>
+#include <cstdlib>
+#include <fcntl.h>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <map>
+#include <sched.h>
+#include <sstream>
+#include <string>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <vector>
+
+#include "config.hpp"
+#include "reader_base.hpp"
+#include "se/common/filesystem.hpp"
+#include "se/common/perfstats.hpp"
+
+
+struct Run {
+    std::string config_file;
+    se::AppConfig app;
+    se::ReaderConfig reader;
+    std::string log_file;
+    int exit_status = -1;
+    double start_time = 0.0;
+    double end_time = 0.0;
+};
+
+
+void printUsage(const char* name)
+{
+    std::cerr << "Usage: " << name << " [-j RUNS] [-e GSFUSION] [-o OUTPUT_DIR] YAML_FILE...\n"
+              << "  -j RUNS        The number of concurrent runs, the CPU cores are split evenly between them (default 1)\n"
+              << "  -e GSFUSION    The gsfusion executable (default: next to this executable)\n"
+              << "  -o OUTPUT_DIR  The directory for the run logs and summary (default: batch)\n";
+}
+
+
+/** Read all files of a sequence once and advise the kernel to keep them cached. Runs of the same
+ * sequence are scheduled together so that they share the cached files instead of each reading
+ * them from disk.
+ */
+void warmSequence(const std::string& sequence_path)
+{
+    std::error_code ec;
+    const stdfs::path path(sequence_path);
+    std::vector<stdfs::path> files;
+    if (stdfs::is_directory(path, ec)) {
+        for (auto it = stdfs::recursive_directory_iterator(path, ec); !ec && it != stdfs::recursive_directory_iterator(); it.increment(ec)) {
+            if (it->is_regular_file(ec)) {
+                files.push_back(it->path());
+            }
+        }
+    }
+    else if (stdfs::is_regular_file(path, ec)) {
+        files.push_back(path);
+    }
+    for (const auto& file : files) {
+        const int fd = open(file.c_str(), O_RDONLY);
+        if (fd >= 0) {
+            posix_fadvise(fd, 0, 0, POSIX_FADV_WILLNEED);
+            close(fd);
+        }
+    }
+}
+
+
+/** Parse the "key: value unit" lines of the stats file written by gsfusion. */
+std::map<std::string, std::string> readStats(const std::string& filename)
+{
+    std::map<std::string, std::string> stats;
+    std::ifstream file(filename);
+    std::string line;
+    while (std::getline(file, line)) {
+        const size_t colon = line.find(':');
+        if (colon == std::string::npos) {
+            continue;
+        }
+        std::istringstream value_ss(line.substr(colon + 1));
+        std::string value;
+        value_ss >> value;
+        stats[line.substr(0, colon)] = value;
+    }
+    return stats;
+}
+
+
+/** Return the number of frames logged to a PerfStats log, i.e. the lines after the header. */
+size_t countLoggedFrames(const std::string& filename)
+{
+    std::ifstream file(filename);
+    const size_t num_lines = std::count(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>(), '\n');
+    return num_lines > 0 ? num_lines - 1 : 0;
+}
+
+
+int main(int argc, char** argv)
+{
+    int num_slots = 1;
+    std::string exe = (stdfs::path(argv[0]).parent_path() / "gsfusion").string();
+    std::string output_dir = "batch";
+    int opt;
+    while ((opt = getopt(argc, argv, "j:e:o:h")) != -1) {
+        switch (opt) {
+        case 'j':
+            num_slots = std::max(std::atoi(optarg), 1);
+            break;
+        case 'e':
+            exe = optarg;
+            break;
+        case 'o':
+            output_dir = optarg;
+            break;
+        default:
+            printUsage(argv[0]);
+            return 2;
+        }
+    }
+    if (optind >= argc) {
+        printUsage(argv[0]);
+        return 2;
+    }
+
+    std::vector<Run> runs;
+    for (int i = optind; i < argc; i++) {
+        Run run;
+        run.config_file = argv[i];
+        run.app.readYaml(run.config_file);
+        run.reader.readYaml(run.config_file);
+        runs.push_back(run);
+    }
+    // Group the runs of the same sequence so they execute concurrently and share the page cache.
+    std::stable_sort(runs.begin(), runs.end(), [](const Run& a, const Run& b) { return a.reader.sequence_path < b.reader.sequence_path; });
+    stdfs::create_directories(output_dir);
+
+    // Split the CPU cores available to this process evenly between the concurrent runs.
+    cpu_set_t available_cpus;
+    CPU_ZERO(&available_cpus);
+    sched_getaffinity(0, sizeof(available_cpus), &available_cpus);
+    std::vector<int> cpus;
+    for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+        if (CPU_ISSET(cpu, &available_cpus)) {
+            cpus.push_back(cpu);
+        }
+    }
+    num_slots = std::min({num_slots, static_cast<int>(runs.size()), static_cast<int>(cpus.size())});
+    const int cpus_per_slot = cpus.size() / num_slots;
+    std::cout << "Running " << runs.size() << " configurations, " << num_slots << " at a time with " << cpus_per_slot << " cores each\n";
+
+    std::vector<pid_t> slot_pids(num_slots, 0);
+    std::map<pid_t, size_t> pid_runs;
+    std::string warm_sequence;
+    size_t next_run = 0;
+    size_t num_running = 0;
+    const double batch_start_time = PerfStats::getTime();
+    while (next_run < runs.size() || num_running > 0) {
+        // Start runs in all free slots.
+        for (int slot = 0; slot < num_slots && next_run < runs.size(); slot++) {
+            if (slot_pids[slot] != 0) {
+                continue;
+            }
+            Run& run = runs[next_run];
+            if (run.reader.sequence_path != warm_sequence) {
+                warm_sequence = run.reader.sequence_path;
+                warmSequence(warm_sequence);
+            }
+            run.log_file = output_dir + "/run_" + std::to_string(next_run) + ".log";
+            run.start_time = PerfStats::getTime();
+
+            const pid_t pid = fork();
+            if (pid == 0) {
+                cpu_set_t slot_cpus;
+                CPU_ZERO(&slot_cpus);
+                for (int i = slot * cpus_per_slot; i < (slot + 1) * cpus_per_slot; i++) {
+                    CPU_SET(cpus[i], &slot_cpus);
+                }
+                sched_setaffinity(0, sizeof(slot_cpus), &slot_cpus);
+                // OpenMP (also used by libtorch on the CPU) sizes its thread pool from these and TBB
+                // from the affinity mask.
+                setenv("OMP_NUM_THREADS", std::to_string(cpus_per_slot).c_str(), 1);
+                setenv("OMP_PROC_BIND", "close", 1);
+                const int log_fd = open(run.log_file.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+                if (log_fd >= 0) {
+                    dup2(log_fd, STDOUT_FILENO);
+                    dup2(log_fd, STDERR_FILENO);
+                    close(log_fd);
+                }
+                execl(exe.c_str(), exe.c_str(), run.config_file.c_str(), static_cast<char*>(nullptr));
+                std::cerr << "Error: could not execute " << exe << "\n";
+                _exit(127);
+            }
+            else if (pid < 0) {
+                std::cerr << "Error: could not start run for " << run.config_file << "\n";
+                run.exit_status = -1;
+            }
+            else {
+                slot_pids[slot] = pid;
+                pid_runs[pid] = next_run;
+                num_running++;
+                std::cout << "Started " << run.config_file << " on cores " << cpus[slot * cpus_per_slot] << "-" << cpus[(slot + 1) * cpus_per_slot - 1] << "\n";
+            }
+            next_run++;
+        }
+        if (num_running == 0) {
+            continue;
+        }
+
+        // Wait for any run to finish and free its slot.
+        int status;
+        const pid_t pid = wait(&status);
+        if (pid <= 0) {
+            continue;
+        }
+        const auto it = pid_runs.find(pid);
+        if (it == pid_runs.end()) {
+            continue;
+        }
+        Run& run = runs[it->second];
+        run.end_time = PerfStats::getTime();
+        run.exit_status = WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+        std::replace(slot_pids.begin(), slot_pids.end(), pid, pid_t(0));
+        pid_runs.erase(it);
+        num_running--;
+        std::cout << "Finished " << run.config_file << " with status " << run.exit_status << " in " << run.end_time - run.start_time << " s\n";
+    }
+    const double batch_time = PerfStats::getTime() - batch_start_time;
+
+    // Collect the stats of all runs into a single summary.
+    const std::string summary_file = output_dir + "/summary.tsv";
+    std::ofstream summary(summary_file);
+    summary << "config\tstatus\twall time (s)\tframes\tavg. fps (Hz)\tglobal opt. time (s)\tGPU memory (MB)\tkeyframes\n";
+    size_t total_frames = 0;
+    int num_failed = 0;
+    for (const auto& run : runs) {
+        std::map<std::string, std::string> stats = readStats((stdfs::path(run.app.ply_path).parent_path() / "stats").string());
+        const size_t num_frames = run.app.log_file.empty() ? 0 : countLoggedFrames(run.app.log_file);
+        total_frames += num_frames;
+        num_failed += run.exit_status != 0;
+        summary << run.config_file << "\t" << run.exit_status << "\t" << run.end_time - run.start_time << "\t" << num_frames << "\t" << stats["Avg. fps"] << "\t"
+                << stats["Global opt. time"] << "\t" << stats["GPU memory usage"] << "\t" << stats["#Keyframes"] << "\n";
+    }
+    summary.close();
+
+    std::cout << "Batch time: " << batch_time << " s\n";
+    std::cout << "Aggregate throughput: " << total_frames / batch_time << " frames/s\n";
+    std::cout << "Failed runs: " << num_failed << "/" << runs.size() << "\n";
+    std::cout << "Summary written to " << summary_file << "\n";
+    return num_failed == 0 ? 0 : 1;
+}
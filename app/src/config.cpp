@@ -53,10 +53,21 @@ void AppConfig::readYaml(const std::string& filename)
     se::yaml::subnode_as_string(node, "optim_params_path", optim_params_path);
     se::yaml::subnode_as_string(node, "ply_path", ply_path);
     se::yaml::subnode_as_string(node, "mesh_path", mesh_path);
+    se::yaml::subnode_as_string(node, "render_path", render_path);
     se::yaml::subnode_as_string(node, "slice_path", slice_path);
     se::yaml::subnode_as_string(node, "structure_path", structure_path);
+    se::yaml::subnode_as_string(node, "tile_path", tile_path);
+    se::yaml::subnode_as_string(node, "change_feed_path", change_feed_path);
+    se::yaml::subnode_as_string(node, "finalised_mesh_path", finalised_mesh_path);
+    se::yaml::subnode_as_string(node, "metrics_endpoint", metrics_endpoint);
+    se::yaml::subnode_as_bool(node, "enable_gui", enable_gui);
+    se::yaml::subnode_as_bool(node, "enable_depth_filter", enable_depth_filter);
+    se::yaml::subnode_as_float(node, "depth_filter_max_jump", depth_filter_max_jump);
     se::yaml::subnode_as_int(node, "integration_rate", integration_rate);
+    se::yaml::subnode_as_int(node, "integration_batch_size", integration_batch_size);
     se::yaml::subnode_as_int(node, "rendering_rate", rendering_rate);
+    se::yaml::subnode_as_int(node, "raycast_subsampling_factor", raycast_subsampling_factor);
+    se::yaml::subnode_as_bool(node, "enable_raycast_reprojection", enable_raycast_reprojection);
     se::yaml::subnode_as_int(node, "meshing_rate", meshing_rate);
     se::yaml::subnode_as_int(node, "max_frames", max_frames);
     se::yaml::subnode_as_string(node, "log_file", log_file);
@@ -65,8 +76,12 @@ void AppConfig::readYaml(const std::string& filename)
     optim_params_path = process_path(optim_params_path, dataset_dir);
     ply_path = process_path(ply_path, dataset_dir);
     mesh_path = process_path(mesh_path, dataset_dir);
+    render_path = process_path(render_path, dataset_dir);
     slice_path = process_path(slice_path, dataset_dir);
     structure_path = process_path(structure_path, dataset_dir);
+    tile_path = process_path(tile_path, dataset_dir);
+    change_feed_path = process_path(change_feed_path, dataset_dir);
+    finalised_mesh_path = process_path(finalised_mesh_path, dataset_dir);
     log_file = process_path(log_file, dataset_dir);
 }
 
@@ -75,10 +90,21 @@ std::ostream& operator<<(std::ostream& os, const AppConfig& c)
 {
     os << str_utils::bool_to_pretty_str(c.enable_ground_truth, "enable_ground_truth") << "\n";
     os << str_utils::str_to_pretty_str(c.mesh_path, "mesh_path") << "\n";
+    os << str_utils::str_to_pretty_str(c.render_path, "render_path") << "\n";
     os << str_utils::str_to_pretty_str(c.slice_path, "slice_path") << "\n";
     os << str_utils::str_to_pretty_str(c.structure_path, "structure_path") << "\n";
+    os << str_utils::str_to_pretty_str(c.tile_path, "tile_path") << "\n";
+    os << str_utils::str_to_pretty_str(c.change_feed_path, "change_feed_path") << "\n";
+    os << str_utils::str_to_pretty_str(c.finalised_mesh_path, "finalised_mesh_path") << "\n";
+    os << str_utils::str_to_pretty_str(c.metrics_endpoint, "metrics_endpoint") << "\n";
+    os << str_utils::bool_to_pretty_str(c.enable_gui, "enable_gui") << "\n";
+    os << str_utils::bool_to_pretty_str(c.enable_depth_filter, "enable_depth_filter") << "\n";
+    os << str_utils::value_to_pretty_str(c.depth_filter_max_jump, "depth_filter_max_jump") << "\n";
     os << str_utils::value_to_pretty_str(c.integration_rate, "integration_rate") << "\n";
+    os << str_utils::value_to_pretty_str(c.integration_batch_size, "integration_batch_size") << "\n";
     os << str_utils::value_to_pretty_str(c.rendering_rate, "rendering_rate") << "\n";
+    os << str_utils::value_to_pretty_str(c.raycast_subsampling_factor, "raycast_subsampling_factor") << "\n";
+    os << str_utils::bool_to_pretty_str(c.enable_raycast_reprojection, "enable_raycast_reprojection") << "\n";
     os << str_utils::value_to_pretty_str(c.meshing_rate, "meshing_rate") << "\n";
     os << str_utils::value_to_pretty_str(c.max_frames, "max_frames") << "\n";
     os << str_utils::str_to_pretty_str(c.log_file, "log_file") << "\n";
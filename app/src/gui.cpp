@@ -7,6 +7,7 @@
 #include "gui.hpp"
 
 #include <Eigen/Core>
+#include <chrono>
 #include <open3d/visualization/rendering/ColorGrading.h>
 #include <opencv2/imgproc.hpp>
 #include <sstream>
@@ -78,10 +79,11 @@ void GUI::initWidget()
 void GUI::updateScene()
 {
     while (!stop_signal_.load()) {
-        if (data_queue_.getSize() == 0) {
+        // Wake up periodically to check the stop signal
+        gs::DataPacket data_packet;
+        if (!data_mailbox_.pop(data_packet, std::chrono::milliseconds(100))) {
             continue;
         }
-        gs::DataPacket data_packet = data_queue_.pop();
 
         auto vis_rgb = std::make_shared<open3d::geometry::Image>();
         auto vis_depth = std::make_shared<open3d::geometry::Image>();
@@ -113,7 +115,7 @@ void GUI::updateScene()
         gs_info_->SetText(gs_text.str().c_str());
         img_info_->SetText(img_text.str().c_str());
 
-        open3d::visualization::gui::Application::GetInstance().PostToMainThread(window_.get(), [this, &vis_rgb, &vis_depth, &vis_rendered_rgb]() {
+        open3d::visualization::gui::Application::GetInstance().PostToMainThread(window_.get(), [this, vis_rgb, vis_depth, vis_rendered_rgb]() {
             this->rgb_widget_->UpdateImage(vis_rgb);
             this->depth_widget_->UpdateImage(vis_depth);
             this->gs_widget_->UpdateImage(vis_rendered_rgb);
@@ -7,6 +7,9 @@
  * SPDX-License-Identifier: BSD-3-Clause
  */
 
+#include <algorithm>
+#include <memory>
+#include <opencv2/imgcodecs.hpp>
 #include <opencv2/imgproc.hpp>
 #include <se/supereight.hpp>
 #include <thread>
@@ -14,11 +17,14 @@
 
 #include "config.hpp"
 #include "gui.hpp"
+#include "metrics_exporter.hpp"
 #include "gs/gaussian.cuh"
 #include "gs/gaussian_utils.cuh"
 #include "reader.hpp"
 #include "se/common/filesystem.hpp"
 #include "se/common/system_utils.hpp"
+#include "se/common/work_counters.hpp"
+#include "se/map/preprocessor.hpp"
 
 
 #define PBSTR "||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||"
@@ -51,16 +57,42 @@ int main(int argc, char** argv)
         const std::string config_filename = argv[1];
         const se::Config<se::TSDFColDataConfig, se::PinholeCameraConfig> config(config_filename);
 
+        // These outputs are written from a single map, reject them instead of covering only part of
+        // the submaps
+        if (config.map.useSubmaps()) {
+            const std::vector<std::pair<std::string, std::string>> single_map_outputs = {{"render_path", config.app.render_path},
+                                                                                         {"slice_path", config.app.slice_path},
+                                                                                         {"structure_path", config.app.structure_path},
+                                                                                         {"tile_path", config.app.tile_path},
+                                                                                         {"change_feed_path", config.app.change_feed_path},
+                                                                                         {"finalised_mesh_path", config.app.finalised_mesh_path}};
+            for (const auto& [name, path] : single_map_outputs) {
+                if (!path.empty()) {
+                    std::cerr << "Error: app." << name << " isn't supported in submap mode, set it to \"\" or set map.submap_frames and map.submap_distance to 0\n";
+                    return EXIT_FAILURE;
+                }
+            }
+        }
+
         // Create the mesh output directory
         if (!config.app.mesh_path.empty()) {
             stdfs::create_directories(config.app.mesh_path);
         }
+        if (!config.app.render_path.empty()) {
+            stdfs::create_directories(config.app.render_path);
+        }
         if (!config.app.slice_path.empty()) {
             stdfs::create_directories(config.app.slice_path);
         }
         if (!config.app.structure_path.empty()) {
             stdfs::create_directories(config.app.structure_path);
         }
+        if (!config.app.change_feed_path.empty()) {
+            stdfs::create_directories(config.app.change_feed_path);
+        }
+        if (!config.app.finalised_mesh_path.empty()) {
+            stdfs::create_directories(config.app.finalised_mesh_path);
+        }
 
         // Setup log stream
         std::ofstream log_file_stream;
@@ -71,14 +103,61 @@ int main(int argc, char** argv)
         const Eigen::Vector2i input_img_res(config.sensor.width, config.sensor.height);
         se::Image<float> input_depth_img(input_img_res.x(), input_img_res.y());
         se::Image<se::rgb_t> input_colour_img(input_img_res.x(), input_img_res.y(), {0, 0, 0});
+        se::Image<float> depth_filter_scratch_img(input_img_res.x(), input_img_res.y());
+
+        // Setup the images the TSDF is raycast and rendered into
+        se::Image<Eigen::Vector3f> render_point_cloud_W(input_img_res.x(), input_img_res.y());
+        se::Image<Eigen::Vector3f> render_normals_W(input_img_res.x(), input_img_res.y());
+        se::Image<int8_t> render_scale(input_img_res.x(), input_img_res.y());
+        se::Image<se::rgb_t> render_colour(input_img_res.x(), input_img_res.y());
+        se::Image<uint32_t> render_RGBA_img(input_img_res.x(), input_img_res.y());
+        // The surface of the previous render, used as the prediction when reprojecting
+        se::Image<Eigen::Vector3f> prev_render_point_cloud_W(input_img_res.x(), input_img_res.y());
+        bool has_prev_render = false;
 
         // ========= Map INITIALIZATION  =========
-        // Setup the single-res TSDF map w/ default block size of 8 voxels
-        se::TSDFColMap<se::Res::Single> map(config.map, config.data);
+        // Setup the single-res TSDF map w/ default block size of 8 voxels, or in submap mode the
+        // collection whose active submap frames are integrated into. Only one of them is allocated.
+        std::unique_ptr<se::TSDFColMap<se::Res::Single>> map;
+        std::unique_ptr<se::SubmapCollection<se::TSDFColMap<se::Res::Single>>> submaps;
+        // Bounds the allocated part of the single map to MapConfig::active_radius around the sensor
+        std::unique_ptr<se::ActiveWindow<se::TSDFColMap<se::Res::Single>>> active_window;
+        if (config.map.useSubmaps()) {
+            submaps = std::make_unique<se::SubmapCollection<se::TSDFColMap<se::Res::Single>>>(config.map, config.data);
+        }
+        else {
+            map = std::make_unique<se::TSDFColMap<se::Res::Single>>(config.map, config.data);
+            active_window = std::make_unique<se::ActiveWindow<se::TSDFColMap<se::Res::Single>>>(*map, config.map.compress_inactive);
+        }
+        se::io::TiledMeshWriter<se::TSDFColMap<se::Res::Single>> tiled_mesh_writer(config.app.tile_path);
+        se::io::ChangeFeed<se::TSDFColMap<se::Res::Single>> change_feed;
+        // Blocks discarded by the active window come back unobserved, don't seed Gaussians there again
+        se::SeededRegion seeded_region;
+        if (active_window) {
+            seeded_region = [&active_window, &map](const Eigen::Vector3f& point_W) { return active_window->discarded(*map, point_W); };
+        }
 
         // ========= Sensor INITIALIZATION  =========
         // Create a pinhole camera
         const se::PinholeCamera sensor(config.sensor);
+        // Caches the images derived from each frame and keeps their buffers between frames
+        se::FrameContext frame_ctx(sensor);
+
+        // Frames buffered for batched integration, each slot keeps a copy of the images since the
+        // reader reuses its buffers
+        const size_t batch_size = std::max(config.app.integration_batch_size, 1);
+        std::vector<se::Image<float>> batch_depth_imgs;
+        std::vector<se::Image<se::rgb_t>> batch_colour_imgs;
+        std::vector<std::unique_ptr<se::FrameContext<se::PinholeCamera>>> batch_frame_ctxs;
+        if (batch_size > 1) {
+            batch_depth_imgs.resize(batch_size, input_depth_img);
+            batch_colour_imgs.resize(batch_size, input_colour_img);
+            for (size_t i = 0; i < batch_size; i++) {
+                batch_frame_ctxs.emplace_back(new se::FrameContext<se::PinholeCamera>(sensor));
+            }
+        }
+        std::vector<se::RigView<se::PinholeCamera>, Eigen::aligned_allocator<se::RigView<se::PinholeCamera>>> batch_views;
+        std::vector<unsigned int> batch_frames;
 
         // ========= Gaussian Model INITIALIZATION  =========
         auto optimParams = gs::param::read_optim_params_from_json(config.app.optim_params_path);
@@ -106,7 +185,7 @@ int main(int argc, char** argv)
            << "images="
            << "\"" << image_folder_name << "\", "
            << "model_path=" << stdfs::path(config.app.ply_path).parent_path() << ", "
-           << "resolution=-1, "
+           << "resolution=" << (config.reader.downsampling_factor > 1 ? config.reader.downsampling_factor : -1) << ", "
            << "sh_degree=" << gs_model.optimParams.sh_degree << ", "
            << "source_path="
            << "\"" << config.reader.sequence_path << "\", "
@@ -114,10 +193,21 @@ int main(int argc, char** argv)
         fs.close();
 
         // ========= GUI INITIALIZATION  =========
-        gs::DataQueue data_queue;
+        // In headless mode the mailbox is disabled so no visualization data is prepared
+        gs::DataMailbox data_mailbox(config.app.enable_gui);
         std::atomic<bool> stop_signal(false);
-        GUI gs_gui(data_queue, stop_signal, input_img_res.x(), input_img_res.y());
-        std::thread gui_thread([&]() { gs_gui.run(); });
+        std::unique_ptr<GUI> gs_gui;
+        std::thread gui_thread;
+        if (config.app.enable_gui) {
+            gs_gui = std::make_unique<GUI>(data_mailbox, stop_signal, input_img_res.x(), input_img_res.y());
+            gui_thread = std::thread([&]() { gs_gui->run(); });
+        }
+
+        // ========= METRICS INITIALIZATION  =========
+        std::unique_ptr<se::MetricsExporter> metrics_exporter;
+        if (!config.app.metrics_endpoint.empty()) {
+            metrics_exporter = std::make_unique<se::MetricsExporter>(config.app.metrics_endpoint);
+        }
 
         // ========= READER INITIALIZATION  =========
         se::Reader* reader = nullptr;
@@ -132,7 +222,33 @@ int main(int argc, char** argv)
         Eigen::Matrix4f T_WS = T_WB * T_BS;                 //< Sensor to world transformation
 
         // ========= Integrator INITIALIZATION  =========
+        // Integrate the frames buffered for batched integration and empty the batch
+        const auto integrate_batch = [&]() {
+            if (submaps) {
+                se::integrator::integrate(*submaps, gs_model, gs_cam_list, gt_img_list, data_mailbox, batch_views, batch_frames);
+            }
+            else {
+                se::integrator::integrate(*map, gs_model, gs_cam_list, gt_img_list, data_mailbox, batch_views, batch_frames, seeded_region);
+            }
+            batch_views.clear();
+            batch_frames.clear();
+        };
+
         int frame = 0;
+        // Move the active region to the current sensor position and save the finalised mesh
+        const auto update_active_window = [&]() {
+            se::TSDFColMap<se::Res::Single>::OctreeType::MeshType finalised_mesh;
+            const bool save_finalised = !config.app.finalised_mesh_path.empty();
+            se::io::ChangeFeed<se::TSDFColMap<se::Res::Single>>* fed_change_feed = config.app.change_feed_path.empty() ? nullptr : &change_feed;
+            const size_t num_finalised = active_window->update(*map, se::math::to_translation(T_WS), save_finalised ? &finalised_mesh : nullptr, fed_change_feed);
+            se::perfstats.sample("finalised blocks", num_finalised, PerfStats::COUNT);
+            if (!finalised_mesh.empty()) {
+                Eigen::Matrix4f T_WM_scale = map->getTWM();
+                T_WM_scale.topLeftCorner<3, 3>() *= map->getRes();
+                se::io::save_mesh_ply_binary(finalised_mesh, config.app.finalised_mesh_path + "/finalised_" + std::to_string(frame) + ".ply", T_WM_scale);
+            }
+        };
+
         float mean_fps = 0.0f;
         while (frame != config.app.max_frames) {
             se::perfstats.setIter(frame++);
@@ -148,35 +264,110 @@ int main(int argc, char** argv)
                 read_ok = reader->nextData(input_depth_img, input_colour_img);
             }
             if (read_ok != se::ReaderStatus::ok) {
+                // The reader may end before numFrames(), e.g. live readers, don't drop the buffered frames
+                if (!batch_frames.empty()) {
+                    integrate_batch();
+                }
                 break;
             }
             TOCK("read")
 
+            if (config.app.enable_depth_filter) {
+                TICK("depth filter")
+                const size_t num_removed = se::preprocessor::remove_flying_pixels(input_depth_img, depth_filter_scratch_img, config.app.depth_filter_max_jump);
+                se::preprocessor::bilateral_filter(input_depth_img, depth_filter_scratch_img, config.app.depth_filter_max_jump);
+                se::perfstats.sample("depth filter removed pixels", num_removed, PerfStats::COUNT);
+                TOCK("depth filter")
+            }
+
+            const bool last_frame = frame == config.app.max_frames || static_cast<size_t>(frame) == reader->numFrames();
+
             TICK("integration")
             double s = PerfStats::getTime();
-            if (frame % config.app.integration_rate == 0) {
-                se::integrator::integrate(map, gs_model, gs_cam_list, gt_img_list, data_queue, input_depth_img, input_colour_img, sensor, T_WS, frame);
+            // Buffered frames were captured at earlier poses, so with batching the window is moved
+            // after each batch instead, at the pose of its last frame
+            if (active_window && batch_size == 1) {
+                update_active_window();
+            }
+            if (frame % config.app.integration_rate == 0 && batch_size == 1) {
+                frame_ctx.reset(input_depth_img, &input_colour_img);
+                if (submaps) {
+                    se::integrator::integrate(*submaps, gs_model, gs_cam_list, gt_img_list, data_mailbox, frame_ctx, T_WS, frame);
+                }
+                else {
+                    se::integrator::integrate(*map, gs_model, gs_cam_list, gt_img_list, data_mailbox, frame_ctx, T_WS, frame, nullptr, seeded_region);
+                }
+            }
+            else if (frame % config.app.integration_rate == 0) {
+                // Copy the frame into the next free slot, reusing the slot buffers
+                const size_t slot = batch_frames.size();
+                batch_depth_imgs[slot] = input_depth_img;
+                batch_colour_imgs[slot] = input_colour_img;
+                batch_frame_ctxs[slot]->reset(batch_depth_imgs[slot], &batch_colour_imgs[slot]);
+                batch_views.emplace_back(*batch_frame_ctxs[slot], T_WS);
+                batch_frames.push_back(frame);
+            }
+            if (!batch_frames.empty() && (batch_frames.size() == batch_size || last_frame)) {
+                integrate_batch();
+                if (active_window) {
+                    update_active_window();
+                }
             }
             double e = PerfStats::getTime();
             mean_fps += (1 / (e - s));
             TOCK("integration")
             TOCK("total")
 
-            const bool last_frame = frame == config.app.max_frames || static_cast<size_t>(frame) == reader->numFrames();
+            // Publish the voxels changed by this frame, the feed is empty while frames are batched
+            if (!config.app.change_feed_path.empty()) {
+                se::io::save_change_feed(change_feed, *map, config.app.change_feed_path + "/delta_" + std::to_string(frame) + ".bin");
+            }
+
+            // Render the TSDF from the current pose
+            const bool render_frame = (config.app.rendering_rate > 0 && frame % config.app.rendering_rate == 0)
+                || (config.app.rendering_rate == 0 && last_frame) || (config.app.rendering_rate < 0 && frame == -config.app.rendering_rate);
+            if (!config.app.render_path.empty() && render_frame) {
+                TICK("rendering")
+                if (config.app.enable_raycast_reprojection && has_prev_render) {
+                    se::raycaster::raycast_volume_reprojected(
+                        *map, render_point_cloud_W, render_normals_W, render_scale, render_colour, T_WS, sensor, prev_render_point_cloud_W);
+                }
+                else if (config.app.raycast_subsampling_factor > 1) {
+                    se::raycaster::raycast_volume_subsampled(
+                        *map, render_point_cloud_W, render_normals_W, render_scale, render_colour, T_WS, sensor, config.app.raycast_subsampling_factor);
+                }
+                else {
+                    se::raycaster::raycast_volume(*map, render_point_cloud_W, render_normals_W, render_scale, render_colour, T_WS, sensor);
+                }
+                se::raycaster::render_volume_colour(
+                    render_RGBA_img.data(), input_img_res, render_point_cloud_W, render_normals_W, render_colour, se::math::to_translation(T_WS));
+                cv::Mat render_BGR;
+                cv::cvtColor(cv::Mat(input_img_res.y(), input_img_res.x(), CV_8UC4, render_RGBA_img.data()), render_BGR, cv::COLOR_RGBA2BGR);
+                cv::imwrite(config.app.render_path + "/render_" + std::to_string(frame) + ".png", render_BGR);
+                if (config.app.enable_raycast_reprojection) {
+                    std::swap(render_point_cloud_W, prev_render_point_cloud_W);
+                    has_prev_render = true;
+                }
+                TOCK("rendering")
+            }
+
             if (last_frame) {
                 double s = PerfStats::getTime();
 
                 // Refresh GUI
                 gs::DataPacket data_packet;
-                data_packet.num_kf = gt_img_list.size();
-                data_packet.rgb = cv::Mat(input_img_res.y(), input_img_res.x(), CV_8UC3, cv::Scalar(0, 0, 0));
-                data_packet.depth = cv::Mat(input_img_res.y(), input_img_res.x(), CV_8UC3, cv::Scalar(0, 0, 0));
-                data_packet.rendered_rgb = cv::Mat(input_img_res.y(), input_img_res.x(), CV_8UC3, cv::Scalar(0, 0, 0));
-                data_queue.push(data_packet);
+                if (data_mailbox.isEnabled()) {
+                    data_packet.num_kf = gt_img_list.size();
+                    data_packet.rgb = cv::Mat(input_img_res.y(), input_img_res.x(), CV_8UC3, cv::Scalar(0, 0, 0));
+                    data_packet.depth = cv::Mat(input_img_res.y(), input_img_res.x(), CV_8UC3, cv::Scalar(0, 0, 0));
+                    data_packet.rendered_rgb = cv::Mat(input_img_res.y(), input_img_res.x(), CV_8UC3, cv::Scalar(0, 0, 0));
+                    data_mailbox.push(data_packet);
+                }
 
                 // Global optimizaiton of reconstructed GS map (offline)
                 auto lambda = gs_model.optimParams.lambda_dssim;
                 auto iters = gs_model.optimParams.global_iters;
+                torch::Tensor num_visible = torch::zeros({}, torch::TensorOptions().dtype(torch::kLong).device(torch::kCUDA));
                 for (int it = 0; it < iters; it++) {
                     std::vector<int> indices = gs::get_random_indices(gt_img_list.size());
                     for (int i = 0; i < indices.size(); i++) {
@@ -184,6 +375,7 @@ int main(int argc, char** argv)
                         auto cur_gs_cam = gs_cam_list[indices[i]];
 
                         auto [image, viewspace_point_tensor, visibility_filter, radii] = gs::render(cur_gs_cam, gs_model);
+                        num_visible += visibility_filter.sum();
 
                         // Loss Computations
                         auto l1_loss = gs::l1_loss(image, cur_gt_img);
@@ -194,19 +386,22 @@ int main(int argc, char** argv)
                         loss.backward();
                         gs_model.optimizer->step();
                         gs_model.optimizer->zero_grad(true);
+                        se::work::add(se::work::OptimizerSteps);
 
-                        if (i == indices.size() - 1) {
+                        if (i == indices.size() - 1 && data_mailbox.isEnabled()) {
                             auto rendered_img_tensor = image.detach().permute({1, 2, 0}).contiguous().to(torch::kCPU);
                             rendered_img_tensor = rendered_img_tensor.mul(255).clamp(0, 255).to(torch::kU8);
                             auto cv_rendered_img = cv::Mat(image.size(1), image.size(2), CV_8UC3, rendered_img_tensor.data_ptr());
-                            data_packet.rendered_rgb = cv_rendered_img;
+                            // The packet outlives rendered_img_tensor
+                            data_packet.rendered_rgb = cv_rendered_img.clone();
                             data_packet.global_iter = it + 1;
-                            data_queue.push(data_packet);
+                            data_mailbox.push(data_packet);
                         }
                     }
                 }
                 torch::cuda::synchronize();
                 double e = PerfStats::getTime();
+                se::work::add(se::work::SplatsRendered, num_visible.item<int64_t>());
 
                 // Get GPU memory usage
                 auto mem_after = gs::getGPUMemoryUsage();
@@ -231,28 +426,71 @@ int main(int argc, char** argv)
             }
 
             // Save mesh if enabled
-            if ((config.app.meshing_rate > 0 && frame % config.app.meshing_rate == 0) || last_frame) {
+            if (((config.app.meshing_rate > 0 && frame % config.app.meshing_rate == 0) || last_frame) && (map || !submaps->empty())) {
+                // Only meshes are supported in submap mode, the other outputs are rejected above
                 if (!config.app.mesh_path.empty()) {
-                    map.saveMesh(config.app.mesh_path + "/mesh_" + std::to_string(frame) + ".ply");
+                    const se::TSDFColMap<se::Res::Single>::OctreeType::MeshType mesh = submaps ? submaps->mesh() : map->mesh();
+                    se::io::save_mesh(mesh, config.app.mesh_path + "/mesh_" + std::to_string(frame) + ".ply");
+                    // Sampled only on the frames a mesh is extracted
+                    se::perfstats.sample("memory mesh", mesh.capacity() * sizeof(se::TSDFColMap<se::Res::Single>::OctreeType::TriangleType) / 1024.0 / 1024.0, PerfStats::MEMORY);
                 }
                 if (!config.app.slice_path.empty()) {
-                    map.saveFieldSlices(config.app.slice_path + "/slice_x_" + std::to_string(frame) + ".vtk",
-                                        config.app.slice_path + "/slice_y_" + std::to_string(frame) + ".vtk",
-                                        config.app.slice_path + "/slice_z_" + std::to_string(frame) + ".vtk",
-                                        se::math::to_translation(T_WS));
+                    map->saveFieldSlices(config.app.slice_path + "/slice_x_" + std::to_string(frame) + ".vtk",
+                                         config.app.slice_path + "/slice_y_" + std::to_string(frame) + ".vtk",
+                                         config.app.slice_path + "/slice_z_" + std::to_string(frame) + ".vtk",
+                                         se::math::to_translation(T_WS));
+                }
+                if (!config.app.tile_path.empty()) {
+                    tiled_mesh_writer.save(*map);
                 }
                 if (!config.app.structure_path.empty()) {
-                    map.saveStructure(config.app.structure_path + "/struct_" + std::to_string(frame) + ".ply");
+                    map->saveStructure(config.app.structure_path + "/struct_" + std::to_string(frame) + ".ply");
                 }
             }
 
+            se::work::reduce();
             se::perfstats.sample("memory usage", se::system::memory_usage_self() / 1024.0 / 1024.0, PerfStats::MEMORY);
+            // Per-subsystem memory from counters maintained on allocation, without traversing any data structure
+            size_t octree_node_bytes = 0;
+            size_t octree_block_bytes = 0;
+            if (map) {
+                octree_node_bytes = map->getOctree()->getNodeBytes();
+                octree_block_bytes = map->getOctree()->getBlockBytes();
+            }
+            else {
+                for (size_t i = 0; i < submaps->size(); i++) {
+                    octree_node_bytes += (*submaps)[i].map->getOctree()->getNodeBytes();
+                    octree_block_bytes += (*submaps)[i].map->getOctree()->getBlockBytes();
+                }
+            }
+            const size_t keyframe_bytes = gt_img_list.empty() ? 0 : gt_img_list.size() * gt_img_list.front().nbytes();
+            se::perfstats.sample("memory octree nodes", octree_node_bytes / 1024.0 / 1024.0, PerfStats::MEMORY);
+            se::perfstats.sample("memory octree blocks", octree_block_bytes / 1024.0 / 1024.0, PerfStats::MEMORY);
+            se::perfstats.sample("memory keyframes", keyframe_bytes / 1024.0 / 1024.0, PerfStats::MEMORY);
+            se::perfstats.sample("memory compressed blocks", (active_window ? active_window->compressedBytes() : 0) / 1024.0 / 1024.0, PerfStats::MEMORY);
+            se::perfstats.sample("memory change feed", change_feed.shadowBytes() / 1024.0 / 1024.0, PerfStats::MEMORY);
+            se::perfstats.sample("memory discarded blocks", (active_window ? active_window->discardedBytes() : 0) / 1024.0 / 1024.0, PerfStats::MEMORY);
+            se::perfstats.sample("memory gaussians", gs_model.Get_param_bytes() / 1024.0 / 1024.0, PerfStats::MEMORY);
+            se::perfstats.sample("memory optimizer", gs_model.Get_optimizer_bytes() / 1024.0 / 1024.0, PerfStats::MEMORY);
             se::perfstats.writeToFilestream();
-            printProgress(static_cast<double>(frame) / (static_cast<double>(reader->numFrames()) - 1));
+            if (metrics_exporter) {
+                metrics_exporter->publish(se::perfstats,
+                                          {{"gsfusion_frames_total", "counter", static_cast<double>(frame), "Frames read"},
+                                           {"gsfusion_keyframes", "gauge", static_cast<double>(gt_img_list.size()), "Keyframes stored for optimization"},
+                                           {"gsfusion_gaussians", "gauge", gs_model.Get_xyz().defined() ? static_cast<double>(gs_model.Get_size()) : 0.0, "Gaussians in the model"},
+                                           {"gsfusion_gui_pending_packets", "gauge", static_cast<double>(data_mailbox.getSize()), "Packets waiting in the GUI mailbox"},
+                                           {"gsfusion_gui_dropped_packets_total", "counter", static_cast<double>(data_mailbox.getNumDropped()), "Stale packets replaced before the GUI took them"}});
+            }
+            // Live readers, e.g. se::ShmReader, don't know the number of frames
+            if (reader->numFrames() > 1) {
+                printProgress(static_cast<double>(frame) / (static_cast<double>(reader->numFrames()) - 1));
+            }
         }
 
         stop_signal.store(true);
-        gui_thread.join();
+        if (gui_thread.joinable()) {
+            gui_thread.join();
+        }
 
         return 0;
     }
@@ -0,0 +1,261 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Smart Robotics Lab, Technical University of Munich
+ * SPDX-FileCopyrightText: 2024 Jiaxin Wei
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include "metrics_exporter.hpp"
+
+#include <algorithm>
+#include <arpa/inet.h>
+#include <cctype>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sstream>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+
+namespace {
+
+/** Convert a PerfStats name into a valid Prometheus metric name. */
+std::string metric_name(const std::string& stat_name, const PerfStats::Type type)
+{
+    std::string name = "gsfusion_";
+    for (const char c : stat_name) {
+        const bool valid = std::isalnum(static_cast<unsigned char>(c));
+        if (valid) {
+            name.push_back(std::tolower(static_cast<unsigned char>(c)));
+        }
+        else if (name.back() != '_') {
+            name.push_back('_');
+        }
+    }
+    if (name.back() == '_') {
+        name.pop_back();
+    }
+    switch (type) {
+    case PerfStats::DURATION:
+        return name + "_seconds";
+    case PerfStats::MEMORY:
+        return name + "_bytes";
+    case PerfStats::FREQUENCY:
+        return name + "_hertz";
+    default:
+        return name;
+    }
+}
+
+
+/** Convert a PerfStats value to the base unit expected by Prometheus. */
+double metric_value(const double value, const PerfStats::Type type)
+{
+    // PerfStats::MEMORY is in MB.
+    return type == PerfStats::MEMORY ? value * 1024.0 * 1024.0 : value;
+}
+
+
+bool send_all(const int fd, const std::string& data)
+{
+    size_t sent = 0;
+    while (sent < data.size()) {
+        const ssize_t n = send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+        if (n <= 0) {
+            return false;
+        }
+        sent += n;
+    }
+    return true;
+}
+
+} // namespace
+
+
+se::MetricsExporter::MetricsExporter(const std::string& endpoint, const size_t window_size) :
+        endpoint_(endpoint),
+        window_size_(std::max(window_size, size_t(1))),
+        listen_fd_(-1),
+        is_unix_socket_(!endpoint.empty() && !std::all_of(endpoint.begin(), endpoint.end(), ::isdigit)),
+        snapshot_(std::make_shared<const Snapshot>()),
+        stop_(false)
+{
+    if (endpoint_.empty()) {
+        return;
+    }
+
+    if (is_unix_socket_) {
+        sockaddr_un addr = {};
+        addr.sun_family = AF_UNIX;
+        if (endpoint_.size() >= sizeof(addr.sun_path)) {
+            std::cerr << "Error: metrics socket path " << endpoint_ << " is too long\n";
+            return;
+        }
+        std::strncpy(addr.sun_path, endpoint_.c_str(), sizeof(addr.sun_path) - 1);
+        // Remove a stale socket left by a previous session.
+        unlink(endpoint_.c_str());
+        listen_fd_ = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (listen_fd_ >= 0 && bind(listen_fd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+            close(listen_fd_);
+            listen_fd_ = -1;
+        }
+    }
+    else {
+        sockaddr_in addr = {};
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        addr.sin_port = htons(std::stoi(endpoint_));
+        listen_fd_ = socket(AF_INET, SOCK_STREAM, 0);
+        const int reuse = 1;
+        if (listen_fd_ >= 0) {
+            setsockopt(listen_fd_, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+        }
+        if (listen_fd_ >= 0 && bind(listen_fd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+            close(listen_fd_);
+            listen_fd_ = -1;
+        }
+    }
+
+    if (listen_fd_ < 0 || listen(listen_fd_, 4) != 0) {
+        std::cerr << "Error: could not serve metrics on " << endpoint_ << ": " << std::strerror(errno) << "\n";
+        if (listen_fd_ >= 0) {
+            close(listen_fd_);
+            listen_fd_ = -1;
+        }
+        return;
+    }
+    thread_ = std::thread([this]() { serve(); });
+}
+
+
+se::MetricsExporter::~MetricsExporter()
+{
+    stop_.store(true);
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+    if (listen_fd_ >= 0) {
+        close(listen_fd_);
+        if (is_unix_socket_) {
+            unlink(endpoint_.c_str());
+        }
+    }
+}
+
+
+void se::MetricsExporter::publish(const PerfStats& perfstats, const std::vector<Metric>& extra_metrics)
+{
+    if (!isRunning()) {
+        return;
+    }
+
+    auto snapshot = std::make_shared<Snapshot>();
+    snapshot->metrics.reserve(perfstats.stats_.size() + extra_metrics.size());
+    for (const auto& [stat_name, stat] : perfstats.stats_) {
+        if (stat.data_.empty() || stat.type_ == PerfStats::ITERATION) {
+            continue;
+        }
+        const auto& [iter, iter_data] = *stat.data_.rbegin();
+        const double value = PerfStats::Stats::mergeIter(iter_data, stat.type_);
+        const std::string name = metric_name(stat_name, stat.type_);
+        snapshot->metrics.push_back({name, "gauge", metric_value(value, stat.type_), stat_name});
+
+        // Only durations measured in the current frame are added to the latency windows.
+        if (stat.type_ == PerfStats::DURATION && iter == perfstats.iter_) {
+            Latency& latency = latencies_[name];
+            if (latency.window.size() < window_size_) {
+                latency.window.push_back(value);
+            }
+            else {
+                latency.window[latency.next_idx] = value;
+            }
+            latency.next_idx = (latency.next_idx + 1) % window_size_;
+            latency.sum += value;
+            latency.count++;
+        }
+    }
+    snapshot->metrics.insert(snapshot->metrics.end(), extra_metrics.begin(), extra_metrics.end());
+
+    // Only the quantiles are published so that the windows aren't copied every frame.
+    snapshot->summaries.reserve(latencies_.size());
+    for (const auto& [name, latency] : latencies_) {
+        if (latency.window.empty()) {
+            continue;
+        }
+        Summary summary{name.substr(0, name.size() - std::strlen("_seconds")) + "_latency_seconds", latency.window.size(), {}, latency.sum, latency.count};
+        quantile_window_.assign(latency.window.begin(), latency.window.end());
+        for (size_t i = 0; i < quantiles_.size(); i++) {
+            const size_t idx = std::min(static_cast<size_t>(quantiles_[i] * quantile_window_.size()), quantile_window_.size() - 1);
+            std::nth_element(quantile_window_.begin(), quantile_window_.begin() + idx, quantile_window_.end());
+            summary.quantiles[i] = quantile_window_[idx];
+        }
+        snapshot->summaries.push_back(std::move(summary));
+    }
+    std::atomic_store(&snapshot_, std::shared_ptr<const Snapshot>(std::move(snapshot)));
+}
+
+
+void se::MetricsExporter::serve()
+{
+    while (!stop_.load()) {
+        // Wake up periodically to check whether the exporter is being destroyed.
+        pollfd listen_pfd = {listen_fd_, POLLIN, 0};
+        if (poll(&listen_pfd, 1, 200) <= 0) {
+            continue;
+        }
+        const int client_fd = accept(listen_fd_, nullptr, nullptr);
+        if (client_fd < 0) {
+            continue;
+        }
+
+        // Read the request line and headers, giving up on slow clients.
+        std::string request;
+        char buffer[1024];
+        pollfd client_pfd = {client_fd, POLLIN, 0};
+        while (request.find("\r\n\r\n") == std::string::npos && request.size() < 8192 && poll(&client_pfd, 1, 1000) > 0) {
+            const ssize_t n = recv(client_fd, buffer, sizeof(buffer), 0);
+            if (n <= 0) {
+                break;
+            }
+            request.append(buffer, n);
+        }
+
+        std::string response;
+        if (request.rfind("GET /metrics", 0) == 0 || request.rfind("GET / ", 0) == 0) {
+            const std::shared_ptr<const Snapshot> snapshot = std::atomic_load(&snapshot_);
+            const std::string body = render(*snapshot);
+            response = "HTTP/1.0 200 OK\r\nContent-Type: text/plain; version=0.0.4\r\nContent-Length: " + std::to_string(body.size()) + "\r\n\r\n" + body;
+        }
+        else {
+            response = "HTTP/1.0 404 Not Found\r\nContent-Length: 0\r\n\r\n";
+        }
+        send_all(client_fd, response);
+        close(client_fd);
+    }
+}
+
+
+std::string se::MetricsExporter::render(const Snapshot& snapshot)
+{
+    std::stringstream ss;
+    ss.precision(9);
+    for (const auto& metric : snapshot.metrics) {
+        ss << "# HELP " << metric.name << " " << metric.help << "\n";
+        ss << "# TYPE " << metric.name << " " << metric.type << "\n";
+        ss << metric.name << " " << metric.value << "\n";
+    }
+
+    for (const auto& summary : snapshot.summaries) {
+        ss << "# HELP " << summary.name << " Latency quantiles over the last " << summary.window_size << " frames\n";
+        ss << "# TYPE " << summary.name << " summary\n";
+        for (size_t i = 0; i < quantiles_.size(); i++) {
+            ss << summary.name << "{quantile=\"" << quantiles_[i] << "\"} " << summary.quantiles[i] << "\n";
+        }
+        ss << summary.name << "_sum " << summary.sum << "\n";
+        ss << summary.name << "_count " << summary.count << "\n";
+    }
+    return ss.str();
+}
@@ -11,6 +11,8 @@
 #include "reader.hpp"
 #include "reader_replica.hpp"
 #include "reader_scannetpp.hpp"
+#include "reader_shm.hpp"
+#include "reader_video.hpp"
 #include "se/common/filesystem.hpp"
 #include "se/common/str_utils.hpp"
 
@@ -25,6 +27,12 @@ se::Reader* se::create_reader(const se::ReaderConfig& config)
     case se::ReaderType::SCANNETPP:
         reader = new se::ScanNetppReader(config);
         break;
+    case se::ReaderType::SHM:
+        reader = new se::ShmReader(config);
+        break;
+    case se::ReaderType::VIDEO:
+        reader = new se::VideoReader(config);
+        break;
     default:
         std::cerr << "Error: Unrecognised file format, file not loaded\n";
     }
@@ -9,16 +9,17 @@
 
 #include "reader_base.hpp"
 
-#include <Eigen/Geometry>
 #include <algorithm>
 #include <cassert>
 #include <cmath>
+#include <fstream>
 #include <iostream>
 #include <sstream>
 #include <thread>
 
 #include "se/common/filesystem.hpp"
 #include "se/common/yaml.hpp"
+#include "se/map/preprocessor.hpp"
 
 
 se::ReaderType se::string_to_reader_type(const std::string& s)
@@ -31,6 +32,12 @@ se::ReaderType se::string_to_reader_type(const std::string& s)
     else if (s_lowered == "scannetpp") {
         return se::ReaderType::SCANNETPP;
     }
+    else if (s_lowered == "shm") {
+        return se::ReaderType::SHM;
+    }
+    else if (s_lowered == "video") {
+        return se::ReaderType::VIDEO;
+    }
     else {
         return se::ReaderType::UNKNOWN;
     }
@@ -45,6 +52,12 @@ std::string se::reader_type_to_string(se::ReaderType t)
     else if (t == se::ReaderType::SCANNETPP) {
         return "ScanNetpp";
     }
+    else if (t == se::ReaderType::SHM) {
+        return "Shm";
+    }
+    else if (t == se::ReaderType::VIDEO) {
+        return "Video";
+    }
     else {
         return "unknown";
     }
@@ -82,6 +95,9 @@ void se::ReaderConfig::readYaml(const std::string& filename)
     se::yaml::subnode_as_float(node, "inverse_scale", inverse_scale);
     se::yaml::subnode_as_bool(node, "drop_frames", drop_frames);
     se::yaml::subnode_as_int(node, "verbose", verbose);
+    se::yaml::subnode_as_int(node, "num_shards", num_shards);
+    se::yaml::subnode_as_int(node, "shard", shard);
+    se::yaml::subnode_as_int(node, "downsampling_factor", downsampling_factor);
     se::yaml::subnode_as_string(node, "sequence_path", sequence_path);
     se::yaml::subnode_as_string(node, "ground_truth_file", ground_truth_file);
 
@@ -111,6 +127,9 @@ std::ostream& se::operator<<(std::ostream& os, const se::ReaderConfig& c)
     os << str_utils::value_to_pretty_str(c.fps, "fps") << "\n";
     os << str_utils::bool_to_pretty_str(c.drop_frames, "drop_frames") << "\n";
     os << str_utils::value_to_pretty_str(c.verbose, "verbose") << "\n";
+    os << str_utils::value_to_pretty_str(c.num_shards, "num_shards") << "\n";
+    os << str_utils::value_to_pretty_str(c.shard, "shard") << "\n";
+    os << str_utils::value_to_pretty_str(c.downsampling_factor, "downsampling_factor") << "\n";
     return os;
 }
 
@@ -149,19 +168,25 @@ se::Reader::Reader(const se::ReaderConfig& c) :
         verbose_(c.verbose),
         is_live_reader_(false),
         status_(se::ReaderStatus::ok),
+        num_shards_(c.num_shards),
+        shard_(c.shard),
+        downsampling_factor_(c.downsampling_factor),
         frame_(SIZE_MAX),
         num_frames_(0),
         has_colour_(false),
         has_semantics_(false),
-        ground_truth_frame_(SIZE_MAX),
-        ground_truth_delimiter_(' ')
+        ground_truth_delimiter_(' '),
+        poses_loaded_(false),
+        native_depth_image_(1, 1),
+        native_colour_image_(1, 1),
+        half_depth_images_{Image<float>(1, 1), Image<float>(1, 1)}
 {
     // Trim trailing slashes from sequence_path_
     sequence_path_.erase(sequence_path_.find_last_not_of("/") + 1);
-    // Open the ground truth file if supplied
+    // Ensure the ground truth file is readable if supplied. It's parsed on the first pose request
+    // unless the derived class converts it.
     if (!ground_truth_file_.empty()) {
-        ground_truth_fs_.open(ground_truth_file_, std::ios::in);
-        if (!ground_truth_fs_.good()) {
+        if (!std::ifstream(ground_truth_file_).good()) {
             std::cerr << "Error: Could not read ground truth file " << ground_truth_file_ << "\n";
             status_ = se::ReaderStatus::error;
         }
@@ -169,6 +194,14 @@ se::Reader::Reader(const se::ReaderConfig& c) :
             ground_truth_delimiter_ = ',';
         }
     }
+    if (num_shards_ < 1 || shard_ < 0 || shard_ >= num_shards_) {
+        std::cerr << "Error: Invalid shard " << shard_ << " of " << num_shards_ << " shards\n";
+        status_ = se::ReaderStatus::error;
+    }
+    if (downsampling_factor_ < 1 || (downsampling_factor_ & (downsampling_factor_ - 1)) != 0) {
+        std::cerr << "Error: The downsampling factor must be a power of 2, not " << downsampling_factor_ << "\n";
+        status_ = se::ReaderStatus::error;
+    }
     // Ensure the available clock has enough accuracy to measure the requested
     // inter-frame time intervals. Compare the clock tick interval with the
     // seconds per frame.
@@ -231,15 +264,45 @@ se::ReaderStatus se::Reader::nextData(se::Image<float>& depth_image, se::Image<r
 }
 
 
+se::ReaderStatus se::Reader::readFrame(const size_t frame, se::Image<float>& depth_image)
+{
+    return readFrame(frame, depth_image, nullptr, nullptr, nullptr);
+}
+
+
+se::ReaderStatus se::Reader::readFrame(const size_t frame, se::Image<float>& depth_image, se::Image<rgb_t>& colour_image)
+{
+    return readFrame(frame, depth_image, &colour_image, nullptr, nullptr);
+}
+
+
+se::ReaderStatus se::Reader::readFrame(const size_t frame, se::Image<float>& depth_image, se::Image<rgb_t>& colour_image, Eigen::Matrix4f& T_WB)
+{
+    return readFrame(frame, depth_image, &colour_image, nullptr, &T_WB);
+}
+
+
+se::ReaderStatus se::Reader::seek(const size_t frame)
+{
+    if (!is_live_reader_ && frame >= num_frames_) {
+        return se::ReaderStatus::eof;
+    }
+    // nextFrame() increments frame_ before reading. Unsigned integer overflow results in SIZE_MAX
+    // for frame 0 which is also the initial value of frame_.
+    frame_ = frame - 1;
+    prev_frame_timestamp_ = std::chrono::steady_clock::time_point();
+    // Reading past the end of the sequence isn't an error when seeking back into it.
+    if (status_ == se::ReaderStatus::eof) {
+        status_ = se::ReaderStatus::ok;
+    }
+    return se::ReaderStatus::ok;
+}
+
+
 void se::Reader::restart()
 {
     frame_ = SIZE_MAX;
-    ground_truth_frame_ = SIZE_MAX;
     prev_frame_timestamp_ = std::chrono::steady_clock::time_point();
-    if (ground_truth_fs_.good() || ground_truth_fs_.eof()) {
-        ground_truth_fs_.clear();
-        ground_truth_fs_.seekg(0);
-    }
 }
 
 
@@ -257,19 +320,31 @@ size_t se::Reader::frame() const
 
 size_t se::Reader::numFrames() const
 {
-    return num_frames_;
+    return (num_frames_ == 0) ? 0 : shardEnd() - shardBegin();
+}
+
+
+size_t se::Reader::shardBegin() const
+{
+    return num_frames_ * shard_ / num_shards_;
+}
+
+
+size_t se::Reader::shardEnd() const
+{
+    return (num_frames_ == 0) ? SIZE_MAX : num_frames_ * (shard_ + 1) / num_shards_;
 }
 
 
 Eigen::Vector2i se::Reader::depthImageRes() const
 {
-    return depth_image_res_;
+    return depth_image_res_ / downsampling_factor_;
 }
 
 
 Eigen::Vector2i se::Reader::colourImageRes() const
 {
-    return colour_image_res_;
+    return colour_image_res_ / downsampling_factor_;
 }
 
 
@@ -307,52 +382,75 @@ se::ReaderStatus se::Reader::mergeStatus(se::ReaderStatus status_1, se::ReaderSt
 
 se::ReaderStatus se::Reader::nextPose(Eigen::Matrix4f& T_WB)
 {
-    return readPose(T_WB, frame_, ground_truth_delimiter_);
+    return getPose(T_WB, frame_);
 }
 
+
 se::ReaderStatus se::Reader::getPose(Eigen::Matrix4f& T_WB, const size_t frame)
 {
-    // Store and reset current ground truth frame
-    size_t ground_truth_frame_curr = ground_truth_frame_;
-    ground_truth_frame_ = SIZE_MAX;
-
-    // Store and reset current ground truth file stream
-    std::fpos ground_truth_fs_pos_curr = ground_truth_fs_.tellg();
-    std::ios_base::iostate ground_truth_fs_state_curr = ground_truth_fs_.rdstate();
-    ground_truth_fs_.clear();
-    ground_truth_fs_.seekg(0);
-
-    auto status = readPose(T_WB, frame, ground_truth_delimiter_);
-
-    // Restore current state of ground truth variables
-    ground_truth_frame_ = ground_truth_frame_curr;
-    ground_truth_fs_.setstate(ground_truth_fs_state_curr);
-    ground_truth_fs_.seekg(ground_truth_fs_pos_curr);
-    return status;
+    if (!poses_loaded_) {
+        const se::ReaderStatus status = loadPoses();
+        if (status != se::ReaderStatus::ok) {
+            return status;
+        }
+    }
+    if (frame >= poses_.size()) {
+        return se::ReaderStatus::eof;
+    }
+    if (!pose_valid_[frame]) {
+        return se::ReaderStatus::skip;
+    }
+    T_WB = poses_[frame];
+    return se::ReaderStatus::ok;
 }
 
 
-se::ReaderStatus se::Reader::readPose(Eigen::Matrix4f& T_WB, const size_t frame, const char delimiter)
+void se::Reader::appendPose(const Eigen::Vector3f& position, const Eigen::Quaternionf& orientation)
 {
-    std::string line;
-    while (true) {
-        std::getline(ground_truth_fs_, line);
-        // EOF reached
-        if (!ground_truth_fs_.good()) {
-            return se::ReaderStatus::eof;
+    poses_loaded_ = true;
+    // Ensure all the pose elements are finite
+    if (!position.allFinite() || !orientation.coeffs().allFinite()) {
+        if (verbose_ >= 1) {
+            std::cerr << "Warning: Expected finite ground truth pose but got " << position.transpose() << " " << orientation.coeffs().transpose() << "\n";
         }
-        // Ignore comment lines
-        if (line[0] == '#') {
-            continue;
+        poses_.emplace_back(Eigen::Matrix4f::Identity());
+        pose_valid_.push_back(false);
+        return;
+    }
+    // Ensure the quaternion represents a valid orientation
+    if (std::abs(orientation.norm() - 1.0f) > 1e-3) {
+        if (verbose_ >= 1) {
+            std::cerr << "Warning: Expected unit quaternion but got " << orientation.x() << " " << orientation.y() << " " << orientation.z() << " " << orientation.w() << " (x,y,z,w) with norm "
+                      << orientation.norm() << "\n";
         }
-        // Skip ground truth data until the ones corresponding to the current frame
-        // are found. This only happens when frames are dropped.
-        ground_truth_frame_++;
-        if (ground_truth_frame_ < frame) {
+        poses_.emplace_back(Eigen::Matrix4f::Identity());
+        pose_valid_.push_back(false);
+        return;
+    }
+    // Combine into the pose
+    Eigen::Matrix4f T_WB = Eigen::Matrix4f::Identity();
+    T_WB.block<3, 1>(0, 3) = position;
+    T_WB.block<3, 3>(0, 0) = orientation.toRotationMatrix();
+    poses_.push_back(T_WB);
+    pose_valid_.push_back(true);
+}
+
+
+se::ReaderStatus se::Reader::loadPoses()
+{
+    // Only attempt parsing the file once, poses past the ones read successfully result in EOF.
+    poses_loaded_ = true;
+    std::ifstream fs(ground_truth_file_, std::ios::in);
+    if (ground_truth_file_.empty() || !fs.good()) {
+        return se::ReaderStatus::eof;
+    }
+    for (std::string line; std::getline(fs, line);) {
+        // Ignore comment and empty lines
+        if (line.empty() || line[0] == '#') {
             continue;
         }
-        // Data line read, split on spaces
-        const std::vector<std::string> line_data = se::str_utils::split_str(line, delimiter);
+        // Data line read, split on the delimiter
+        const std::vector<std::string> line_data = se::str_utils::split_str(line, ground_truth_delimiter_);
         const size_t num_cols = line_data.size();
         if (num_cols < 7) {
             std::cerr << "Error: Invalid ground truth file format. "
@@ -361,42 +459,15 @@ se::ReaderStatus se::Reader::readPose(Eigen::Matrix4f& T_WB, const size_t frame,
         }
         // Convert the last 7 columns to float
         float pose_data[7];
-        bool pose_data_valid = true;
         for (uint8_t i = 0; i < 7; ++i) {
             pose_data[i] = std::stof(line_data[num_cols + i - 7]);
-            if (!std::isfinite(pose_data[i])) {
-                pose_data_valid = false;
-            }
-        }
-        // Ensure all the pose elements are finite
-        if (!pose_data_valid) {
-            if (verbose_ >= 1) {
-                std::cerr << "Warning: Expected finite ground truth pose but got";
-                for (uint8_t i = 0; i < 7; ++i) {
-                    std::cerr << " " << pose_data[i];
-                }
-                std::cerr << "\n";
-            }
-            return se::ReaderStatus::skip;
         }
         // Convert to position and orientation
         const Eigen::Vector3f position(pose_data[0], pose_data[1], pose_data[2]);
         const Eigen::Quaternionf orientation(pose_data[6], pose_data[3], pose_data[4], pose_data[5]);
-        // Ensure the quaternion represents a valid orientation
-        if (std::abs(orientation.norm() - 1.0f) > 1e-3) {
-            if (verbose_ >= 1) {
-                std::cerr << "Warning: Expected unit quaternion but got " << orientation.x() << " " << orientation.y() << " " << orientation.z() << " " << orientation.w() << " (x,y,z,w) with norm "
-                          << orientation.norm() << "\n";
-            }
-            return se::ReaderStatus::skip;
-        }
-        // Combine into the pose
-        T_WB = Eigen::Matrix4f::Identity();
-        T_WB.block<3, 1>(0, 3) = position;
-        T_WB.block<3, 3>(0, 0) = orientation.toRotationMatrix();
-
-        return se::ReaderStatus::ok;
+        appendPose(position, orientation);
     }
+    return se::ReaderStatus::ok;
 }
 
 
@@ -442,6 +513,17 @@ void se::Reader::nextFrame()
 }
 
 
+void se::Reader::nextShardFrame()
+{
+    nextFrame();
+    // Start reading from the first frame of the shard. This also handles the initial wrap around
+    // from SIZE_MAX to 0.
+    if (frame_ < shardBegin()) {
+        frame_ = shardBegin();
+    }
+}
+
+
 se::ReaderStatus se::Reader::nextColour(se::Image<se::rgb_t>& colour_image)
 {
     // Resize the output image if needed.
@@ -474,8 +556,67 @@ se::ReaderStatus se::Reader::nextData(se::Image<float>& depth_image, se::Image<s
         }
         return status_;
     }
-    nextFrame();
-    status_ = nextDepth(depth_image);
+    nextShardFrame();
+    if (frame_ >= shardEnd()) {
+        status_ = se::ReaderStatus::eof;
+        return status_;
+    }
+    return readData(depth_image, colour_image, class_id_image, T_WB);
+}
+
+
+se::ReaderStatus se::Reader::readFrame(const size_t frame, se::Image<float>& depth_image, se::Image<se::rgb_t>* colour_image, Image<semantics_t>* class_id_image, Eigen::Matrix4f* T_WB)
+{
+    if (seek(frame) != se::ReaderStatus::ok) {
+        return se::ReaderStatus::eof;
+    }
+    if (!good()) {
+        if (verbose_ >= 1) {
+            std::clog << "Stopping reading due to reader status: " << status_ << "\n";
+        }
+        return status_;
+    }
+    frame_ = frame;
+    return readData(depth_image, colour_image, class_id_image, T_WB);
+}
+
+
+se::ReaderStatus se::Reader::readDepth(se::Image<float>& depth_image)
+{
+    if (downsampling_factor_ == 1) {
+        return nextDepth(depth_image);
+    }
+    const se::ReaderStatus status = nextDepth(native_depth_image_);
+    if (status != se::ReaderStatus::ok) {
+        return status;
+    }
+    // Halve the resolution repeatedly, alternating between the intermediate images.
+    const se::Image<float>* input_image = &native_depth_image_;
+    for (int factor = downsampling_factor_, i = 0; factor > 1; factor /= 2, i = 1 - i) {
+        se::Image<float>& output_image = (factor == 2) ? depth_image : half_depth_images_[i];
+        se::preprocessor::half_sample_robust_image(output_image, *input_image, downsampling_depth_threshold_, 1);
+        input_image = &output_image;
+    }
+    return status;
+}
+
+
+se::ReaderStatus se::Reader::readColour(se::Image<se::rgb_t>& colour_image)
+{
+    if (downsampling_factor_ == 1) {
+        return nextColour(colour_image);
+    }
+    const se::ReaderStatus status = nextColour(native_colour_image_);
+    if (status == se::ReaderStatus::ok || status == se::ReaderStatus::skip) {
+        se::preprocessor::downsample_image(colour_image, native_colour_image_, downsampling_factor_);
+    }
+    return status;
+}
+
+
+se::ReaderStatus se::Reader::readData(se::Image<float>& depth_image, se::Image<se::rgb_t>* colour_image, Image<semantics_t>* class_id_image, Eigen::Matrix4f* T_WB)
+{
+    status_ = readDepth(depth_image);
     if (!good()) {
         if (verbose_ >= 1) {
             std::clog << "Stopping reading due to nextDepth() status: " << status_ << "\n";
@@ -483,7 +624,7 @@ se::ReaderStatus se::Reader::nextData(se::Image<float>& depth_image, se::Image<s
         return status_;
     }
     if (colour_image) {
-        status_ = mergeStatus(nextColour(*colour_image), status_);
+        status_ = mergeStatus(readColour(*colour_image), status_);
         if (!good()) {
             if (verbose_ >= 1) {
                 std::clog << "Stopping reading due to nextColour() status: " << status_ << "\n";
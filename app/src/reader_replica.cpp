@@ -13,7 +13,6 @@
 #include <chrono>
 #include <cmath>
 #include <cstring>
-#include <iomanip>
 #include <iostream>
 #include <opencv2/core/core.hpp>
 #include <opencv2/imgproc/imgproc.hpp>
@@ -66,18 +65,6 @@ struct ReplicaPoseEntry {
         orientation = C2W.block<3, 3>(0, 0);
     }
 
-    /** Return a single-line string representation of the ground truth pose.
-     * It can be used to write it to a ground truth file that is understood by
-     * supereight.
-     */
-    std::string string() const
-    {
-        const std::string s = std::to_string(timestamp) + " " + rgb_filename + " " + depth_filename + " " + std::to_string(position.x()) + " " + std::to_string(position.y()) + " "
-            + std::to_string(position.z()) + " " + std::to_string(orientation.x()) + " " + std::to_string(orientation.y()) + " " + std::to_string(orientation.z()) + " "
-            + std::to_string(orientation.w());
-        return s;
-    }
-
     EIGEN_MAKE_ALIGNED_OPERATOR_NEW
 };
 
@@ -106,28 +93,6 @@ std::vector<ReplicaPoseEntry> read_replica_ground_truth(const std::string& filen
 }
 
 
-/** Generate a ground truth file from poses and write it in a temporary file.
- */
-std::string write_ground_truth_tmp(const std::vector<ReplicaPoseEntry>& poses)
-{
-    // Open a temporary file
-    const std::string tmp_filename = stdfs::temp_directory_path() / "replica_gt.txt";
-    std::ofstream fs(tmp_filename, std::ios::out);
-    if (!fs.good()) {
-        std::cerr << "Error: Could not write associated ground truth file " << tmp_filename << "\n";
-        return "";
-    }
-    // Write the header
-    fs << "# Association of rgb images, depth images and ground truth poses\n";
-    fs << "# ID timestamp rgb_filename depth_filename tx ty tz qx qy qz qw\n";
-    // Write each of the associated poses
-    for (size_t i = 0; i < poses.size(); ++i) {
-        fs << std::setw(6) << std::setfill('0') << i << " " << poses[i].string() << "\n";
-    }
-    return tmp_filename;
-}
-
-
 // ReplicaReader implementation
 constexpr float se::ReplicaReader::replica_inverse_scale_;
 
@@ -196,19 +161,8 @@ se::ReplicaReader::ReplicaReader(const se::ReaderConfig& c) : se::Reader(c)
             status_ = se::ReaderStatus::error;
             return;
         }
-        for (size_t i = 0; i < gt_poses.size(); i++) {
-            gt_poses[i].depth_filename = depth_filenames_[i];
-            gt_poses[i].rgb_filename = rgb_filenames_[i];
-        }
-        // Generate the associated ground truth file
-        const std::string generated_filename = write_ground_truth_tmp(gt_poses);
-        // Close the original ground truth file and open the generated one
-        ground_truth_fs_.close();
-        ground_truth_fs_.open(generated_filename, std::ios::in);
-        if (!ground_truth_fs_.good()) {
-            std::cerr << "Error: Could not read generated ground truth file " << generated_filename << "\n";
-            status_ = se::ReaderStatus::error;
-            return;
+        for (const auto& pose : gt_poses) {
+            appendPose(pose.position, pose.orientation);
         }
     }
 
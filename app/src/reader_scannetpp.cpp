@@ -13,13 +13,13 @@
 #include <chrono>
 #include <cmath>
 #include <cstring>
-#include <iomanip>
 #include <iostream>
 #include <nlohmann/json.hpp>
 #include <opencv2/core/core.hpp>
 #include <opencv2/imgproc/imgproc.hpp>
 #include <opencv2/opencv.hpp>
 #include <set>
+#include <unordered_map>
 
 #include "se/common/filesystem.hpp"
 #include "se/common/image_utils.hpp"
@@ -58,18 +58,6 @@ struct ScanNetppPoseEntry {
         orientation = C2W.block<3, 3>(0, 0);
     }
 
-    /** Return a single-line string representation of the ground truth pose.
-     * It can be used to write it to a ground truth file that is understood by
-     * supereight.
-     */
-    std::string string() const
-    {
-        const std::string s = std::to_string(timestamp) + " " + rgb_filename + " " + depth_filename + " " + std::to_string(position.x()) + " " + std::to_string(position.y()) + " "
-            + std::to_string(position.z()) + " " + std::to_string(orientation.x()) + " " + std::to_string(orientation.y()) + " " + std::to_string(orientation.z()) + " "
-            + std::to_string(orientation.w());
-        return s;
-    }
-
     EIGEN_MAKE_ALIGNED_OPERATOR_NEW
 };
 
@@ -106,13 +94,23 @@ std::vector<ScanNetppPoseEntry> read_scannetpp_ground_truth(const std::string& g
     auto gt_json = read_json_file(gt_filename);
     auto filename_json = read_json_file(data_root + "/train_test_lists.json");
 
+    // Index the frames by image filename to look up each train image in constant time.
     std::vector<std::string> file_path;
+    std::unordered_map<std::string, size_t> file_path_index;
+    file_path.reserve(gt_json["frames"].size());
+    file_path_index.reserve(gt_json["frames"].size());
     for (size_t i = 0; i < gt_json["frames"].size(); i++) {
         file_path.push_back(gt_json["frames"][i]["file_path"]);
+        file_path_index.emplace(file_path.back(), i);
     }
-    for (auto name : filename_json["train"]) {
-        auto it = std::find(file_path.begin(), file_path.end(), name);
-        auto index = std::distance(file_path.begin(), it);
+    poses.reserve(filename_json["train"].size());
+    for (const auto& name : filename_json["train"]) {
+        const auto it = file_path_index.find(name.get<std::string>());
+        if (it == file_path_index.end()) {
+            std::cerr << "Warning: No ground truth pose for train image " << name.get<std::string>() << "\n";
+            continue;
+        }
+        const size_t index = it->second;
         std::string new_name = file_path[index];
         new_name.replace(new_name.find(".JPG"), 4, ".png");
 
@@ -140,28 +138,6 @@ std::vector<ScanNetppPoseEntry> read_scannetpp_ground_truth(const std::string& g
 }
 
 
-/** Generate a ground truth file from poses and write it in a temporary file.
- */
-std::string write_ground_truth_tmp(const std::vector<ScanNetppPoseEntry>& poses)
-{
-    // Open a temporary file
-    const std::string tmp_filename = stdfs::temp_directory_path() / "scannetpp_gt.txt";
-    std::ofstream fs(tmp_filename, std::ios::out);
-    if (!fs.good()) {
-        std::cerr << "Error: Could not write associated ground truth file " << tmp_filename << "\n";
-        return "";
-    }
-    // Write the header
-    fs << "# Association of rgb images, depth images and ground truth poses\n";
-    fs << "# ID timestamp rgb_filename depth_filename tx ty tz qx qy qz qw\n";
-    // Write each of the associated poses
-    for (size_t i = 0; i < poses.size(); ++i) {
-        fs << std::setw(6) << std::setfill('0') << i << " " << poses[i].string() << "\n";
-    }
-    return tmp_filename;
-}
-
-
 // ScanNetppReader implementation
 constexpr float se::ScanNetppReader::scannetpp_inverse_scale_;
 
@@ -193,17 +169,7 @@ se::ScanNetppReader::ScanNetppReader(const se::ReaderConfig& c) : se::Reader(c)
         for (size_t i = 0; i < gt_poses.size(); i++) {
             depth_filenames_.push_back(gt_poses[i].depth_filename);
             rgb_filenames_.push_back(gt_poses[i].rgb_filename);
-        }
-
-        // Generate the associated ground truth file
-        const std::string generated_filename = write_ground_truth_tmp(gt_poses);
-        // Close the original ground truth file and open the generated one
-        ground_truth_fs_.close();
-        ground_truth_fs_.open(generated_filename, std::ios::in);
-        if (!ground_truth_fs_.good()) {
-            std::cerr << "Error: Could not read generated ground truth file " << generated_filename << "\n";
-            status_ = se::ReaderStatus::error;
-            return;
+            appendPose(gt_poses[i].position, gt_poses[i].orientation);
         }
     }
 
@@ -0,0 +1,184 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Smart Robotics Lab, Technical University of Munich
+ * SPDX-FileCopyrightText: 2024 Jiaxin Wei
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "reader_shm.hpp"
+
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <thread>
+
+
+se::ShmReader::ShmReader(const se::ReaderConfig& c) :
+        se::Reader(c), ring_(nullptr), ring_size_(0), next_frame_(0), current_frame_(0), num_dropped_(0)
+{
+    is_live_reader_ = true;
+
+    // Wait for the producer to create and initialize the ring.
+    const auto attach_deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(attach_timeout_ms_);
+    int fd = -1;
+    struct stat fd_stat = {};
+    while (true) {
+        fd = shm_open(sequence_path_.c_str(), O_RDWR, 0);
+        if (fd >= 0 && fstat(fd, &fd_stat) == 0 && static_cast<size_t>(fd_stat.st_size) >= sizeof(gsf_ring_header)) {
+            break;
+        }
+        if (fd >= 0) {
+            close(fd);
+            fd = -1;
+        }
+        if (std::chrono::steady_clock::now() > attach_deadline) {
+            std::cerr << "Error: No shared-memory frame ring named " << sequence_path_ << "\n";
+            status_ = se::ReaderStatus::error;
+            return;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+    // Map the ring read-write because FUTEX_WAIT requires a writable mapping on older kernels.
+    ring_size_ = fd_stat.st_size;
+    void* data = mmap(nullptr, ring_size_, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        std::cerr << "Error: Could not map shared-memory frame ring " << sequence_path_ << "\n";
+        ring_ = nullptr;
+        status_ = se::ReaderStatus::error;
+        return;
+    }
+    ring_ = static_cast<gsf_ring_header*>(data);
+
+    // The producer writes the magic last once the header is complete.
+    while (__atomic_load_n(&ring_->magic, __ATOMIC_ACQUIRE) != GSF_RING_MAGIC) {
+        if (std::chrono::steady_clock::now() > attach_deadline) {
+            std::cerr << "Error: Shared-memory frame ring " << sequence_path_ << " wasn't initialized\n";
+            status_ = se::ReaderStatus::error;
+            return;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    if (ring_->version != GSF_RING_VERSION || ring_->num_slots < 2 || gsf_ring_size(ring_) > ring_size_) {
+        std::cerr << "Error: Incompatible shared-memory frame ring " << sequence_path_ << "\n";
+        status_ = se::ReaderStatus::error;
+        return;
+    }
+
+    depth_image_res_ = Eigen::Vector2i(ring_->depth_width, ring_->depth_height);
+    if (ring_->colour_width > 0 && ring_->colour_height > 0) {
+        colour_image_res_ = Eigen::Vector2i(ring_->colour_width, ring_->colour_height);
+        has_colour_ = true;
+    }
+    next_frame_ = oldestFrame();
+}
+
+
+se::ShmReader::~ShmReader()
+{
+    if (ring_) {
+        munmap(ring_, ring_size_);
+    }
+}
+
+
+void se::ShmReader::restart()
+{
+    se::Reader::restart();
+    if (ring_) {
+        next_frame_ = oldestFrame();
+        status_ = se::ReaderStatus::ok;
+    }
+    else {
+        status_ = se::ReaderStatus::error;
+    }
+}
+
+
+std::string se::ShmReader::name() const
+{
+    return std::string("ShmReader");
+}
+
+
+size_t se::ShmReader::numDropped() const
+{
+    return num_dropped_;
+}
+
+
+uint64_t se::ShmReader::oldestFrame() const
+{
+    // Leave the slot the producer writes next out so it isn't overwritten while being read.
+    const uint64_t write_count = __atomic_load_n(&ring_->write_count, __ATOMIC_ACQUIRE);
+    return (write_count >= ring_->num_slots) ? write_count - ring_->num_slots + 1 : 0;
+}
+
+
+se::ReaderStatus se::ShmReader::nextDepth(se::Image<float>& depth_image)
+{
+    while (true) {
+        // Load the futex word before checking for new frames so that a frame published in between
+        // makes the wait return immediately.
+        const uint32_t wake_value = __atomic_load_n(&ring_->wake, __ATOMIC_ACQUIRE);
+        const uint64_t write_count = __atomic_load_n(&ring_->write_count, __ATOMIC_ACQUIRE);
+        if (next_frame_ >= write_count) {
+            if (__atomic_load_n(&ring_->closed, __ATOMIC_ACQUIRE)) {
+                return se::ReaderStatus::eof;
+            }
+            gsf_ring_wait(ring_, wake_value, frame_timeout_ms_);
+            continue;
+        }
+        // Skip the frames that have already been or are about to be overwritten.
+        const uint64_t oldest_frame = oldestFrame();
+        if (next_frame_ < oldest_frame) {
+            num_dropped_ += oldest_frame - next_frame_;
+            next_frame_ = oldest_frame;
+        }
+
+        const uint64_t frame = next_frame_++;
+        gsf_ring_slot* slot = gsf_ring_slot_at(ring_, frame);
+        if (__atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE) != 2 * frame + 2) {
+            num_dropped_++;
+            continue;
+        }
+        // Resize the output image if needed.
+        if ((depth_image.width() != depth_image_res_.x()) || (depth_image.height() != depth_image_res_.y())) {
+            depth_image = se::Image<float>(depth_image_res_.x(), depth_image_res_.y());
+        }
+        std::memcpy(depth_image.data(), gsf_slot_depth(slot), depth_image.size() * sizeof(float));
+        // The producer overwrote the slot while it was being copied.
+        if (!gsf_slot_valid(slot, frame)) {
+            num_dropped_++;
+            continue;
+        }
+        current_frame_ = frame;
+        return se::ReaderStatus::ok;
+    }
+}
+
+
+se::ReaderStatus se::ShmReader::nextColour(se::Image<rgb_t>& colour_image)
+{
+    gsf_ring_slot* slot = gsf_ring_slot_at(ring_, current_frame_);
+    if (!(slot->flags & GSF_FRAME_HAS_COLOUR)) {
+        return se::Reader::nextColour(colour_image);
+    }
+    // Resize the output image if needed.
+    if ((colour_image.width() != colour_image_res_.x()) || (colour_image.height() != colour_image_res_.y())) {
+        colour_image = se::Image<rgb_t>(colour_image_res_.x(), colour_image_res_.y());
+    }
+    static_assert(sizeof(rgb_t) == 3, "The ring stores packed 8-bit RGB");
+    std::memcpy(colour_image.data(), gsf_slot_colour(ring_, slot), colour_image.size() * sizeof(rgb_t));
+    return gsf_slot_valid(slot, current_frame_) ? se::ReaderStatus::ok : se::ReaderStatus::skip;
+}
+
+
+se::ReaderStatus se::ShmReader::nextPose(Eigen::Matrix4f& T_WB)
+{
+    gsf_ring_slot* slot = gsf_ring_slot_at(ring_, current_frame_);
+    if (!(slot->flags & GSF_FRAME_HAS_POSE)) {
+        return se::ReaderStatus::skip;
+    }
+    T_WB = Eigen::Map<const Eigen::Matrix4f>(slot->T_WB);
+    return gsf_slot_valid(slot, current_frame_) ? se::ReaderStatus::ok : se::ReaderStatus::skip;
+}
@@ -0,0 +1,250 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Smart Robotics Lab, Technical University of Munich
+ * SPDX-FileCopyrightText: 2024 Jiaxin Wei
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "reader_video.hpp"
+
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <opencv2/imgproc/imgproc.hpp>
+#include <opencv2/videoio.hpp>
+
+#include "se/common/filesystem.hpp"
+
+
+// VideoReader implementation
+constexpr float se::VideoReader::video_inverse_scale_;
+
+se::VideoReader::VideoReader(const se::ReaderConfig& c) :
+        se::Reader(c),
+        stop_decoder_(false),
+        next_decoded_frame_(0),
+        current_frame_{0, false, Image<float>(1, 1), Image<rgb_t>(1, 1)}
+{
+    inverse_scale_ = (c.inverse_scale != 0) ? c.inverse_scale : video_inverse_scale_;
+
+    // Ensure sequence_path_ contains a depth stream. Only depth data is required to exist.
+    depth_filename_ = sequence_path_ + "/depth.bin";
+    std::ifstream depth_fs(depth_filename_, std::ios::in | std::ios::binary);
+    if (!stdfs::is_directory(sequence_path_) || !depth_fs.good()) {
+        std::cerr << "Error: The video sequence path must be a directory that contains a depth.bin file\n";
+        status_ = se::ReaderStatus::error;
+        return;
+    }
+    char magic[4];
+    uint32_t header[3];
+    depth_fs.read(magic, sizeof(magic));
+    depth_fs.read(reinterpret_cast<char*>(header), sizeof(header));
+    if (!depth_fs.good() || std::memcmp(magic, depth_magic_, sizeof(magic)) != 0 || header[0] == 0 || header[1] == 0) {
+        std::cerr << "Error: Invalid depth stream header in " << depth_filename_ << "\n";
+        status_ = se::ReaderStatus::error;
+        return;
+    }
+    depth_image_res_ = Eigen::Vector2i(header[0], header[1]);
+    const size_t depth_frame_size = depth_image_res_.prod() * sizeof(uint16_t);
+    num_frames_ = (stdfs::file_size(depth_filename_) - depth_header_size_) / depth_frame_size;
+    if (num_frames_ == 0) {
+        std::cerr << "Error: No depth frames in " << depth_filename_ << "\n";
+        status_ = se::ReaderStatus::error;
+        return;
+    }
+
+    for (const std::string extension : {".mkv", ".mp4", ".avi"}) {
+        if (stdfs::is_regular_file(sequence_path_ + "/rgb" + extension)) {
+            colour_filename_ = sequence_path_ + "/rgb" + extension;
+            break;
+        }
+    }
+    if (colour_filename_.empty()) {
+        std::cerr << "Warning: No rgb.mkv, rgb.mp4 or rgb.avi colour video in the provided sequence path\n";
+    }
+    else {
+        cv::VideoCapture capture(colour_filename_);
+        if (!capture.isOpened()) {
+            std::cerr << "Error: Could not open colour video " << colour_filename_ << "\n";
+            colour_filename_.clear();
+        }
+        else {
+            colour_image_res_ = Eigen::Vector2i(capture.get(cv::CAP_PROP_FRAME_WIDTH), capture.get(cv::CAP_PROP_FRAME_HEIGHT));
+            // The frame count is estimated from the container metadata, a shorter video is
+            // detected while decoding.
+            const double num_colour_frames = capture.get(cv::CAP_PROP_FRAME_COUNT);
+            if (num_colour_frames > 0 && static_cast<size_t>(num_colour_frames) < num_frames_) {
+                num_frames_ = num_colour_frames;
+            }
+        }
+    }
+    has_colour_ = !colour_filename_.empty();
+}
+
+
+se::VideoReader::~VideoReader()
+{
+    stopDecoder();
+}
+
+
+void se::VideoReader::restart()
+{
+    se::Reader::restart();
+    stopDecoder();
+    if (stdfs::is_regular_file(depth_filename_)) {
+        status_ = se::ReaderStatus::ok;
+    }
+    else {
+        status_ = se::ReaderStatus::error;
+    }
+}
+
+
+std::string se::VideoReader::name() const
+{
+    return std::string("VideoReader");
+}
+
+
+void se::VideoReader::startDecoder(const size_t start_frame)
+{
+    stopDecoder();
+    stop_decoder_ = false;
+    next_decoded_frame_ = start_frame;
+    decoder_ = std::thread([this, start_frame]() { decode(start_frame); });
+}
+
+
+void se::VideoReader::stopDecoder()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_decoder_ = true;
+    }
+    space_cv_.notify_all();
+    if (decoder_.joinable()) {
+        decoder_.join();
+    }
+    // Keep the images of the frames decoded ahead for reuse.
+    for (auto& frame : decoded_frames_) {
+        free_frames_.push_back(std::move(frame));
+    }
+    decoded_frames_.clear();
+}
+
+
+void se::VideoReader::decode(const size_t start_frame)
+{
+    const size_t depth_frame_size = depth_image_res_.prod() * sizeof(uint16_t);
+    std::ifstream depth_fs(depth_filename_, std::ios::in | std::ios::binary);
+    depth_fs.seekg(depth_header_size_ + start_frame * depth_frame_size);
+    cv::VideoCapture capture;
+    if (has_colour_) {
+        capture.open(colour_filename_);
+        // Seeking in compressed video is only accurate at keyframes, skip frames sequentially.
+        for (size_t i = 0; i < start_frame; i++) {
+            capture.grab();
+        }
+    }
+
+    std::vector<uint16_t> depth_data(depth_image_res_.prod());
+    cv::Mat bgr_data;
+    for (size_t frame = start_frame; frame < num_frames_; frame++) {
+        DecodedFrame decoded{frame, true, Image<float>(1, 1), Image<rgb_t>(1, 1)};
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            space_cv_.wait(lock, [this]() { return stop_decoder_ || decoded_frames_.size() < queue_capacity_; });
+            if (stop_decoder_) {
+                return;
+            }
+            if (!free_frames_.empty()) {
+                decoded = std::move(free_frames_.back());
+                free_frames_.pop_back();
+                decoded.frame = frame;
+                decoded.valid = true;
+            }
+        }
+
+        // Decode the depth frame.
+        if ((decoded.depth.width() != depth_image_res_.x()) || (decoded.depth.height() != depth_image_res_.y())) {
+            decoded.depth = se::Image<float>(depth_image_res_.x(), depth_image_res_.y());
+        }
+        depth_fs.read(reinterpret_cast<char*>(depth_data.data()), depth_frame_size);
+        decoded.valid = depth_fs.good();
+        for (size_t i = 0; i < depth_data.size(); i++) {
+            decoded.depth[i] = inverse_scale_ * depth_data[i];
+        }
+
+        // Decode the colour frame.
+        if (has_colour_ && decoded.valid) {
+            if ((decoded.colour.width() != colour_image_res_.x()) || (decoded.colour.height() != colour_image_res_.y())) {
+                decoded.colour = se::Image<rgb_t>(colour_image_res_.x(), colour_image_res_.y());
+            }
+            decoded.valid = capture.read(bgr_data) && bgr_data.cols == colour_image_res_.x() && bgr_data.rows == colour_image_res_.y();
+            if (decoded.valid) {
+                cv::Mat wrapper_mat(bgr_data.rows, bgr_data.cols, CV_8UC3, decoded.colour.data());
+                cv::cvtColor(bgr_data, wrapper_mat, cv::COLOR_BGR2RGB);
+            }
+        }
+
+        const bool valid = decoded.valid;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            decoded_frames_.push_back(std::move(decoded));
+        }
+        decoded_cv_.notify_one();
+        // Stop at the first frame that couldn't be decoded, the reader reports the error.
+        if (!valid) {
+            return;
+        }
+    }
+}
+
+
+se::ReaderStatus se::VideoReader::nextDepth(se::Image<float>& depth_image)
+{
+    if (frame_ >= num_frames_) {
+        return se::ReaderStatus::error;
+    }
+    // Restart decoding when frames before the ones already decoded are requested, e.g. after
+    // seek() or restart().
+    if (!decoder_.joinable() || frame_ < next_decoded_frame_) {
+        startDecoder(frame_);
+    }
+
+    while (true) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        decoded_cv_.wait(lock, [this]() { return !decoded_frames_.empty(); });
+        DecodedFrame decoded = std::move(decoded_frames_.front());
+        decoded_frames_.pop_front();
+        next_decoded_frame_ = decoded.frame + 1;
+        lock.unlock();
+        space_cv_.notify_one();
+
+        if (!decoded.valid) {
+            return se::ReaderStatus::error;
+        }
+        // Discard the frames skipped when dropping frames.
+        if (decoded.frame < frame_) {
+            lock.lock();
+            free_frames_.push_back(std::move(decoded));
+            continue;
+        }
+        // Hand the decoded images over without copying and recycle the previous ones.
+        std::swap(depth_image, decoded.depth);
+        std::swap(current_frame_, decoded);
+        lock.lock();
+        free_frames_.push_back(std::move(decoded));
+        return se::ReaderStatus::ok;
+    }
+}
+
+
+se::ReaderStatus se::VideoReader::nextColour(se::Image<rgb_t>& colour_image)
+{
+    if (!has_colour_ || current_frame_.frame != frame_) {
+        return se::ReaderStatus::error;
+    }
+    std::swap(colour_image, current_frame_.colour);
+    return se::ReaderStatus::ok;
+}
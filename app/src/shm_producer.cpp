@@ -0,0 +1,102 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Smart Robotics Lab, Technical University of Munich
+ * SPDX-FileCopyrightText: 2024 Jiaxin Wei
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include <chrono>
+#include <csignal>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <unistd.h>
+
+#include "reader.hpp"
+#include "shm_frame_ring.h"
+
+
+namespace {
+
+volatile std::sig_atomic_t stop = 0;
+
+void handleSignal(int)
+{
+    stop = 1;
+}
+
+} // namespace
+
+
+void printUsage(const char* name)
+{
+    std::cerr << "Usage: " << name << " [-n SLOTS] [-s SHM_NAME] YAML_FILE\n"
+              << "  Publish the frames of the dataset in the reader section of YAML_FILE into a shared-memory\n"
+              << "  frame ring, at the rate set by reader.fps, standing in for a sensor driver.\n"
+              << "  -n SLOTS     The number of frames the ring holds (default 4)\n"
+              << "  -s SHM_NAME  The name of the shared-memory object (default /gsfusion_frames)\n";
+}
+
+
+int main(int argc, char** argv)
+{
+    int num_slots = 4;
+    std::string shm_name = "/gsfusion_frames";
+    int opt;
+    while ((opt = getopt(argc, argv, "n:s:h")) != -1) {
+        switch (opt) {
+        case 'n':
+            num_slots = std::atoi(optarg);
+            break;
+        case 's':
+            shm_name = optarg;
+            break;
+        default:
+            printUsage(argv[0]);
+            return 2;
+        }
+    }
+    if (optind + 1 != argc) {
+        printUsage(argv[0]);
+        return 2;
+    }
+
+    se::ReaderConfig reader_config;
+    reader_config.readYaml(argv[optind]);
+    std::unique_ptr<se::Reader> reader(se::create_reader(reader_config));
+    if (!reader) {
+        return EXIT_FAILURE;
+    }
+
+    const Eigen::Vector2i depth_res = reader->depthImageRes();
+    const Eigen::Vector2i colour_res = reader->hasColour() ? reader->colourImageRes() : Eigen::Vector2i::Zero();
+    gsf_ring_header* ring = gsf_ring_create(shm_name.c_str(), num_slots, depth_res.x(), depth_res.y(), colour_res.x(), colour_res.y());
+    if (!ring) {
+        std::cerr << "Error: Could not create shared-memory frame ring " << shm_name << " with " << num_slots << " slots\n";
+        return EXIT_FAILURE;
+    }
+    std::signal(SIGINT, handleSignal);
+    std::signal(SIGTERM, handleSignal);
+    std::cout << "Publishing " << reader->name() << " frames to " << shm_name << "\n";
+
+    se::Image<float> depth_image(depth_res.x(), depth_res.y());
+    se::Image<se::rgb_t> colour_image(std::max(colour_res.x(), 1), std::max(colour_res.y(), 1));
+    Eigen::Matrix4f T_WB = Eigen::Matrix4f::Identity();
+    size_t num_published = 0;
+    while (!stop) {
+        const se::ReaderStatus status = reader->nextData(depth_image, colour_image, T_WB);
+        if (status == se::ReaderStatus::skip) {
+            continue;
+        }
+        if (status != se::ReaderStatus::ok) {
+            break;
+        }
+        const double timestamp = std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+        const uint8_t* colour_data = reader->hasColour() ? reinterpret_cast<const uint8_t*>(colour_image.data()) : nullptr;
+        gsf_ring_publish(ring, depth_image.data(), colour_data, T_WB.data(), timestamp);
+        num_published++;
+    }
+    gsf_ring_close(ring, shm_name.c_str());
+    std::cout << "Published " << num_published << " frames\n";
+    return EXIT_SUCCESS;
+}
@@ -79,6 +79,10 @@ class GaussianModel {
     }
     torch::Tensor Get_features() const;
     torch::Tensor Get_covariance(float scaling_modifier = 1.0);
+    // Memory used by the Gaussian parameters in bytes
+    size_t Get_param_bytes() const;
+    // Memory used by the parameter gradients and the Adam moments in bytes
+    size_t Get_optimizer_bytes() const;
 
     // Methods
     void Add_gaussians(std::vector<Point>& positions, std::vector<Color>& colors, std::vector<float>& scales);
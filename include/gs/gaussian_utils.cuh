@@ -9,13 +9,13 @@
 #define GS_GAUSSIAN_UTIL_HPP
 
 #include <Eigen/Dense>
+#include <chrono>
 #include <climits>
 #include <condition_variable>
 #include <fstream>
 #include <mutex>
 #include <nvml.h>
 #include <opencv2/opencv.hpp>
-#include <queue>
 #include <random>
 #include <tinyply.h>
 #include <torch/torch.h>
@@ -36,31 +36,64 @@ struct DataPacket {
 };
 
 
-class DataQueue {
+// Single-slot mailbox holding the latest packet for the GUI. A push replaces the packet that
+// hasn't been taken yet, so a viewer falling behind only skips stale packets. When disabled, e.g.
+// in headless mode, producers should check isEnabled() and skip preparing packets altogether.
+class DataMailbox {
     public:
+    explicit DataMailbox(bool enabled = true) : _enabled(enabled)
+    {
+    }
+
+    bool isEnabled() const
+    {
+        return _enabled;
+    }
+
     void push(DataPacket data)
     {
+        if (!_enabled) {
+            return;
+        }
         std::lock_guard<std::mutex> lock(_mtx);
-        _queue.push(std::move(data));
-        _cv.notify_one(); // Notify one waiting thread
+        if (_has_packet) {
+            _num_dropped++;
+        }
+        _packet = std::move(data);
+        _has_packet = true;
+        _cv.notify_one(); // Notify the waiting consumer
     }
 
-    DataPacket pop()
+    // Wait up to timeout for a packet, return false if none arrived
+    bool pop(DataPacket& data, const std::chrono::milliseconds timeout)
     {
         std::unique_lock<std::mutex> lock(_mtx);
-        _cv.wait(lock, [this]() { return !_queue.empty(); }); // Wait until queue is not empty
-        DataPacket data = std::move(_queue.front());
-        _queue.pop();
-        return data;
+        if (!_cv.wait_for(lock, timeout, [this]() { return _has_packet; })) {
+            return false;
+        }
+        data = std::move(_packet);
+        _packet = DataPacket();
+        _has_packet = false;
+        return true;
     }
 
     int getSize()
     {
-        return _queue.size();
+        std::lock_guard<std::mutex> lock(_mtx);
+        return _has_packet;
+    }
+
+    size_t getNumDropped()
+    {
+        std::lock_guard<std::mutex> lock(_mtx);
+        return _num_dropped;
     }
 
     private:
-    std::queue<DataPacket> _queue;
+    const bool _enabled;
+    DataPacket _packet;
+    bool _has_packet = false;
+    size_t _num_dropped = 0;
     std::mutex _mtx;
     std::condition_variable _cv;
 };
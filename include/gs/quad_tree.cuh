@@ -41,6 +41,12 @@ class Node {
     cv::Mat getPixels(const cv::Mat& img) const;
     float computeError(const cv::Mat& img) const;
 
+    /** Compute the same error as computeError(img) in constant time from the integral images of
+     * the channels and of the squared channels of img, see cv::integral(). Both integral images
+     * are of type CV_64FC3.
+     */
+    float computeError(const cv::Mat& img, const cv::Mat& sum, const cv::Mat& squared_sum) const;
+
     private:
     int x0_;
     int y0_;
@@ -54,6 +60,14 @@ class QTree {
     {
     }
 
+    /** Subdivide using the precomputed CV_64FC3 integral images of the channels and of the squared
+     * channels of img, which makes computing the error of each node constant time.
+     */
+    QTree(float threshold, int min_pixel_size, cv::Mat& img, const cv::Mat& sum, const cv::Mat& squared_sum) :
+            threshold_(threshold), min_pixel_size_(min_pixel_size), img_(img), sum_(sum), squared_sum_(squared_sum), root_(0, 0, img.cols, img.rows)
+    {
+    }
+
     inline std::vector<Node> getAllNodes() const
     {
         return all_children_;
@@ -71,11 +85,13 @@ class QTree {
     float threshold_;
     int min_pixel_size_;
     cv::Mat& img_;
+    cv::Mat sum_;
+    cv::Mat squared_sum_;
     Node root_;
     std::vector<Node> all_children_;
 };
 
-void recursive_subdivide(Node& node, float threshold, int min_pixel_size, cv::Mat& img);
+void recursive_subdivide(Node& node, float threshold, int min_pixel_size, cv::Mat& img, const cv::Mat& sum = cv::Mat(), const cv::Mat& squared_sum = cv::Mat());
 
 std::vector<Node> find_children(const Node& node);
 
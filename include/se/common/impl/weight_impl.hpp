@@ -27,6 +27,13 @@ static constexpr void increment(weight_t& weight, weight_t max_weight)
     }
 }
 
+static constexpr void decrement(weight_t& weight)
+{
+    if (weight > 0) {
+        weight--;
+    }
+}
+
 } // namespace weight
 } // namespace se
 
@@ -29,6 +29,10 @@ static delta_weight_t div(delta_weight_t weight, delta_weight_t divisor);
  */
 static constexpr void increment(weight_t& weight, weight_t max_weight);
 
+/** \brief Decrement weight by 1 while avoiding underflow.
+ */
+static constexpr void decrement(weight_t& weight);
+
 } // namespace weight
 } // namespace se
 
@@ -0,0 +1,77 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Smart Robotics Lab, Technical University of Munich
+ * SPDX-FileCopyrightText: 2024 Jiaxin Wei
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef SE_WORK_COUNTERS_HPP
+#define SE_WORK_COUNTERS_HPP
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+#include "perfstats.hpp"
+
+namespace se {
+namespace work {
+
+/** The amount of work done by the different pipeline stages, used to normalise their timings. */
+enum Counter {
+    RaysCast,         ///< Depth pixels raycast by se::RaycastCarver
+    RaySamples,       ///< Samples stepped along the se::RaycastCarver rays
+    BlocksFetched,    ///< Allocated blocks fetched from the sensor frustum
+    BlocksAllocated,  ///< Blocks newly allocated around the depth measurements
+    BlocksUpdated,    ///< Blocks with at least one voxel fused by se::GSUpdater
+    BlocksCulled,     ///< Blocks se::GSUpdater didn't fuse any voxel into
+    VoxelsFused,      ///< Voxels updated by se::GSUpdater
+    QuadtreeNodes,    ///< Leaves of the colour image quadtree
+    SeedCandidates,   ///< Quadtree leaves with a valid depth measurement
+    GaussiansAdded,   ///< Gaussians added to the model
+    SplatsRendered,   ///< Visible Gaussians summed over all renders
+    OptimizerSteps,   ///< Gaussian model optimizer steps
+    NumCounters
+};
+
+/** The names of the counters in se::perfstats. */
+constexpr std::array<const char*, NumCounters> counter_names = {"work rays",
+                                                                "work ray samples",
+                                                                "work blocks fetched",
+                                                                "work blocks allocated",
+                                                                "work blocks updated",
+                                                                "work blocks culled",
+                                                                "work voxels fused",
+                                                                "work quadtree nodes",
+                                                                "work seed candidates",
+                                                                "work gaussians added",
+                                                                "work splats rendered",
+                                                                "work optimizer steps"};
+
+/** Monotonic counters written only by the thread owning them. Relaxed atomics compile to plain
+ * loads and stores and allow the counters to be read from another thread in reduce().
+ */
+struct ThreadCounters {
+    std::array<std::atomic<uint64_t>, NumCounters> counts = {};
+};
+
+/** Return the counters of the calling thread, registering them on the first call. */
+ThreadCounters& thread_counters();
+
+/** Add \p n to \p counter. Each thread has its own counters so this never contends with other
+ * threads. In hot loops accumulate into a local variable and add it once per loop.
+ */
+inline void add(const Counter counter, const uint64_t n = 1)
+{
+    std::atomic<uint64_t>& count = thread_counters().counts[counter];
+    count.store(count.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+}
+
+/** Sum the counters of all threads and sample the work done since the last call into
+ * \p perfstats as PerfStats::COUNT stats. Call it once per frame.
+ */
+void reduce(PerfStats& perfstats = se::perfstats);
+
+} // namespace work
+} // namespace se
+
+#endif // SE_WORK_COUNTERS_HPP
@@ -9,18 +9,22 @@
 #ifndef SE_RAYCAST_CARVER_IMPL_HPP
 #define SE_RAYCAST_CARVER_IMPL_HPP
 
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
 namespace se {
 namespace fetcher {
 
 
 template<typename MapT, typename SensorT>
-inline std::vector<se::OctantBase*> frustum(MapT& map, const SensorT& sensor, const Eigen::Matrix4f& T_WS)
+inline std::vector<se::OctantBase*> frustum(MapT& map, const SensorT& sensor, const Eigen::Matrix4f& T_WS, const float max_distance)
 {
     const Eigen::Matrix4f T_SM = se::math::to_inverse_transformation(T_WS);
     // Loop over all allocated Blocks.
     std::vector<se::OctantBase*> fetched_block_ptrs;
 
-    for (auto block_ptr_itr = se::FrustumIterator<MapT, SensorT>(map, sensor, T_SM); block_ptr_itr != se::FrustumIterator<MapT, SensorT>(); ++block_ptr_itr) {
+    for (auto block_ptr_itr = se::FrustumIterator<MapT, SensorT>(map, sensor, T_SM, max_distance); block_ptr_itr != se::FrustumIterator<MapT, SensorT>(); ++block_ptr_itr) {
         fetched_block_ptrs.push_back(*block_ptr_itr);
     }
 
@@ -31,8 +35,15 @@ inline std::vector<se::OctantBase*> frustum(MapT& map, const SensorT& sensor, co
 } // namespace fetcher
 
 template<typename MapT, typename SensorT>
-RaycastCarver<MapT, SensorT>::RaycastCarver(MapT& map, const SensorT& sensor, const se::Image<float>& depth_img, const Eigen::Matrix4f& T_WS, const int frame) :
-        map_(map), octree_(*(map_.getOctree())), sensor_(sensor), depth_img_(depth_img), T_WS_(T_WS), frame_(frame), config_(map)
+RaycastCarver<MapT, SensorT>::RaycastCarver(MapT& map, se::FrameContext<SensorT>& frame_ctx, const Eigen::Matrix4f& T_WS, const int frame) :
+        map_(map),
+        octree_(*(map_.getOctree())),
+        frame_ctx_(frame_ctx),
+        sensor_(frame_ctx.sensor()),
+        depth_img_(frame_ctx.depth()),
+        T_WS_(T_WS),
+        frame_(frame),
+        config_(map)
 {
 }
 
@@ -43,20 +54,95 @@ std::vector<se::OctantBase*> RaycastCarver<MapT, SensorT>::operator()()
     TICK("fetch-frustum")
     // Fetch the currently allocated Blocks in the sensor frustum.
     // i.e. the fetched blocks might contain blocks outside the current valid sensor range.
-    std::vector<se::OctantBase*> fetched_block_ptrs = se::fetcher::frustum(map_, sensor_, T_WS_);
+    std::vector<se::OctantBase*> fetched_block_ptrs = se::fetcher::frustum(map_, sensor_, T_WS_, config_.active_radius);
     TOCK("fetch-frustum")
 
     TICK("create-list")
+    std::set<se::key_t> voxel_key_set;
+    collectMissingBlocks(voxel_key_set);
+    // Allocate the Blocks and get pointers only to the newly-allocated Blocks.
+    std::vector<key_t> voxel_keys(voxel_key_set.begin(), voxel_key_set.end());
+    TOCK("create-list")
+
+    TICK("allocate-list")
+    std::vector<se::OctantBase*> allocated_block_ptrs = se::allocator::blocks(voxel_keys, octree_, octree_.getRoot(), true);
+    TOCK("allocate-list")
+
+    work::add(work::BlocksFetched, fetched_block_ptrs.size());
+    work::add(work::BlocksAllocated, allocated_block_ptrs.size());
+
+    TICK("combine-vectors")
+    // Merge the previously-allocated and newly-allocated Block pointers.
+    allocated_block_ptrs.reserve(allocated_block_ptrs.size() + fetched_block_ptrs.size());
+    allocated_block_ptrs.insert(allocated_block_ptrs.end(), fetched_block_ptrs.begin(), fetched_block_ptrs.end());
+    TOCK("combine-vectors")
+    return allocated_block_ptrs;
+}
+
+
+template<typename MapT, typename SensorT>
+std::vector<se::OctantBase*> RaycastCarver<MapT, SensorT>::carveUnion(std::vector<RaycastCarver>& carvers)
+{
+    if (carvers.empty()) {
+        return std::vector<se::OctantBase*>();
+    }
+    MapT& map = carvers.front().map_;
+    OctreeType& octree = carvers.front().octree_;
+
+    TICK("fetch-frustum")
+    // The frustums of the sensors overlap, keep each fetched Block once.
+    std::vector<se::OctantBase*> fetched_block_ptrs;
+    for (const auto& carver : carvers) {
+        assert(&carver.map_ == &map && "All carvers allocate in the same map");
+        const std::vector<se::OctantBase*> sensor_block_ptrs = se::fetcher::frustum(map, carver.sensor_, carver.T_WS_, carver.config_.active_radius);
+        fetched_block_ptrs.insert(fetched_block_ptrs.end(), sensor_block_ptrs.begin(), sensor_block_ptrs.end());
+    }
+    std::sort(fetched_block_ptrs.begin(), fetched_block_ptrs.end());
+    fetched_block_ptrs.erase(std::unique(fetched_block_ptrs.begin(), fetched_block_ptrs.end()), fetched_block_ptrs.end());
+    TOCK("fetch-frustum")
+
+    TICK("create-list")
+    std::set<se::key_t> voxel_key_set;
+    for (auto& carver : carvers) {
+        carver.collectMissingBlocks(voxel_key_set);
+    }
+    std::vector<key_t> voxel_keys(voxel_key_set.begin(), voxel_key_set.end());
+    TOCK("create-list")
+
+    TICK("allocate-list")
+    std::vector<se::OctantBase*> allocated_block_ptrs = se::allocator::blocks(voxel_keys, octree, octree.getRoot(), true);
+    TOCK("allocate-list")
+
+    work::add(work::BlocksFetched, fetched_block_ptrs.size());
+    work::add(work::BlocksAllocated, allocated_block_ptrs.size());
+
+    TICK("combine-vectors")
+    // The Blocks were fetched before allocating so both lists are disjoint.
+    allocated_block_ptrs.reserve(allocated_block_ptrs.size() + fetched_block_ptrs.size());
+    allocated_block_ptrs.insert(allocated_block_ptrs.end(), fetched_block_ptrs.begin(), fetched_block_ptrs.end());
+    TOCK("combine-vectors")
+    return allocated_block_ptrs;
+}
+
+
+template<typename MapT, typename SensorT>
+void RaycastCarver<MapT, SensorT>::collectMissingBlocks(std::set<se::key_t>& voxel_key_set)
+{
     se::OctantBase* root_ptr = octree_.getRoot();
 
     const int num_steps = ceil(config_.band / (2 * map_.getRes()));
 
     const Eigen::Vector3f t_WS = T_WS_.topRightCorner<3, 1>();
+    const se::Image<Eigen::Vector3f>& point_cloud_S = frame_ctx_.pointCloud();
+    // A sample can be at most half a block diagonal away from the centre of its block.
+    const float max_sample_distance = config_.active_radius + std::sqrt(3.0f) / 2.0f * OctreeType::block_size * map_.getRes();
+    const float active_radius_sq = config_.active_radius * config_.active_radius;
 
 #pragma omp declare reduction(merge : std::set <se::key_t> : omp_out.insert(omp_in.begin(), omp_in.end()))
-    std::set<se::key_t> voxel_key_set;
 
-#pragma omp parallel for reduction(merge : voxel_key_set)
+    std::set<se::key_t> missing_key_set;
+    uint64_t num_rays = 0;
+#pragma omp parallel for reduction(merge : missing_key_set) reduction(+ : num_rays)
     for (int x = 0; x < depth_img_.width(); ++x) {
         for (int y = 0; y < depth_img_.height(); ++y) {
             const Eigen::Vector2i pixel(x, y);
@@ -65,11 +151,13 @@ std::vector<se::OctantBase*> RaycastCarver<MapT, SensorT>::operator()()
             if (depth_value < sensor_.near_plane || depth_value > (sensor_.far_plane + config_.band * 0.5f)) {
                 continue;
             }
+            num_rays++;
 
-            Eigen::Vector3f ray_dir_C;
-            const Eigen::Vector2f pixel_f = pixel.cast<float>();
-            sensor_.model.backProject(pixel_f, &ray_dir_C);
-            const Eigen::Vector3f point_W = (T_WS_ * (depth_value * ray_dir_C).homogeneous()).template head<3>();
+            const Eigen::Vector3f point_W = (T_WS_ * point_cloud_S(pixel.x(), pixel.y()).homogeneous()).template head<3>();
+            // Skip the rays whose band can't reach a block centred inside the active region.
+            if ((point_W - t_WS).norm() - config_.band * 0.5f > max_sample_distance) {
+                continue;
+            }
 
             const Eigen::Vector3f reverse_ray_dir_W = (t_WS - point_W).normalized();
 
@@ -83,29 +171,30 @@ std::vector<se::OctantBase*> RaycastCarver<MapT, SensorT>::operator()()
                 if (map_.template pointToVoxel<se::Safe::On>(ray_pos_W, voxel_coord)) {
                     const se::OctantBase* octant_ptr = se::fetcher::block<typename MapT::OctreeType>(voxel_coord, root_ptr);
                     if (octant_ptr == nullptr) {
-                        se::key_t voxel_key;
-                        se::keyops::encode_key(voxel_coord, octree_.max_block_scale, voxel_key);
-                        voxel_key_set.insert(voxel_key);
+                        const Eigen::Vector3i block_coord = voxel_coord / OctreeType::block_size * OctreeType::block_size;
+                        Eigen::Vector3f block_centre_W;
+                        map_.voxelToPoint(block_coord, OctreeType::block_size, block_centre_W);
+                        if ((block_centre_W - t_WS).squaredNorm() <= active_radius_sq) {
+                            se::key_t voxel_key;
+                            se::keyops::encode_key(voxel_coord, octree_.max_block_scale, voxel_key);
+                            missing_key_set.insert(voxel_key);
+                        }
                     }
                 }
                 ray_pos_W += step;
             }
         }
     }
-    // Allocate the Blocks and get pointers only to the newly-allocated Blocks.
-    std::vector<key_t> voxel_keys(voxel_key_set.begin(), voxel_key_set.end());
-    TOCK("create-list")
 
-    TICK("allocate-list")
-    std::vector<se::OctantBase*> allocated_block_ptrs = se::allocator::blocks(voxel_keys, octree_, octree_.getRoot(), true);
-    TOCK("allocate-list")
+    if (voxel_key_set.empty()) {
+        voxel_key_set.swap(missing_key_set);
+    }
+    else {
+        voxel_key_set.insert(missing_key_set.begin(), missing_key_set.end());
+    }
 
-    TICK("combine-vectors")
-    // Merge the previously-allocated and newly-allocated Block pointers.
-    allocated_block_ptrs.reserve(allocated_block_ptrs.size() + fetched_block_ptrs.size());
-    allocated_block_ptrs.insert(allocated_block_ptrs.end(), fetched_block_ptrs.begin(), fetched_block_ptrs.end());
-    TOCK("combine-vectors")
-    return allocated_block_ptrs;
+    work::add(work::RaysCast, num_rays);
+    work::add(work::RaySamples, num_rays * num_steps);
 }
 
 
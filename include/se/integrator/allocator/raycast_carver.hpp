@@ -9,17 +9,25 @@
 #ifndef SE_RAYCAST_CARVER_HPP
 #define SE_RAYCAST_CARVER_HPP
 
+#include <limits>
+
 #include "se/common/math_util.hpp"
+#include "se/common/work_counters.hpp"
 #include "se/integrator/allocator/dense_pooling_image.hpp"
 #include "se/integrator/allocator/volume_carver.hpp"
+#include "se/map/frame_context.hpp"
 #include "se/map/octree/propagator.hpp"
 
 namespace se {
 namespace fetcher {
 
 
+/**
+ * \brief Fetch the allocated blocks in the frustum of \p sensor whose centre is at most \p
+ * max_distance metres from the sensor.
+ */
 template<typename MapT, typename SensorT>
-inline std::vector<se::OctantBase*> frustum(MapT& map, const SensorT& sensor, const Eigen::Matrix4f& T_WS);
+inline std::vector<se::OctantBase*> frustum(MapT& map, const SensorT& sensor, const Eigen::Matrix4f& T_WS, const float max_distance = std::numeric_limits<float>::infinity());
 
 
 } // namespace fetcher
@@ -36,24 +44,27 @@ class RaycastCarver {
      * \param[in] map   The map allocate the frustum in
      */
     struct RaycastCarverConfig {
-        RaycastCarverConfig(const MapT& map) : truncation_boundary(map.getRes() * map.getDataConfig().truncation_boundary_factor), band(2 * truncation_boundary)
+        RaycastCarverConfig(const MapT& map) :
+                truncation_boundary(map.getRes() * map.getDataConfig().truncation_boundary_factor), band(2 * truncation_boundary), active_radius(map.getActiveRadius())
         {
         }
 
         const float truncation_boundary;
         const float band;
+        /** Only blocks whose centre is within active_radius metres of the sensor are allocated. */
+        const float active_radius;
     };
 
     /**
      * \brief Setup the raycast carver.
      *
      * \param[in]  map                  The reference to the map to be updated.
-     * \param[in]  sensor               The sensor model.
-     * \param[in]  depth_img            The depth image to be integrated.
+     * \param[in]  frame_ctx            The context of the frame to be integrated. The cached point
+     *                                  cloud is used to cast the rays.
      * \param[in]  T_WS                 The transformation from sensor to world frame.
      * \param[in]  frame                The frame number to be integrated.
      */
-    RaycastCarver(MapT& map, const SensorT& sensor, const se::Image<float>& depth_img, const Eigen::Matrix4f& T_WS, const int frame);
+    RaycastCarver(MapT& map, se::FrameContext<SensorT>& frame_ctx, const Eigen::Matrix4f& T_WS, const int frame);
 
     /**
      * \brief Allocate a band around the depth measurements using a raycasting approach
@@ -62,8 +73,25 @@ class RaycastCarver {
      */
     std::vector<se::OctantBase*> operator()();
 
+    /**
+     * \brief Allocate the union of the bands of several sensors observing the same map at the same
+     * time step. The frustums are fetched and the missing Blocks are allocated once for all sensors.
+     *
+     * \param[in] carvers The carvers of each sensor, all constructed with the same map.
+     *
+     * \return The allocated and fetched blocks, each one appearing once
+     */
+    static std::vector<se::OctantBase*> carveUnion(std::vector<RaycastCarver>& carvers);
+
+    /**
+     * \brief Insert the keys of the unallocated Blocks in the band around the depth measurements
+     * into \p voxel_key_set.
+     */
+    void collectMissingBlocks(std::set<se::key_t>& voxel_key_set);
+
     MapT& map_;
     OctreeType& octree_;
+    se::FrameContext<SensorT>& frame_ctx_;
     const SensorT& sensor_;
     const se::Image<float>& depth_img_;
     const Eigen::Matrix4f& T_WS_;
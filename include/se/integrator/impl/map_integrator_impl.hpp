@@ -27,45 +27,133 @@ template<Field FldT, Res ResT>
 struct GSIntegrateImplD {
     template<typename SensorT, typename MapT>
     static void integrate(MapT& map,
-                          const SensorT& sensor,
+                          FrameContext<SensorT>& frame_ctx,
                           gs::GaussianModel& gs_model,
                           std::vector<gs::Camera>& gs_cam_list,
                           std::vector<torch::Tensor>& gt_img_list,
-                          gs::DataQueue& data_queue,
-                          const Image<float>& depth_img,
-                          const Image<rgb_t>* colour_img,
+                          gs::DataMailbox& data_mailbox,
                           const Image<semantics_t>* class_img,
                           const Eigen::Matrix4f& T_WS,
-                          const unsigned int frame);
+                          const unsigned int frame,
+                          const Eigen::Matrix4f& T_WA = Eigen::Matrix4f::Identity(),
+                          const SeededRegion& seeded_region = SeededRegion(),
+                          std::vector<key_t>* updated_block_keys = nullptr);
 };
 
 template<>
 struct GSIntegrateImplD<Field::TSDF, Res::Single> {
     template<typename SensorT, typename MapT>
     static void integrate(MapT& map,
-                          const SensorT& sensor,
+                          FrameContext<SensorT>& frame_ctx,
                           gs::GaussianModel& gs_model,
                           std::vector<gs::Camera>& gs_cam_list,
                           std::vector<torch::Tensor>& gt_img_list,
-                          gs::DataQueue& data_queue,
-                          const Image<float>& depth_img,
-                          const Image<rgb_t>* colour_img,
+                          gs::DataMailbox& data_mailbox,
                           const Image<semantics_t>* class_img,
                           const Eigen::Matrix4f& T_WS,
-                          const unsigned int frame)
+                          const unsigned int frame,
+                          const Eigen::Matrix4f& T_WA = Eigen::Matrix4f::Identity(),
+                          const SeededRegion& seeded_region = SeededRegion(),
+                          std::vector<key_t>* updated_block_keys = nullptr)
     {
         // Allocation
         TICK("allocation")
-        RaycastCarver raycast_carver(map, sensor, depth_img, T_WS, frame);
+        RaycastCarver raycast_carver(map, frame_ctx, T_WS, frame);
         std::vector<OctantBase*> block_ptrs = raycast_carver();
         TOCK("allocation")
 
         // Update
         TICK("update")
-        GSUpdater updater(map, sensor, gs_model, gs_cam_list, gt_img_list, data_queue, depth_img, colour_img, class_img, T_WS, frame);
-        updater(block_ptrs);
+        GSUpdater updater(map, frame_ctx, gs_model, gs_cam_list, gt_img_list, data_mailbox, class_img, T_WS, frame, T_WA, seeded_region);
+        updater(block_ptrs, updated_block_keys);
         TOCK("update")
     }
+
+    template<typename SensorT, typename MapT>
+    static void integrate(MapT& map,
+                          const std::vector<RigView<SensorT>, Eigen::aligned_allocator<RigView<SensorT>>>& views,
+                          gs::GaussianModel& gs_model,
+                          std::vector<gs::Camera>& gs_cam_list,
+                          std::vector<torch::Tensor>& gt_img_list,
+                          gs::DataMailbox& data_mailbox,
+                          const std::vector<unsigned int>& frames,
+                          const Eigen::Matrix4f& T_WA = Eigen::Matrix4f::Identity(),
+                          const SeededRegion& seeded_region = SeededRegion())
+    {
+        typedef RaycastCarver<MapT, SensorT> CarverType;
+        typedef GSUpdater<MapT, SensorT> UpdaterType;
+
+        // Allocation of the union of the sensor bands
+        TICK("allocation")
+        std::vector<CarverType> carvers;
+        carvers.reserve(views.size());
+        for (size_t i = 0; i < views.size(); i++) {
+            carvers.emplace_back(map, views[i].frame_ctx, views[i].T_WS, frames[i]);
+        }
+        std::vector<OctantBase*> block_ptrs = CarverType::carveUnion(carvers);
+        TOCK("allocation")
+
+        // Update each block from all frames, then add the Gaussians of each frame
+        TICK("update")
+        std::vector<std::unique_ptr<UpdaterType>> updaters;
+        std::vector<UpdaterType*> updater_ptrs;
+        for (size_t i = 0; i < views.size(); i++) {
+            updaters.emplace_back(new UpdaterType(map, views[i].frame_ctx, gs_model, gs_cam_list, gt_img_list, data_mailbox, nullptr, views[i].T_WS, frames[i], T_WA, seeded_region));
+            updater_ptrs.push_back(updaters.back().get());
+        }
+        UpdaterType::updateBlocks(updater_ptrs, block_ptrs);
+        for (auto& updater : updaters) {
+            updater->addGaussians();
+        }
+        TOCK("update")
+    }
+
+    template<typename SensorT, typename MapT>
+    static void deintegrate(MapT& map, const SensorT& sensor, const IntegratedFrame& integrated_frame)
+    {
+        typedef typename MapT::OctreeType OctreeType;
+
+        // Only the blocks the frame was fused into hold its contribution. Blocks allocated by later
+        // frames inside its frustum must not be modified.
+        TICK("deintegration-fetch")
+        OctreeType& octree = *map.getOctree();
+        std::vector<OctantBase*> block_ptrs;
+        block_ptrs.reserve(integrated_frame.block_keys.size());
+        for (const key_t block_key : integrated_frame.block_keys) {
+            OctantBase* block_ptr = fetcher::block<OctreeType>(keyops::key_to_coord(block_key), octree.getRoot());
+            if (block_ptr) {
+                block_ptrs.push_back(block_ptr);
+            }
+        }
+        TOCK("deintegration-fetch")
+
+        // Time stamp the modified blocks with the latest frame so that incremental meshing picks them up
+        const int time_stamp = std::max(integrated_frame.frame, map.getOctree()->getRoot()->getTimeStamp());
+
+        TICK("deintegration-update")
+        FrameUpdater updater(map, sensor, integrated_frame.depth_img, &integrated_frame.colour_img, nullptr, integrated_frame.T_WS, time_stamp);
+        updater.deintegrate(block_ptrs);
+        TOCK("deintegration-update")
+    }
+
+    template<typename SensorT, typename MapT>
+    static void reintegrate(MapT& map, const SensorT& sensor, IntegratedFrame& integrated_frame)
+    {
+        const int time_stamp = std::max(integrated_frame.frame, map.getOctree()->getRoot()->getTimeStamp());
+
+        TICK("reintegration-allocation")
+        FrameContext<SensorT> frame_ctx(sensor);
+        frame_ctx.reset(integrated_frame.depth_img, &integrated_frame.colour_img);
+        RaycastCarver raycast_carver(map, frame_ctx, integrated_frame.T_WS, time_stamp);
+        std::vector<OctantBase*> block_ptrs = raycast_carver();
+        TOCK("reintegration-allocation")
+
+        TICK("reintegration-update")
+        integrated_frame.block_keys.clear();
+        FrameUpdater updater(map, sensor, integrated_frame.depth_img, &integrated_frame.colour_img, nullptr, integrated_frame.T_WS, time_stamp);
+        updater.integrate(block_ptrs, &integrated_frame.block_keys);
+        TOCK("reintegration-update")
+    }
 };
 
 template<typename MapT>
@@ -81,7 +169,56 @@ typename std::enable_if_t<MapT::col_ == Colour::On> integrate(MapT& map,
                                                               gs::GaussianModel& gs_model,
                                                               std::vector<gs::Camera>& gs_cam_list,
                                                               std::vector<torch::Tensor>& gt_img_list,
-                                                              gs::DataQueue& data_queue,
+                                                              gs::DataMailbox& data_mailbox,
+                                                              const Image<float>& depth_img,
+                                                              const Image<rgb_t>& colour_img,
+                                                              const SensorT& sensor,
+                                                              const Eigen::Matrix4f& T_WS,
+                                                              const unsigned int frame,
+                                                              std::optional<IntegratedFrame>* integrated_frame)
+{
+    if (depth_img.width() != colour_img.width() || depth_img.height() != colour_img.height()) {
+        std::ostringstream oss;
+        oss << "depth (" << depth_img.width() << "x" << depth_img.height() << ") and colour (" << colour_img.width() << "x" << colour_img.height() << ") image dimensions differ";
+        throw std::invalid_argument(oss.str());
+    }
+    FrameContext<SensorT> frame_ctx(sensor);
+    frame_ctx.reset(depth_img, &colour_img);
+    integrate(map, gs_model, gs_cam_list, gt_img_list, data_mailbox, frame_ctx, T_WS, frame, integrated_frame);
+}
+
+
+template<typename MapT, typename SensorT>
+typename std::enable_if_t<MapT::col_ == Colour::On> integrate(MapT& map,
+                                                              gs::GaussianModel& gs_model,
+                                                              std::vector<gs::Camera>& gs_cam_list,
+                                                              std::vector<torch::Tensor>& gt_img_list,
+                                                              gs::DataMailbox& data_mailbox,
+                                                              FrameContext<SensorT>& frame_ctx,
+                                                              const Eigen::Matrix4f& T_WS,
+                                                              const unsigned int frame,
+                                                              std::optional<IntegratedFrame>* integrated_frame,
+                                                              const SeededRegion& seeded_region)
+{
+    if (!frame_ctx.hasColour()) {
+        throw std::invalid_argument("the frame context has no colour image");
+    }
+    if (!integrated_frame) {
+        details::GSIntegrateImpl<MapT>::integrate(map, frame_ctx, gs_model, gs_cam_list, gt_img_list, data_mailbox, nullptr, T_WS, frame, Eigen::Matrix4f::Identity(), seeded_region);
+        return;
+    }
+    integrated_frame->emplace(frame_ctx.depth(), frame_ctx.colour(), T_WS, frame);
+    details::GSIntegrateImpl<MapT>::integrate(
+        map, frame_ctx, gs_model, gs_cam_list, gt_img_list, data_mailbox, nullptr, T_WS, frame, Eigen::Matrix4f::Identity(), seeded_region, &(*integrated_frame)->block_keys);
+}
+
+
+template<typename MapT, typename SensorT>
+typename std::enable_if_t<MapT::col_ == Colour::On> integrate(SubmapCollection<MapT>& submaps,
+                                                              gs::GaussianModel& gs_model,
+                                                              std::vector<gs::Camera>& gs_cam_list,
+                                                              std::vector<torch::Tensor>& gt_img_list,
+                                                              gs::DataMailbox& data_mailbox,
                                                               const Image<float>& depth_img,
                                                               const Image<rgb_t>& colour_img,
                                                               const SensorT& sensor,
@@ -93,7 +230,133 @@ typename std::enable_if_t<MapT::col_ == Colour::On> integrate(MapT& map,
         oss << "depth (" << depth_img.width() << "x" << depth_img.height() << ") and colour (" << colour_img.width() << "x" << colour_img.height() << ") image dimensions differ";
         throw std::invalid_argument(oss.str());
     }
-    details::GSIntegrateImpl<MapT>::integrate(map, sensor, gs_model, gs_cam_list, gt_img_list, data_queue, depth_img, &colour_img, nullptr, T_WS, frame);
+    FrameContext<SensorT> frame_ctx(sensor);
+    frame_ctx.reset(depth_img, &colour_img);
+    integrate(submaps, gs_model, gs_cam_list, gt_img_list, data_mailbox, frame_ctx, T_WS, frame);
+}
+
+
+template<typename MapT, typename SensorT>
+typename std::enable_if_t<MapT::col_ == Colour::On> integrate(SubmapCollection<MapT>& submaps,
+                                                              gs::GaussianModel& gs_model,
+                                                              std::vector<gs::Camera>& gs_cam_list,
+                                                              std::vector<torch::Tensor>& gt_img_list,
+                                                              gs::DataMailbox& data_mailbox,
+                                                              FrameContext<SensorT>& frame_ctx,
+                                                              const Eigen::Matrix4f& T_WS,
+                                                              const unsigned int frame)
+{
+    if (!frame_ctx.hasColour()) {
+        throw std::invalid_argument("the frame context has no colour image");
+    }
+    submaps.update(T_WS, frame);
+    auto& submap = submaps.active();
+    const Eigen::Matrix4f T_AS = submap.T_AW * T_WS;
+    // A new submap starts unobserved, don't seed Gaussians again on surfaces earlier submaps covered.
+    const size_t active_idx = submaps.activeIndex();
+    const SeededRegion seeded_region = [&submaps, active_idx](const Eigen::Vector3f& point_W) { return submaps.observedBefore(point_W, active_idx); };
+    details::GSIntegrateImpl<MapT>::integrate(*submap.map, frame_ctx, gs_model, gs_cam_list, gt_img_list, data_mailbox, nullptr, T_AS, frame, submap.T_WA, seeded_region);
+    submaps.updateBounds(submaps.activeIndex());
+}
+
+
+template<typename MapT, typename SensorT>
+typename std::enable_if_t<MapT::col_ == Colour::On> integrate(MapT& map,
+                                                              gs::GaussianModel& gs_model,
+                                                              std::vector<gs::Camera>& gs_cam_list,
+                                                              std::vector<torch::Tensor>& gt_img_list,
+                                                              gs::DataMailbox& data_mailbox,
+                                                              const std::vector<RigView<SensorT>, Eigen::aligned_allocator<RigView<SensorT>>>& views,
+                                                              const unsigned int frame)
+{
+    integrate(map, gs_model, gs_cam_list, gt_img_list, data_mailbox, views, std::vector<unsigned int>(views.size(), frame));
+}
+
+
+template<typename MapT, typename SensorT>
+typename std::enable_if_t<MapT::col_ == Colour::On> integrate(MapT& map,
+                                                              gs::GaussianModel& gs_model,
+                                                              std::vector<gs::Camera>& gs_cam_list,
+                                                              std::vector<torch::Tensor>& gt_img_list,
+                                                              gs::DataMailbox& data_mailbox,
+                                                              const std::vector<RigView<SensorT>, Eigen::aligned_allocator<RigView<SensorT>>>& views,
+                                                              const std::vector<unsigned int>& frames,
+                                                              const SeededRegion& seeded_region)
+{
+    if (views.size() != frames.size()) {
+        throw std::invalid_argument("the number of views and frame numbers differ");
+    }
+    for (const auto& view : views) {
+        if (!view.frame_ctx.hasColour()) {
+            throw std::invalid_argument("a view has no colour image");
+        }
+    }
+    details::GSIntegrateImpl<MapT>::integrate(map, views, gs_model, gs_cam_list, gt_img_list, data_mailbox, frames, Eigen::Matrix4f::Identity(), seeded_region);
+}
+
+
+template<typename MapT, typename SensorT>
+typename std::enable_if_t<MapT::col_ == Colour::On> integrate(SubmapCollection<MapT>& submaps,
+                                                              gs::GaussianModel& gs_model,
+                                                              std::vector<gs::Camera>& gs_cam_list,
+                                                              std::vector<torch::Tensor>& gt_img_list,
+                                                              gs::DataMailbox& data_mailbox,
+                                                              const std::vector<RigView<SensorT>, Eigen::aligned_allocator<RigView<SensorT>>>& views,
+                                                              const unsigned int frame)
+{
+    integrate(submaps, gs_model, gs_cam_list, gt_img_list, data_mailbox, views, std::vector<unsigned int>(views.size(), frame));
+}
+
+
+template<typename MapT, typename SensorT>
+typename std::enable_if_t<MapT::col_ == Colour::On> integrate(SubmapCollection<MapT>& submaps,
+                                                              gs::GaussianModel& gs_model,
+                                                              std::vector<gs::Camera>& gs_cam_list,
+                                                              std::vector<torch::Tensor>& gt_img_list,
+                                                              gs::DataMailbox& data_mailbox,
+                                                              const std::vector<RigView<SensorT>, Eigen::aligned_allocator<RigView<SensorT>>>& views,
+                                                              const std::vector<unsigned int>& frames)
+{
+    if (views.size() != frames.size()) {
+        throw std::invalid_argument("the number of views and frame numbers differ");
+    }
+    if (views.empty()) {
+        return;
+    }
+    for (const auto& view : views) {
+        if (!view.frame_ctx.hasColour()) {
+            throw std::invalid_argument("a view has no colour image");
+        }
+    }
+    submaps.update(views.front().T_WS, frames.front());
+    auto& submap = submaps.active();
+    // Express the sensor poses in the anchor frame of the active submap.
+    std::vector<RigView<SensorT>, Eigen::aligned_allocator<RigView<SensorT>>> views_A;
+    views_A.reserve(views.size());
+    for (const auto& view : views) {
+        views_A.emplace_back(view.frame_ctx, submap.T_AW * view.T_WS);
+    }
+    // A new submap starts unobserved, don't seed Gaussians again on surfaces earlier submaps covered.
+    const size_t active_idx = submaps.activeIndex();
+    const SeededRegion seeded_region = [&submaps, active_idx](const Eigen::Vector3f& point_W) { return submaps.observedBefore(point_W, active_idx); };
+    details::GSIntegrateImpl<MapT>::integrate(*submap.map, views_A, gs_model, gs_cam_list, gt_img_list, data_mailbox, frames, submap.T_WA, seeded_region);
+    submaps.updateBounds(submaps.activeIndex());
+}
+
+
+template<typename MapT, typename SensorT>
+typename std::enable_if_t<MapT::col_ == Colour::On> deintegrate(MapT& map, const SensorT& sensor, const IntegratedFrame& integrated_frame)
+{
+    details::GSIntegrateImpl<MapT>::deintegrate(map, sensor, integrated_frame);
+}
+
+
+template<typename MapT, typename SensorT>
+typename std::enable_if_t<MapT::col_ == Colour::On> reintegrate(MapT& map, const SensorT& sensor, IntegratedFrame& integrated_frame, const Eigen::Matrix4f& T_WS)
+{
+    details::GSIntegrateImpl<MapT>::deintegrate(map, sensor, integrated_frame);
+    integrated_frame.T_WS = T_WS;
+    details::GSIntegrateImpl<MapT>::reintegrate(map, sensor, integrated_frame);
 }
 
 } // namespace integrator
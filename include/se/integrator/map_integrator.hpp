@@ -12,6 +12,8 @@
 
 #include <cstddef>
 #include <iterator>
+#include <memory>
+#include <optional>
 #include <torch/torch.h>
 
 #include "gs/gaussian.cuh"
@@ -19,8 +21,11 @@
 #include "se/common/math_util.hpp"
 #include "se/integrator/allocator/raycast_carver.hpp"
 #include "se/integrator/allocator/volume_carver.hpp"
+#include "se/integrator/updater/updater.hpp"
+#include "se/map/frame_context.hpp"
 #include "se/map/octree/fetcher.hpp"
 #include "se/map/octree/integrator.hpp"
+#include "se/map/submap_collection.hpp"
 #include "se/map/utils/setup_util.hpp"
 
 
@@ -78,6 +83,25 @@ inline std::vector<se::OctantBase*> frustum(MapT& map, const SensorT& sensor, co
 static inline Eigen::Vector3f get_sample_coord(const Eigen::Vector3i& octant_coord, const int octant_size);
 
 
+/**
+ * \brief A frame and the pose of the sensor that captured it, one of several frames integrated in a
+ * single pass, e.g. the frames of the sensors of a rig or a batch of consecutive frames.
+ */
+template<typename SensorT>
+struct RigView {
+    RigView(FrameContext<SensorT>& frame_ctx, const Eigen::Matrix4f& T_WS) : frame_ctx(frame_ctx), T_WS(T_WS)
+    {
+    }
+
+    /** The sensor, depth and colour images of the frame. */
+    FrameContext<SensorT>& frame_ctx;
+    /** The transformation from this sensor to the world frame. */
+    Eigen::Matrix4f T_WS;
+
+    EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+};
+
+
 namespace integrator {
 
 template<typename MapT, typename SensorT>
@@ -85,13 +109,168 @@ typename std::enable_if_t<MapT::col_ == Colour::On> integrate(MapT& map,
                                                               gs::GaussianModel& gs_model,
                                                               std::vector<gs::Camera>& gs_cam_list,
                                                               std::vector<torch::Tensor>& gt_img_list,
-                                                              gs::DataQueue& data_queue,
+                                                              gs::DataMailbox& data_mailbox,
                                                               const se::Image<float>& depth_img,
                                                               const se::Image<rgb_t>& colour_img,
                                                               const SensorT& sensor,
                                                               const Eigen::Matrix4f& T_WS,
+                                                              const unsigned int frame,
+                                                              std::optional<IntegratedFrame>* integrated_frame = nullptr);
+
+/**
+ * \brief Integrate the frame of \p frame_ctx. All stages take the images derived from the frame
+ * from \p frame_ctx, so keep a single context for the whole sequence and reset() it for every
+ * frame to reuse its buffers. The context must have a colour image.
+ *
+ * \param[out] integrated_frame If not nullptr, set to the state needed to de-integrate the frame
+ *                              later using deintegrate() or reintegrate(). The images are copied.
+ * \param[in]  seeded_region    The region where no Gaussians are seeded, see se::SeededRegion.
+ */
+template<typename MapT, typename SensorT>
+typename std::enable_if_t<MapT::col_ == Colour::On> integrate(MapT& map,
+                                                              gs::GaussianModel& gs_model,
+                                                              std::vector<gs::Camera>& gs_cam_list,
+                                                              std::vector<torch::Tensor>& gt_img_list,
+                                                              gs::DataMailbox& data_mailbox,
+                                                              FrameContext<SensorT>& frame_ctx,
+                                                              const Eigen::Matrix4f& T_WS,
+                                                              const unsigned int frame,
+                                                              std::optional<IntegratedFrame>* integrated_frame = nullptr,
+                                                              const SeededRegion& seeded_region = SeededRegion());
+
+/**
+ * \brief Integrate a frame into the active submap of a submap collection, starting a new submap first
+ * if the active one has exceeded its frame or distance limit. The Gaussians are added in the world
+ * frame W. No Gaussians are seeded on points an earlier submap has observed, since a new submap
+ * starts unobserved and would otherwise seed them again.
+ */
+template<typename MapT, typename SensorT>
+typename std::enable_if_t<MapT::col_ == Colour::On> integrate(SubmapCollection<MapT>& submaps,
+                                                              gs::GaussianModel& gs_model,
+                                                              std::vector<gs::Camera>& gs_cam_list,
+                                                              std::vector<torch::Tensor>& gt_img_list,
+                                                              gs::DataMailbox& data_mailbox,
+                                                              const se::Image<float>& depth_img,
+                                                              const se::Image<rgb_t>& colour_img,
+                                                              const SensorT& sensor,
+                                                              const Eigen::Matrix4f& T_WS,
+                                                              const unsigned int frame);
+
+/**
+ * \brief Integrate the frame of \p frame_ctx into the active submap of a submap collection, see
+ * the overload above.
+ */
+template<typename MapT, typename SensorT>
+typename std::enable_if_t<MapT::col_ == Colour::On> integrate(SubmapCollection<MapT>& submaps,
+                                                              gs::GaussianModel& gs_model,
+                                                              std::vector<gs::Camera>& gs_cam_list,
+                                                              std::vector<torch::Tensor>& gt_img_list,
+                                                              gs::DataMailbox& data_mailbox,
+                                                              FrameContext<SensorT>& frame_ctx,
+                                                              const Eigen::Matrix4f& T_WS,
                                                               const unsigned int frame);
 
+/**
+ * \brief Integrate the frames captured by the sensors of a rig at the same time step in a single
+ * pass. The union of the blocks observed by all sensors is fetched and allocated once, and each block
+ * is updated from all sensors observing it in a single sweep. The TSDF equals integrating the views
+ * one after the other in order. Each view seeds Gaussians in the voxels it is the first to observe,
+ * as if integrated on its own after the views before it, then the Gaussians are optimized for each
+ * view in order. Each view must have a colour image.
+ *
+ * \param[in] views The frames of the sensors. The poses are in the world frame.
+ * \param[in] frame The time step, used as the frame number of all views.
+ */
+template<typename MapT, typename SensorT>
+typename std::enable_if_t<MapT::col_ == Colour::On> integrate(MapT& map,
+                                                              gs::GaussianModel& gs_model,
+                                                              std::vector<gs::Camera>& gs_cam_list,
+                                                              std::vector<torch::Tensor>& gt_img_list,
+                                                              gs::DataMailbox& data_mailbox,
+                                                              const std::vector<RigView<SensorT>, Eigen::aligned_allocator<RigView<SensorT>>>& views,
+                                                              const unsigned int frame);
+
+/**
+ * \brief Integrate the frames of a rig into the active submap of a submap collection, see the
+ * overload above. The active submap is selected using the pose of the first view.
+ */
+template<typename MapT, typename SensorT>
+typename std::enable_if_t<MapT::col_ == Colour::On> integrate(SubmapCollection<MapT>& submaps,
+                                                              gs::GaussianModel& gs_model,
+                                                              std::vector<gs::Camera>& gs_cam_list,
+                                                              std::vector<torch::Tensor>& gt_img_list,
+                                                              gs::DataMailbox& data_mailbox,
+                                                              const std::vector<RigView<SensorT>, Eigen::aligned_allocator<RigView<SensorT>>>& views,
+                                                              const unsigned int frame);
+
+/**
+ * \brief Integrate a batch of frames, e.g. K consecutive frames of a single sensor, in a single
+ * pass. The union of the blocks observed by all frames is allocated once and each voxel fuses all
+ * frames in order in a single sweep. The TSDF equals integrating the frames one after the other into
+ * those blocks. Each frame seeds Gaussians in the voxels it is the first to observe, see
+ * GSUpdater::updateBlocks(), so seeding also matches integrating the frames one after the other.
+ * The blocks are time stamped with the latest frame. Each view must have a colour image.
+ *
+ * \param[in] views         The frames in the order they are fused. The poses are in the world frame.
+ * \param[in] frames        The frame number of each view.
+ * \param[in] seeded_region The region where no Gaussians are seeded, see se::SeededRegion.
+ */
+template<typename MapT, typename SensorT>
+typename std::enable_if_t<MapT::col_ == Colour::On> integrate(MapT& map,
+                                                              gs::GaussianModel& gs_model,
+                                                              std::vector<gs::Camera>& gs_cam_list,
+                                                              std::vector<torch::Tensor>& gt_img_list,
+                                                              gs::DataMailbox& data_mailbox,
+                                                              const std::vector<RigView<SensorT>, Eigen::aligned_allocator<RigView<SensorT>>>& views,
+                                                              const std::vector<unsigned int>& frames,
+                                                              const SeededRegion& seeded_region = SeededRegion());
+
+/**
+ * \brief Integrate a batch of frames into the active submap of a submap collection, see the
+ * overload above. The active submap is selected once for the whole batch using the first view.
+ */
+template<typename MapT, typename SensorT>
+typename std::enable_if_t<MapT::col_ == Colour::On> integrate(SubmapCollection<MapT>& submaps,
+                                                              gs::GaussianModel& gs_model,
+                                                              std::vector<gs::Camera>& gs_cam_list,
+                                                              std::vector<torch::Tensor>& gt_img_list,
+                                                              gs::DataMailbox& data_mailbox,
+                                                              const std::vector<RigView<SensorT>, Eigen::aligned_allocator<RigView<SensorT>>>& views,
+                                                              const std::vector<unsigned int>& frames);
+
+/**
+ * \brief Remove the TSDF and colour contribution of a previously integrated frame from the map.
+ * Only the blocks recorded in \p integrated_frame are modified. The Gaussian model is not
+ * modified.
+ *
+ * The removal is exact, up to rounding, only for voxels whose weight stayed below
+ * se::FieldDataConfig::max_weight since the frame was integrated. Once the weight saturates later
+ * frames replace part of the average instead of adding to it and the weight stops counting the
+ * observations, so the contribution removed from such voxels is approximate and they are reset to
+ * unobserved after max_weight removals even if other frames still observe them. Loop closures
+ * moving many frames through heavily observed voxels thus don't reproduce rebuilding the map.
+ *
+ * \param[in] map              The map the frame was integrated into.
+ * \param[in] sensor           The sensor the frame was captured with.
+ * \param[in] integrated_frame The frame as returned by integrate() or reintegrate().
+ */
+template<typename MapT, typename SensorT>
+typename std::enable_if_t<MapT::col_ == Colour::On> deintegrate(MapT& map, const SensorT& sensor, const IntegratedFrame& integrated_frame);
+
+/**
+ * \brief Move a previously integrated frame to a corrected pose by de-integrating it at its old pose
+ * and integrating it again at the new one. This costs two frame updates instead of rebuilding the
+ * map. Only the TSDF and colour are updated, the Gaussian model is not modified. The
+ * de-integration is approximate for voxels whose weight saturated, see deintegrate().
+ *
+ * \param[in]     map              The map the frame was integrated into.
+ * \param[in]     sensor           The sensor the frame was captured with.
+ * \param[in,out] integrated_frame The integrated frame, its pose and blocks are updated on return.
+ * \param[in]     T_WS             The corrected transformation from sensor to world frame.
+ */
+template<typename MapT, typename SensorT>
+typename std::enable_if_t<MapT::col_ == Colour::On> reintegrate(MapT& map, const SensorT& sensor, IntegratedFrame& integrated_frame, const Eigen::Matrix4f& T_WS);
+
 } // namespace integrator
 
 } // namespace se
@@ -0,0 +1,290 @@
+/*
+ * SPDX-FileCopyrightText: 2016-2019 Emanuele Vespa
+ * SPDX-FileCopyrightText: 2021 Smart Robotics Lab, Imperial College London, Technical University of Munich
+ * SPDX-FileCopyrightText: 2021 Nils Funk
+ * SPDX-FileCopyrightText: 2021 Sotiris Papatheodorou
+ * SPDX-FileCopyrightText: 2024 Smart Robotics Lab, Technical University of Munich
+ * SPDX-FileCopyrightText: 2024 Jiaxin Wei
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef SE_SINGLERES_TSDF_FRAME_UPDATER_IMPL_HPP
+#define SE_SINGLERES_TSDF_FRAME_UPDATER_IMPL_HPP
+
+#include <algorithm>
+#include <cmath>
+
+#include "se/common/work_counters.hpp"
+
+namespace se {
+
+// Single-res TSDF frame updater
+template<Colour ColB, Semantics SemB, int BlockSize, typename SensorT>
+FrameUpdater<Map<Data<Field::TSDF, ColB, SemB>, Res::Single, BlockSize>, SensorT>::FrameUpdater(MapType& map,
+                                                                                                const SensorT& sensor,
+                                                                                                const Image<float>& depth_img,
+                                                                                                const Image<rgb_t>* colour_img,
+                                                                                                const Image<semantics_t>* class_img,
+                                                                                                const Eigen::Matrix4f& T_WS,
+                                                                                                const int frame) :
+        map_(map),
+        sensor_(sensor),
+        depth_img_(depth_img),
+        colour_img_(colour_img),
+        class_img_(class_img),
+        T_WS_(T_WS),
+        T_SW_(math::to_inverse_transformation(T_WS)),
+        frame_(frame),
+        config_(map)
+{
+}
+
+
+template<Colour ColB, Semantics SemB, int BlockSize, typename SensorT>
+void FrameUpdater<Map<Data<Field::TSDF, ColB, SemB>, Res::Single, BlockSize>, SensorT>::integrate(std::vector<OctantBase*>& block_ptrs,
+                                                                                                  std::vector<key_t>* updated_block_keys)
+{
+    updateBlocks({this}, block_ptrs, 1, updated_block_keys);
+}
+
+
+template<Colour ColB, Semantics SemB, int BlockSize, typename SensorT>
+void FrameUpdater<Map<Data<Field::TSDF, ColB, SemB>, Res::Single, BlockSize>, SensorT>::deintegrate(std::vector<OctantBase*>& block_ptrs)
+{
+    updateBlocks({this}, block_ptrs, -1);
+}
+
+
+template<Colour ColB, Semantics SemB, int BlockSize, typename SensorT>
+void FrameUpdater<Map<Data<Field::TSDF, ColB, SemB>, Res::Single, BlockSize>, SensorT>::updateBlocks(const std::vector<const FrameUpdater*>& updaters,
+                                                                                                     std::vector<OctantBase*>& block_ptrs,
+                                                                                                     const int sign,
+                                                                                                     std::vector<key_t>* updated_block_keys)
+{
+    if (updaters.empty()) {
+        return;
+    }
+    const MapType& map = updaters.front()->map_;
+    constexpr int block_size = BlockType::getSize();
+    int time_stamp = updaters.front()->frame_;
+    // The increment of the sample point per voxel in each sensor frame
+    std::vector<Eigen::Matrix3f> point_delta_matrix_Ss;
+    for (const FrameUpdater* updater : updaters) {
+        assert(&updater->map_ == &map && "All updaters update the same map");
+        time_stamp = std::max(time_stamp, updater->frame_);
+        point_delta_matrix_Ss.push_back(math::to_rotation(updater->T_SW_) * map.getRes());
+    }
+
+    std::vector<uint8_t> block_updated(block_ptrs.size(), 0);
+    uint64_t num_updated = 0;
+    uint64_t num_fused = 0;
+#pragma omp parallel for reduction(+ : num_updated, num_fused)
+    for (unsigned int i = 0; i < block_ptrs.size(); i++) {
+        BlockType& block = *static_cast<BlockType*>(block_ptrs[i]);
+        block.setTimeStamp(time_stamp);
+        const Eigen::Vector3i block_coord = block.getCoord();
+        Eigen::Vector3f point_base_W;
+        map.voxelToPoint(block_coord, point_base_W);
+
+        // The sample point of the first voxel in each sensor frame
+        std::vector<Eigen::Vector3f> point_base_Ss(updaters.size());
+        for (size_t s = 0; s < updaters.size(); s++) {
+            point_base_Ss[s] = (updaters[s]->T_SW_ * point_base_W.homogeneous()).template head<3>();
+        }
+        uint64_t num_block_fused = 0;
+
+        // Visit each voxel once and fuse the measurements of all frames observing it, in the order
+        // of the updaters.
+        for (unsigned int z = 0; z < block_size; ++z) {
+            for (unsigned int y = 0; y < block_size; ++y) {
+                for (unsigned int x = 0; x < block_size; ++x) {
+                    // Set voxel coordinates
+                    const Eigen::Vector3i voxel_coord = block_coord + Eigen::Vector3i(x, y, z);
+                    DataType& data = block.getData(voxel_coord);
+
+                    for (size_t s = 0; s < updaters.size(); s++) {
+                        // Set sample point in camera frame
+                        const Eigen::Vector3f point_S = point_base_Ss[s] + point_delta_matrix_Ss[s] * Eigen::Vector3f(x, y, z);
+                        num_block_fused += updaters[s]->fuseVoxel(data, point_S, sign);
+                    }
+                } // x
+            }     // y
+        }         // z
+        block_updated[i] = num_block_fused > 0;
+        num_updated += block_updated[i];
+        num_fused += num_block_fused;
+    }
+    work::add(work::BlocksUpdated, num_updated);
+    work::add(work::BlocksCulled, block_ptrs.size() - num_updated);
+    work::add(work::VoxelsFused, num_fused);
+
+    if (updated_block_keys) {
+        for (size_t i = 0; i < block_ptrs.size(); i++) {
+            if (block_updated[i]) {
+                updated_block_keys->push_back(keyops::encode_key(static_cast<BlockType*>(block_ptrs[i])->getCoord(), MapType::OctreeType::max_block_scale));
+            }
+        }
+    }
+
+    propagator::propagateTimeStampToRoot(block_ptrs);
+}
+
+
+template<Colour ColB, Semantics SemB, int BlockSize, typename SensorT>
+Eigen::Vector3f FrameUpdater<Map<Data<Field::TSDF, ColB, SemB>, Res::Single, BlockSize>, SensorT>::sensorPoint(const Eigen::Vector3i& block_coord,
+                                                                                                               const Eigen::Vector3i& voxel_offset) const
+{
+    Eigen::Vector3f point_base_W;
+    map_.voxelToPoint(block_coord, point_base_W);
+    const Eigen::Vector3f point_base_S = (T_SW_ * point_base_W.homogeneous()).template head<3>();
+    const Eigen::Matrix3f point_delta_matrix_S = math::to_rotation(T_SW_) * map_.getRes();
+    return point_base_S + point_delta_matrix_S * voxel_offset.cast<float>();
+}
+
+
+template<Colour ColB, Semantics SemB, int BlockSize, typename SensorT>
+bool FrameUpdater<Map<Data<Field::TSDF, ColB, SemB>, Res::Single, BlockSize>, SensorT>::measure(const Eigen::Vector3f& point_S,
+                                                                                                float& sdf_value,
+                                                                                                int& pixel_idx) const
+{
+    if (point_S.norm() > sensor_.farDist(point_S)) {
+        return false;
+    }
+
+    // Project sample point to the image plane.
+    Eigen::Vector2f pixel_f;
+    if (sensor_.model.project(point_S, &pixel_f) != srl::projection::ProjectionStatus::Successful) {
+        return false;
+    }
+    const Eigen::Vector2i pixel = se::round_pixel(pixel_f);
+    pixel_idx = pixel.x() + depth_img_.width() * pixel.y();
+
+    // Fetch the image value.
+    const float depth_value = depth_img_[pixel_idx];
+
+    if (depth_value < sensor_.near_plane) {
+        return false;
+    }
+
+    const float m = sensor_.measurementFromPoint(point_S);
+    sdf_value = point_S.norm() * (depth_value - m) / m;
+    return sdf_value > -config_.truncation_boundary;
+}
+
+
+template<Colour ColB, Semantics SemB, int BlockSize, typename SensorT>
+bool FrameUpdater<Map<Data<Field::TSDF, ColB, SemB>, Res::Single, BlockSize>, SensorT>::fuseVoxel(DataType& data,
+                                                                                                  const Eigen::Vector3f& point_S,
+                                                                                                  const int sign) const
+{
+    float sdf_value;
+    int pixel_idx;
+    if (!measure(point_S, sdf_value, pixel_idx)) {
+        return false;
+    }
+
+    if (sign > 0) {
+        updateVoxel(data, sdf_value);
+        if constexpr (MapType::col_ == Colour::On) {
+            if (colour_img_) {
+                updateVoxelColour(data, (*colour_img_)[pixel_idx]);
+            }
+        }
+        if constexpr (MapType::sem_ != Semantics::Off) {
+            if (class_img_) {
+                updateVoxelSemantics(data, (*class_img_)[pixel_idx]);
+            }
+        }
+    }
+    else {
+        removeVoxel(data, sdf_value);
+        if constexpr (MapType::col_ == Colour::On) {
+            if (colour_img_) {
+                removeVoxelColour(data, (*colour_img_)[pixel_idx]);
+            }
+        }
+    }
+    return true;
+}
+
+
+template<Colour ColB, Semantics SemB, int BlockSize, typename SensorT>
+void FrameUpdater<Map<Data<Field::TSDF, ColB, SemB>, Res::Single, BlockSize>, SensorT>::updateVoxel(DataType& data, float sdf_value) const
+{
+    weight::increment(data.weight, map_.getDataConfig().max_weight);
+    const tsdf_t tsdf_value = math::clamp(sdf_value / config_.truncation_boundary, -1.0f, 1.0f) * tsdf_t_scale;
+    data.tsdf = (data.tsdf * (data.weight - 1) + tsdf_value) / data.weight;
+}
+
+
+template<Colour ColB, Semantics SemB, int BlockSize, typename SensorT>
+void FrameUpdater<Map<Data<Field::TSDF, ColB, SemB>, Res::Single, BlockSize>, SensorT>::updateVoxelColour(DataType& data, rgb_t colour_value) const
+{
+    // Use if instead of std::min to prevent overflow.
+    if (data.rgb_weight < map_.getDataConfig().max_weight) {
+        data.rgb_weight++;
+    }
+    // No overflow occurs due to integral promotion to int or unsigned int during arithmetic operations.
+    data.rgb.r = (data.rgb.r * (data.rgb_weight - 1) + colour_value.r) / data.rgb_weight;
+    data.rgb.g = (data.rgb.g * (data.rgb_weight - 1) + colour_value.g) / data.rgb_weight;
+    data.rgb.b = (data.rgb.b * (data.rgb_weight - 1) + colour_value.b) / data.rgb_weight;
+}
+
+
+template<Colour ColB, Semantics SemB, int BlockSize, typename SensorT>
+void FrameUpdater<Map<Data<Field::TSDF, ColB, SemB>, Res::Single, BlockSize>, SensorT>::updateVoxelSemantics(DataType& data, semantics_t class_id) const
+{
+    // Use if instead of std::min to prevent overflow.
+    if (data.sem_weight < map_.getDataConfig().max_weight) {
+        data.sem_weight++;
+    }
+    data.sem.merge(class_id, data.sem_weight);
+}
+
+
+template<Colour ColB, Semantics SemB, int BlockSize, typename SensorT>
+void FrameUpdater<Map<Data<Field::TSDF, ColB, SemB>, Res::Single, BlockSize>, SensorT>::removeVoxel(DataType& data, float sdf_value) const
+{
+    if (data.weight == 0) {
+        return;
+    }
+    if (data.weight == 1) {
+        // The frame was the only observation, reset the voxel to its unobserved state.
+        data.tsdf = DataType().tsdf;
+        data.weight = 0;
+        return;
+    }
+    // Invert the running average with float accumulators to avoid compounding the rounding of the
+    // integer update. Once the weight saturates at max_weight the forward update no longer
+    // increments it, so the inverse is an approximation for heavily observed voxels.
+    const tsdf_t tsdf_value = math::clamp(sdf_value / config_.truncation_boundary, -1.0f, 1.0f) * tsdf_t_scale;
+    const float w = data.weight;
+    const float tsdf = (static_cast<float>(data.tsdf) * w - tsdf_value) / (w - 1.0f);
+    data.tsdf = math::clamp(std::round(tsdf), -static_cast<float>(tsdf_t_scale), static_cast<float>(tsdf_t_scale));
+    weight::decrement(data.weight);
+}
+
+
+template<Colour ColB, Semantics SemB, int BlockSize, typename SensorT>
+void FrameUpdater<Map<Data<Field::TSDF, ColB, SemB>, Res::Single, BlockSize>, SensorT>::removeVoxelColour(DataType& data, rgb_t colour_value) const
+{
+    if (data.rgb_weight == 0) {
+        return;
+    }
+    if (data.rgb_weight == 1) {
+        data.rgb = DataType().rgb;
+        data.rgb_weight = 0;
+        return;
+    }
+    const float w = data.rgb_weight;
+    const auto remove = [w](const uint8_t c, const uint8_t c_removed) {
+        return static_cast<uint8_t>(math::clamp(std::round((c * w - c_removed) / (w - 1.0f)), 0.0f, 255.0f));
+    };
+    data.rgb.r = remove(data.rgb.r, colour_value.r);
+    data.rgb.g = remove(data.rgb.g, colour_value.g);
+    data.rgb.b = remove(data.rgb.b, colour_value.b);
+    data.rgb_weight--;
+}
+
+} // namespace se
+#endif // SE_SINGLERES_TSDF_FRAME_UPDATER_IMPL_HPP
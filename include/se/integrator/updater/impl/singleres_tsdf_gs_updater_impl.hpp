@@ -18,34 +18,37 @@
 
 #include "gs/loss_utils.cuh"
 #include "gs/render_utils.cuh"
+#include "se/common/work_counters.hpp"
 
 namespace se {
 
 // Single-res TSDF updater
 template<Colour ColB, Semantics SemB, int BlockSize, typename SensorT>
 GSUpdater<Map<Data<Field::TSDF, ColB, SemB>, Res::Single, BlockSize>, SensorT>::GSUpdater(MapType& map,
-                                                                                          const SensorT& sensor,
+                                                                                          FrameContext<SensorT>& frame_ctx,
                                                                                           gs::GaussianModel& gs_model,
                                                                                           std::vector<gs::Camera>& gs_cam_list,
                                                                                           std::vector<torch::Tensor>& gt_img_list,
-                                                                                          gs::DataQueue& data_queue,
-                                                                                          const Image<float>& depth_img,
-                                                                                          const Image<rgb_t>* colour_img,
+                                                                                          gs::DataMailbox& data_mailbox,
                                                                                           const Image<semantics_t>* class_img,
                                                                                           const Eigen::Matrix4f& T_WS,
-                                                                                          const int frame) :
+                                                                                          const int frame,
+                                                                                          const Eigen::Matrix4f& T_WA,
+                                                                                          const SeededRegion& seeded_region) :
         map_(map),
-        sensor_(sensor),
+        frame_ctx_(frame_ctx),
+        sensor_(frame_ctx.sensor()),
         gs_model_(gs_model),
         gs_cam_list_(gs_cam_list),
         gt_img_list_(gt_img_list),
-        data_queue_(data_queue),
-        depth_img_(depth_img),
-        colour_img_(colour_img),
-        class_img_(class_img),
+        data_mailbox_(data_mailbox),
+        depth_img_(frame_ctx.depth()),
+        colour_img_(&frame_ctx.colour()),
         T_WS_(T_WS),
         frame_(frame),
-        config_(map)
+        T_WA_(T_WA),
+        seeded_region_(seeded_region),
+        frame_updater_(map, frame_ctx.sensor(), frame_ctx.depth(), &frame_ctx.colour(), class_img, T_WS, frame)
 {
     // Construct torch::Tensor RGB image used for optimization
     start_time_ = PerfStats::getTime();
@@ -58,10 +61,9 @@ GSUpdater<Map<Data<Field::TSDF, ColB, SemB>, Res::Single, BlockSize>, SensorT>::
     torch::Tensor image_tensor = torch::from_blob(color_data_.data(), {colour_img_->height(), colour_img_->width(), 3}, {colour_img_->width() * 3, 3, 1}, torch::kUInt8);
     cur_gt_img_ = image_tensor.to(torch::kFloat32).permute({2, 0, 1}).clone() / 255.f;
     cur_gt_img_ = torch::clamp(cur_gt_img_, 0.f, 1.f).to(torch::kCUDA, true);
-    gt_img_list_.push_back(cur_gt_img_);
 
     // Construct gs::Camera used for rendering
-    Eigen::Matrix4f T_SW = math::to_inverse_transformation(T_WS_);
+    Eigen::Matrix4f T_SW = math::to_inverse_transformation(T_WA_ * T_WS_);
     torch::Tensor W2C_matrix = torch::from_blob(T_SW.data(), {4, 4}, torch::kFloat).clone().to(torch::kCUDA, true);
     torch::Tensor proj_matrix =
         gs::getProjectionMatrix(colour_img_->width(), colour_img_->height(), sensor_.model.focalLengthU(), sensor_.model.focalLengthV(), sensor_.model.imageCenterU(), sensor_.model.imageCenterV())
@@ -73,9 +75,11 @@ GSUpdater<Map<Data<Field::TSDF, ColB, SemB>, Res::Single, BlockSize>, SensorT>::
     cur_gs_cam_.T_W2C = W2C_matrix;
     cur_gs_cam_.full_proj_matrix = W2C_matrix.mm(proj_matrix);
     cur_gs_cam_.cam_center = W2C_matrix.inverse()[3].slice(0, 0, 3);
-    gs_cam_list_.push_back(cur_gs_cam_);
 
     // Construct cv::Mat colored depth image for visualization
+    if (!data_mailbox_.isEnabled()) {
+        return;
+    }
     std::vector<float> depth_data;
     for (size_t i = 0; i < depth_img_.size(); i++) {
         depth_data.push_back(depth_img_.data()[i]);
@@ -92,91 +96,61 @@ GSUpdater<Map<Data<Field::TSDF, ColB, SemB>, Res::Single, BlockSize>, SensorT>::
 
 
 template<Colour ColB, Semantics SemB, int BlockSize, typename SensorT>
-void GSUpdater<Map<Data<Field::TSDF, ColB, SemB>, Res::Single, BlockSize>, SensorT>::operator()(std::vector<OctantBase*>& block_ptrs)
+void GSUpdater<Map<Data<Field::TSDF, ColB, SemB>, Res::Single, BlockSize>, SensorT>::operator()(std::vector<OctantBase*>& block_ptrs,
+                                                                                                std::vector<key_t>* updated_block_keys)
 {
-    const bool has_colour = colour_img_;
-    const bool has_semantics = class_img_;
-    constexpr int block_size = BlockType::getSize();
-    const Eigen::Matrix4f T_SW = math::to_inverse_transformation(T_WS_);
-    const Eigen::Matrix3f C_SW = math::to_rotation(T_SW);
+    updateBlocks(block_ptrs, updated_block_keys);
+    addGaussians();
+}
 
-#pragma omp parallel for
-    for (unsigned int i = 0; i < block_ptrs.size(); i++) {
-        BlockType& block = *static_cast<BlockType*>(block_ptrs[i]);
-        block.setTimeStamp(frame_);
-        const Eigen::Vector3i block_coord = block.getCoord();
-        Eigen::Vector3f point_base_W;
-        map_.voxelToPoint(block_coord, point_base_W);
-        const Eigen::Vector3f point_base_S = (T_SW * point_base_W.homogeneous()).head<3>();
-        const Eigen::Matrix3f point_delta_matrix_S = C_SW * map_.getRes();
-
-        for (unsigned int z = 0; z < block_size; ++z) {
-            for (unsigned int y = 0; y < block_size; ++y) {
-                for (unsigned int x = 0; x < block_size; ++x) {
-                    // Set voxel coordinates
-                    const Eigen::Vector3i voxel_coord = block_coord + Eigen::Vector3i(x, y, z);
-
-                    // Set sample point in camera frame
-                    const Eigen::Vector3f point_S = point_base_S + point_delta_matrix_S * Eigen::Vector3f(x, y, z);
-
-                    if (point_S.norm() > sensor_.farDist(point_S)) {
-                        continue;
-                    }
-
-                    // Project sample point to the image plane.
-                    Eigen::Vector2f pixel_f;
-                    if (sensor_.model.project(point_S, &pixel_f) != srl::projection::ProjectionStatus::Successful) {
-                        continue;
-                    }
-                    const Eigen::Vector2i pixel = se::round_pixel(pixel_f);
-                    const int pixel_idx = pixel.x() + depth_img_.width() * pixel.y();
-
-                    // Fetch the image value.
-                    const float depth_value = depth_img_[pixel_idx];
-
-                    if (depth_value < sensor_.near_plane) {
-                        continue;
-                    }
-
-                    // Update the TSDF
-                    const float m = sensor_.measurementFromPoint(point_S);
-                    const float sdf_value = point_S.norm() * (depth_value - m) / m;
-
-                    if (sdf_value > -config_.truncation_boundary) {
-                        DataType& data = block.getData(voxel_coord);
-
-                        updateVoxel(data, sdf_value);
-
-                        if constexpr (MapType::col_ == Colour::On) {
-                            if (has_colour) {
-                                updateVoxelColour(data, (*colour_img_)[pixel_idx]);
-                            }
-                        }
-                        if constexpr (MapType::sem_ != Semantics::Off) {
-                            if (has_semantics) {
-                                updateVoxelSemantics(data, (*class_img_)[pixel_idx]);
-                            }
-                        }
-                    }
-                } // x
-            }     // y
-        }         // z
+
+template<Colour ColB, Semantics SemB, int BlockSize, typename SensorT>
+void GSUpdater<Map<Data<Field::TSDF, ColB, SemB>, Res::Single, BlockSize>, SensorT>::updateBlocks(std::vector<OctantBase*>& block_ptrs,
+                                                                                                  std::vector<key_t>* updated_block_keys)
+{
+    updateBlocks({this}, block_ptrs, updated_block_keys);
+}
+
+
+template<Colour ColB, Semantics SemB, int BlockSize, typename SensorT>
+void GSUpdater<Map<Data<Field::TSDF, ColB, SemB>, Res::Single, BlockSize>, SensorT>::updateBlocks(const std::vector<GSUpdater*>& updaters,
+                                                                                                  std::vector<OctantBase*>& block_ptrs,
+                                                                                                  std::vector<key_t>* updated_block_keys)
+{
+    // The candidates depend on the weights before the sweep.
+    std::vector<const FrameUpdater<MapType, SensorT>*> frame_updaters;
+    for (GSUpdater* updater : updaters) {
+        updater->computeSeedCandidates();
+        frame_updaters.push_back(&updater->frame_updater_);
     }
+    FrameUpdater<MapType, SensorT>::updateBlocks(frame_updaters, block_ptrs, 1, updated_block_keys);
+    for (size_t i = 0; i < updaters.size(); i++) {
+        updaters[i]->selectSeeds({frame_updaters.begin(), frame_updaters.begin() + i});
+    }
+}
 
-    propagator::propagateTimeStampToRoot(block_ptrs);
 
+template<Colour ColB, Semantics SemB, int BlockSize, typename SensorT>
+void GSUpdater<Map<Data<Field::TSDF, ColB, SemB>, Res::Single, BlockSize>, SensorT>::computeSeedCandidates()
+{
     cv::Mat cv_src_img(colour_img_->height(), colour_img_->width(), CV_8UC3, color_data_.data());
-    data_packet_.rgb = cv_src_img;
 
-    gs::QTree qtree(gs_model_.optimParams.qtree_thresh, gs_model_.optimParams.qtree_min_pixel_size, cv_src_img);
+    // Wrap the cached integral images of the frame.
+    static_assert(sizeof(Eigen::Vector3d) == 3 * sizeof(double), "Eigen::Vector3d is laid out as 3 packed doubles");
+    const Image<Eigen::Vector3d>& colour_sum = frame_ctx_.colourSum();
+    const Image<Eigen::Vector3d>& colour_squared_sum = frame_ctx_.colourSquaredSum();
+    const cv::Mat cv_colour_sum(colour_sum.height(), colour_sum.width(), CV_64FC3, const_cast<Eigen::Vector3d*>(colour_sum.data()));
+    const cv::Mat cv_colour_squared_sum(colour_squared_sum.height(), colour_squared_sum.width(), CV_64FC3, const_cast<Eigen::Vector3d*>(colour_squared_sum.data()));
+    gs::QTree qtree(gs_model_.optimParams.qtree_thresh, gs_model_.optimParams.qtree_min_pixel_size, cv_src_img, cv_colour_sum, cv_colour_squared_sum);
     qtree.subdivide();
     std::vector<gs::Node> nodes = qtree.getAllNodes();
 
-    std::vector<gs::Point> positions(nodes.size());
-    std::vector<gs::Color> colors(nodes.size());
+    std::vector<SeedCandidate> candidates(nodes.size());
     std::vector<float> scales(nodes.size(), 0);
+    work::add(work::QuadtreeNodes, nodes.size());
 
-#pragma omp parallel for
+    size_t num_seed_candidates = 0;
+#pragma omp parallel for reduction(+ : num_seed_candidates)
     for (int i = 0; i < nodes.size(); i++) {
         gs::Node node = nodes[i];
 
@@ -191,92 +165,124 @@ void GSUpdater<Map<Data<Field::TSDF, ColB, SemB>, Res::Single, BlockSize>, Senso
         if (depth_value < sensor_.near_plane) {
             continue;
         }
+        num_seed_candidates++;
         center *= depth_value;
         center = (T_WS_ * center.homogeneous()).head<3>();
 
-        // Check the vicinity of the backprojected cell center in 3D space
-        auto center_data = map_.getData(center);
-        if (center_data.weight != 1) {
+        // Only a voxel unobserved before the update can be first observed by the frame
+        SeedCandidate& candidate = candidates[i];
+        if (!map_.template pointToVoxel<Safe::On>(center, candidate.voxel_coord)) {
+            continue;
+        }
+        if (visitor::getData(*map_.getOctree(), candidate.voxel_coord).weight != 0) {
+            continue;
+        }
+
+        const Eigen::Vector3f center_W = (T_WA_ * center.homogeneous()).head<3>();
+        if (seeded_region_ && seeded_region_(center_W)) {
             continue;
         }
 
         float length = sqrt(pow(0.5 * node.getWidth(), 2) + pow(0.5 * node.getHeight(), 2));
         float scale = (depth_value * length) / sensor_.model.focalLengthU();
         scales[i] = scale;
+        candidate.scale = scale;
 
-        gs::Point center_p3d;
-        center_p3d.x = center[0];
-        center_p3d.y = center[1];
-        center_p3d.z = center[2];
-        positions[i] = center_p3d;
+        candidate.position.x = center_W[0];
+        candidate.position.y = center_W[1];
+        candidate.position.z = center_W[2];
 
         auto center_rgb = (*colour_img_)[pixel_idx];
-        gs::Color center_color;
-        center_color.r = center_rgb.r;
-        center_color.g = center_rgb.g;
-        center_color.b = center_rgb.b;
-        colors[i] = center_color;
+        candidate.color.r = center_rgb.r;
+        candidate.color.g = center_rgb.g;
+        candidate.color.b = center_rgb.b;
     }
 
+    work::add(work::SeedCandidates, num_seed_candidates);
+
     // Filter out invalid cells
-    std::vector<gs::Point> valid_positions;
-    std::vector<gs::Color> valid_colors;
-    std::vector<float> valid_scales;
+    seed_candidates_.clear();
     for (int i = 0; i < scales.size(); i++) {
         if (scales[i] > 0) {
-            valid_positions.push_back(positions[i]);
-            valid_colors.push_back(colors[i]);
-            valid_scales.push_back(scales[i]);
+            seed_candidates_.push_back(candidates[i]);
         }
     }
-
-    // Update keyframe list
-    if (valid_positions.size() > gs_model_.optimParams.kf_thresh) {
-        isKeyframe_ = true;
-    }
-    else {
-        // Only keep non-keyframes for ScanNet++ dataset
-        if (!gs_model_.optimParams.keep_all_frames) {
-            gs_cam_list_.pop_back();
-            gt_img_list_.pop_back();
-        }
-    }
-
-    updateGSModel(valid_positions, valid_colors, valid_scales);
 }
 
 
 template<Colour ColB, Semantics SemB, int BlockSize, typename SensorT>
-void GSUpdater<Map<Data<Field::TSDF, ColB, SemB>, Res::Single, BlockSize>, SensorT>::updateVoxel(DataType& data, float sdf_value)
+void GSUpdater<Map<Data<Field::TSDF, ColB, SemB>, Res::Single, BlockSize>, SensorT>::selectSeeds(const std::vector<const FrameUpdater<MapType, SensorT>*>& earlier_updaters)
 {
-    weight::increment(data.weight, map_.getDataConfig().max_weight);
-    const tsdf_t tsdf_value = math::clamp(sdf_value / config_.truncation_boundary, -1.0f, 1.0f) * tsdf_t_scale;
-    data.tsdf = (data.tsdf * (data.weight - 1) + tsdf_value) / data.weight;
+    std::vector<uint8_t> is_seed(seed_candidates_.size(), 0);
+#pragma omp parallel for
+    for (int i = 0; i < seed_candidates_.size(); i++) {
+        const Eigen::Vector3i& voxel_coord = seed_candidates_[i].voxel_coord;
+        // The weight is zero if the block of the voxel wasn't updated.
+        if (visitor::getData(*map_.getOctree(), voxel_coord).weight == 0) {
+            continue;
+        }
+        const Eigen::Vector3i block_coord = voxel_coord / BlockSize * BlockSize;
+        const Eigen::Vector3i voxel_offset = voxel_coord - block_coord;
+        float sdf_value;
+        int pixel_idx;
+        if (!frame_updater_.measure(frame_updater_.sensorPoint(block_coord, voxel_offset), sdf_value, pixel_idx)) {
+            continue;
+        }
+        bool measured_before = false;
+        for (const FrameUpdater<MapType, SensorT>* updater : earlier_updaters) {
+            if (updater->measure(updater->sensorPoint(block_coord, voxel_offset), sdf_value, pixel_idx)) {
+                measured_before = true;
+                break;
+            }
+        }
+        is_seed[i] = !measured_before;
+    }
+
+    std::vector<SeedCandidate> seeds;
+    for (size_t i = 0; i < seed_candidates_.size(); i++) {
+        if (is_seed[i]) {
+            seeds.push_back(seed_candidates_[i]);
+        }
+    }
+    seed_candidates_.swap(seeds);
 }
 
 
 template<Colour ColB, Semantics SemB, int BlockSize, typename SensorT>
-void GSUpdater<Map<Data<Field::TSDF, ColB, SemB>, Res::Single, BlockSize>, SensorT>::updateVoxelColour(DataType& data, rgb_t colour_value)
+void GSUpdater<Map<Data<Field::TSDF, ColB, SemB>, Res::Single, BlockSize>, SensorT>::addGaussians()
 {
-    // Use if instead of std::min to prevent overflow.
-    if (data.rgb_weight < map_.getDataConfig().max_weight) {
-        data.rgb_weight++;
+    // Add the frame to the keyframe list, it is removed below if it doesn't turn out to be one
+    gs_cam_list_.push_back(cur_gs_cam_);
+    gt_img_list_.push_back(cur_gt_img_);
+
+    if (data_mailbox_.isEnabled()) {
+        // The packet outlives color_data_
+        cv::Mat cv_src_img(colour_img_->height(), colour_img_->width(), CV_8UC3, color_data_.data());
+        data_packet_.rgb = cv_src_img.clone();
     }
-    // No overflow occurs due to integral promotion to int or unsigned int during arithmetic operations.
-    data.rgb.r = (data.rgb.r * (data.rgb_weight - 1) + colour_value.r) / data.rgb_weight;
-    data.rgb.g = (data.rgb.g * (data.rgb_weight - 1) + colour_value.g) / data.rgb_weight;
-    data.rgb.b = (data.rgb.b * (data.rgb_weight - 1) + colour_value.b) / data.rgb_weight;
-}
 
+    std::vector<gs::Point> valid_positions;
+    std::vector<gs::Color> valid_colors;
+    std::vector<float> valid_scales;
+    for (const SeedCandidate& seed : seed_candidates_) {
+        valid_positions.push_back(seed.position);
+        valid_colors.push_back(seed.color);
+        valid_scales.push_back(seed.scale);
+    }
 
-template<Colour ColB, Semantics SemB, int BlockSize, typename SensorT>
-void GSUpdater<Map<Data<Field::TSDF, ColB, SemB>, Res::Single, BlockSize>, SensorT>::updateVoxelSemantics(DataType& data, semantics_t class_id)
-{
-    // Use if instead of std::min to prevent overflow.
-    if (data.sem_weight < map_.getDataConfig().max_weight) {
-        data.sem_weight++;
+    // Update keyframe list
+    if (valid_positions.size() > gs_model_.optimParams.kf_thresh) {
+        isKeyframe_ = true;
+    }
+    else {
+        // Only keep non-keyframes for ScanNet++ dataset
+        if (!gs_model_.optimParams.keep_all_frames) {
+            gs_cam_list_.pop_back();
+            gt_img_list_.pop_back();
+        }
     }
-    data.sem.merge(class_id, data.sem_weight);
+
+    updateGSModel(valid_positions, valid_colors, valid_scales);
 }
 
 
@@ -288,6 +294,11 @@ void GSUpdater<Map<Data<Field::TSDF, ColB, SemB>, Res::Single, BlockSize>, Senso
         torch::NoGradGuard no_grad;
         gs_model_.Add_gaussians(positions, colors, scales);
     }
+    work::add(work::GaussiansAdded, positions.size());
+
+    // Count the visible Gaussians on the GPU to avoid synchronizing after every render
+    torch::Tensor num_visible = torch::zeros({}, torch::TensorOptions().dtype(torch::kLong).device(torch::kCUDA));
+    int num_steps = 0;
 
     int iters = gs_model_.optimParams.kf_iters;
     if (!isKeyframe_) {
@@ -299,6 +310,7 @@ void GSUpdater<Map<Data<Field::TSDF, ColB, SemB>, Res::Single, BlockSize>, Senso
     // Start online optimization
     for (int iter = 0; iter < iters; iter++) {
         auto [image, viewspace_point_tensor, visibility_filter, radii] = gs::render(cur_gs_cam_, gs_model_);
+        num_visible += visibility_filter.sum();
 
         // Loss Computations
         auto loss = gs::l1_loss(image, cur_gt_img_);
@@ -307,13 +319,15 @@ void GSUpdater<Map<Data<Field::TSDF, ColB, SemB>, Res::Single, BlockSize>, Senso
         loss.backward();
         gs_model_.optimizer->step();
         gs_model_.optimizer->zero_grad(true);
+        num_steps++;
 
         // Store the cv::Mat rendered image for visualization
-        if (iter == iters - 1) {
+        if (iter == iters - 1 && data_mailbox_.isEnabled()) {
             auto rendered_img_tensor = image.detach().permute({1, 2, 0}).contiguous().to(torch::kCPU);
             rendered_img_tensor = rendered_img_tensor.mul(255).clamp(0, 255).to(torch::kU8);
             auto cv_rendered_img = cv::Mat(image.size(1), image.size(2), CV_8UC3, rendered_img_tensor.data_ptr());
-            data_packet_.rendered_rgb = cv_rendered_img;
+            // The packet outlives rendered_img_tensor
+            data_packet_.rendered_rgb = cv_rendered_img.clone();
         }
     }
 
@@ -327,21 +341,27 @@ void GSUpdater<Map<Data<Field::TSDF, ColB, SemB>, Res::Single, BlockSize>, Senso
             auto kf_gs_cam = gs_cam_list_[kf_indices[i]];
 
             auto [image, viewspace_point_tensor, visibility_filter, radii] = gs::render(kf_gs_cam, gs_model_);
+            num_visible += visibility_filter.sum();
             auto loss = gs::l1_loss(image, kf_gt_img);
             loss.backward();
             gs_model_.optimizer->step();
             gs_model_.optimizer->zero_grad(true);
+            num_steps++;
         }
     }
 
     // Collect mapping statistics
     torch::cuda::synchronize();
     end_time_ = PerfStats::getTime();
-    data_packet_.fps = 1 / (end_time_ - start_time_);
-    data_packet_.ID = frame_;
-    data_packet_.num_splats = gs_model_.Get_size();
-    data_packet_.num_kf = gt_img_list_.size();
-    data_queue_.push(data_packet_);
+    work::add(work::SplatsRendered, num_visible.item<int64_t>());
+    work::add(work::OptimizerSteps, num_steps);
+    if (data_mailbox_.isEnabled()) {
+        data_packet_.fps = 1 / (end_time_ - start_time_);
+        data_packet_.ID = frame_;
+        data_packet_.num_splats = gs_model_.Get_size();
+        data_packet_.num_kf = gt_img_list_.size();
+        data_mailbox_.push(std::move(data_packet_));
+    }
 }
 
 } // namespace se
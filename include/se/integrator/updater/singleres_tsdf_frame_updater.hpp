@@ -0,0 +1,154 @@
+/*
+ * SPDX-FileCopyrightText: 2016-2019 Emanuele Vespa
+ * SPDX-FileCopyrightText: 2021 Smart Robotics Lab, Imperial College London, Technical University of Munich
+ * SPDX-FileCopyrightText: 2021 Nils Funk
+ * SPDX-FileCopyrightText: 2021 Sotiris Papatheodorou
+ * SPDX-FileCopyrightText: 2024 Smart Robotics Lab, Technical University of Munich
+ * SPDX-FileCopyrightText: 2024 Jiaxin Wei
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef SE_SINGLERES_TSDF_FRAME_UPDATER_HPP
+#define SE_SINGLERES_TSDF_FRAME_UPDATER_HPP
+
+
+#include "se/map/map.hpp"
+#include "se/sensor/sensor.hpp"
+
+
+namespace se {
+
+/**
+ * \brief The state needed to reverse the TSDF update of a single frame. The images are copied since
+ * the readers reuse their buffers between frames. Returned by se::integrator::integrate().
+ */
+struct IntegratedFrame {
+    IntegratedFrame(const Image<float>& depth_img, const Image<rgb_t>& colour_img, const Eigen::Matrix4f& T_WS, const int frame) :
+            depth_img(depth_img), colour_img(colour_img), T_WS(T_WS), frame(frame)
+    {
+    }
+
+    Image<float> depth_img;
+    Image<rgb_t> colour_img;
+    Eigen::Matrix4f T_WS;
+    int frame;
+    /** The keys of the blocks at least one voxel of the frame was fused into. */
+    std::vector<key_t> block_keys;
+
+    EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+};
+
+
+// Single-res TSDF frame updater without the Gaussian splatting stage
+template<Colour ColB, Semantics SemB, int BlockSize, typename SensorT>
+class FrameUpdater<Map<Data<Field::TSDF, ColB, SemB>, Res::Single, BlockSize>, SensorT> {
+    public:
+    typedef Map<Data<Field::TSDF, ColB, SemB>, Res::Single, BlockSize> MapType;
+    typedef typename MapType::DataType DataType;
+    typedef typename MapType::OctreeType::NodeType NodeType;
+    typedef typename MapType::OctreeType::BlockType BlockType;
+
+    struct FrameUpdaterConfig {
+        FrameUpdaterConfig(const MapType& map) : truncation_boundary(map.getRes() * map.getDataConfig().truncation_boundary_factor)
+        {
+        }
+
+        const float truncation_boundary;
+    };
+
+    /**
+     * \param[in]  map         The reference to the map to be updated.
+     * \param[in]  sensor      The sensor model.
+     * \param[in]  depth_img   The depth image to be (de-)integrated.
+     * \param[in]  colour_img  The colour image to be (de-)integrated or nullptr if none.
+     * \param[in]  class_img   The semantic class image to be integrated or nullptr if none.
+     * \param[in]  T_WS        The transformation from sensor to world frame.
+     * \param[in]  frame       The frame number used to time stamp the updated blocks.
+     */
+    FrameUpdater(MapType& map,
+                 const SensorT& sensor,
+                 const Image<float>& depth_img,
+                 const Image<rgb_t>* colour_img,
+                 const Image<semantics_t>* class_img,
+                 const Eigen::Matrix4f& T_WS,
+                 const int frame);
+
+    /**
+     * \brief Fuse the frame into the voxels of the provided blocks.
+     *
+     * \param[in]  block_ptrs         The blocks to update.
+     * \param[out] updated_block_keys If not nullptr, the keys of the blocks with at least one
+     *                                updated voxel are appended to it.
+     */
+    void integrate(std::vector<OctantBase*>& block_ptrs, std::vector<key_t>* updated_block_keys = nullptr);
+
+    /**
+     * \brief Remove the contribution of a previously integrated frame from the voxels of the
+     * provided blocks. The frame must be de-integrated with the same depth, colour and pose it was
+     * integrated with. Semantics are not de-integrated. Voxels whose weight reached max_weight
+     * are only approximately restored, see se::integrator::deintegrate().
+     */
+    void deintegrate(std::vector<OctantBase*>& block_ptrs);
+
+    /**
+     * \brief Update the blocks from several frames in a single sweep, e.g. the frames of the
+     * sensors of a rig or consecutive frames of a single sensor. Each voxel fuses the measurements of
+     * all updaters before moving to the next one, in the order of \p updaters, so the result equals
+     * calling integrate() or deintegrate() for each updater in turn while each block is only visited
+     * once. The blocks are time stamped with the latest frame.
+     *
+     * \param[in]  updaters           The updaters of each frame, all updating the same map.
+     * \param[in]  block_ptrs         The blocks to update.
+     * \param[in]  sign               1 to fuse the frames, -1 to remove them.
+     * \param[out] updated_block_keys If not nullptr, the keys of the blocks with at least one
+     *                                updated voxel are appended to it.
+     */
+    static void updateBlocks(const std::vector<const FrameUpdater*>& updaters,
+                             std::vector<OctantBase*>& block_ptrs,
+                             const int sign,
+                             std::vector<key_t>* updated_block_keys = nullptr);
+
+    /**
+     * \brief Return the point at the voxel of \p block_coord at \p voxel_offset in the sensor
+     * frame, computed the same way as by updateBlocks().
+     */
+    Eigen::Vector3f sensorPoint(const Eigen::Vector3i& block_coord, const Eigen::Vector3i& voxel_offset) const;
+
+    /**
+     * \brief Return whether the voxel at \p point_S in the sensor frame is measured by the frame,
+     * i.e. whether it projects onto a valid depth and is in front of the truncation band.
+     * \p sdf_value and \p pixel_idx are set if it is.
+     */
+    bool measure(const Eigen::Vector3f& point_S, float& sdf_value, int& pixel_idx) const;
+
+    /**
+     * \brief Fuse (\p sign 1) or remove (\p sign -1) the measurement of the frame into the voxel at
+     * \p point_S in the sensor frame. Return whether the voxel was updated.
+     */
+    bool fuseVoxel(DataType& data, const Eigen::Vector3f& point_S, const int sign) const;
+
+    EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+
+    private:
+    void updateVoxel(DataType& data, float sdf_value) const;
+    void updateVoxelColour(DataType& data, rgb_t colour_value) const;
+    void updateVoxelSemantics(DataType& data, semantics_t class_id) const;
+    void removeVoxel(DataType& data, float sdf_value) const;
+    void removeVoxelColour(DataType& data, rgb_t colour_value) const;
+
+    MapType& map_;
+    const SensorT& sensor_;
+    const Image<float>& depth_img_;
+    const Image<rgb_t>* colour_img_;
+    const Image<semantics_t>* class_img_;
+    const Eigen::Matrix4f& T_WS_;
+    const Eigen::Matrix4f T_SW_;
+    const int frame_;
+    const FrameUpdaterConfig config_;
+};
+
+} // namespace se
+
+#include "impl/singleres_tsdf_frame_updater_impl.hpp"
+
+#endif // SE_SINGLERES_TSDF_FRAME_UPDATER_HPP
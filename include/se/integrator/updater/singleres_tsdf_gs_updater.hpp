@@ -17,6 +17,7 @@
 #include "gs/gaussian.cuh"
 #include "gs/gaussian_utils.cuh"
 #include "gs/quad_tree.cuh"
+#include "se/map/frame_context.hpp"
 #include "se/map/map.hpp"
 #include "se/sensor/sensor.hpp"
 
@@ -32,62 +33,111 @@ class GSUpdater<Map<Data<Field::TSDF, ColB, SemB>, Res::Single, BlockSize>, Sens
     typedef typename MapType::OctreeType::NodeType NodeType;
     typedef typename MapType::OctreeType::BlockType BlockType;
 
-    struct GSUpdaterConfig {
-        GSUpdaterConfig(const MapType& map) : truncation_boundary(map.getRes() * map.getDataConfig().truncation_boundary_factor)
-        {
-        }
-
-        const float truncation_boundary;
-    };
-
     /**
      * \param[in]  map         The reference to the map to be updated.
-     * \param[in]  sensor      The sensor model.
+     * \param[in]  frame_ctx   The context of the frame to be integrated. It provides the sensor
+     *                         model, the depth and colour images and the colour integral images
+     *                         used for seeding. The frame must have colour.
      * \param[in]  gs_model    The Gaussian model.
      * \param[in]  gs_cam_list The keyframe list of gs::Camera to store camera parameters.
      * \param[in]  gt_img_list The keyframe list of torch::Tensor to store color images.
-     * \param[in]  data_queue  The queue to store visualization data for GUI
-     * \param[in]  depth_img   The depth image to be integrated.
-     * \param[in]  colour_img  The colour image to be integrated or nullptr if none.
+     * \param[in]  data_mailbox  The mailbox receiving visualization data for the GUI
      * \param[in]  class_img   The semantic class image to be integrated or nullptr if none.
      * \param[in]  T_WS        The transformation from sensor to world frame.
      * \param[in]  frame       The frame number to be integrated.
+     * \param[in]  T_WA        The transformation from the frame the map is expressed in to the world
+     *                         frame, e.g. the anchor of a submap. The TSDF is updated using T_WS
+     *                         while the Gaussians and cameras are expressed in the world frame.
+     * \param[in]  seeded_region The region where no Gaussians are seeded because it is already
+     *                           covered, see se::SeededRegion.
      */
     GSUpdater(MapType& map,
-              const SensorT& sensor,
+              FrameContext<SensorT>& frame_ctx,
               gs::GaussianModel& gs_model,
               std::vector<gs::Camera>& gs_cam_list,
               std::vector<torch::Tensor>& gt_img_list,
-              gs::DataQueue& data_queue,
-              const Image<float>& depth_img,
-              const Image<rgb_t>* colour_img,
+              gs::DataMailbox& data_mailbox,
               const Image<semantics_t>* class_img,
               const Eigen::Matrix4f& T_WS,
-              const int frame);
+              const int frame,
+              const Eigen::Matrix4f& T_WA = Eigen::Matrix4f::Identity(),
+              const SeededRegion& seeded_region = SeededRegion());
+
+    /**
+     * \brief Update the TSDF of the blocks and then add and optimize the Gaussians of the frame.
+     *
+     * \param[in]  block_ptrs         The blocks to update.
+     * \param[out] updated_block_keys If not nullptr, the keys of the blocks with at least one
+     *                                updated voxel are appended to it.
+     */
+    void operator()(std::vector<OctantBase*>& block_ptrs, std::vector<key_t>* updated_block_keys = nullptr);
 
-    void operator()(std::vector<OctantBase*>& block_ptrs);
+    /**
+     * \brief Update the TSDF, colour and semantics of the voxels in \p block_ptrs from the frame,
+     * see FrameUpdater::integrate(), and select the voxels the frame seeds Gaussians in.
+     */
+    void updateBlocks(std::vector<OctantBase*>& block_ptrs, std::vector<key_t>* updated_block_keys = nullptr);
+
+    /**
+     * \brief Update the blocks from several frames in a single sweep, see
+     * FrameUpdater::updateBlocks(). Each frame seeds Gaussians in the voxels it takes from zero to
+     * non-zero weight, i.e. those unobserved before the sweep that it measures and no earlier
+     * updater measures. Both the TSDF and the seeded voxels equal calling updateBlocks() and
+     * addGaussians() for each updater in turn.
+     *
+     * \param[in]  updaters           The updaters of each frame, all integrating into the same map.
+     * \param[in]  block_ptrs         The blocks to update.
+     * \param[out] updated_block_keys If not nullptr, the keys of the blocks with at least one
+     *                                updated voxel are appended to it.
+     */
+    static void updateBlocks(const std::vector<GSUpdater*>& updaters, std::vector<OctantBase*>& block_ptrs, std::vector<key_t>* updated_block_keys = nullptr);
+
+    /** Seed the Gaussians selected by updateBlocks(), update the keyframe list and optimize the
+     * Gaussian model.
+     */
+    void addGaussians();
 
     EIGEN_MAKE_ALIGNED_OPERATOR_NEW
 
     private:
-    void updateVoxel(DataType& data, float sdf_value);
-    void updateVoxelColour(DataType& data, rgb_t colour_value);
-    void updateVoxelSemantics(DataType& data, semantics_t class_id);
+    /** A quadtree cell centre of the frame that may seed a Gaussian. */
+    struct SeedCandidate {
+        /** The voxel the cell centre backprojects to. */
+        Eigen::Vector3i voxel_coord;
+        gs::Point position;
+        gs::Color color;
+        float scale;
+    };
+
+    /** Compute the seed candidates of the frame, the cell centres in voxels unobserved before the
+     * blocks are updated and outside the seeded region.
+     */
+    void computeSeedCandidates();
+
+    /** Keep the seed candidates whose voxel the frame takes from zero to non-zero weight, i.e. that
+     * it measures, that were updated and that none of \p earlier_updaters measures.
+     */
+    void selectSeeds(const std::vector<const FrameUpdater<MapType, SensorT>*>& earlier_updaters);
+
     void updateGSModel(std::vector<gs::Point>& positions, std::vector<gs::Color>& colors, std::vector<float>& scales);
 
     MapType& map_;
+    FrameContext<SensorT>& frame_ctx_;
     const SensorT& sensor_;
     const Image<float>& depth_img_;
     const Image<rgb_t>* colour_img_;
-    const Image<semantics_t>* class_img_;
     const Eigen::Matrix4f& T_WS_;
     const int frame_;
-    const GSUpdaterConfig config_;
+    const Eigen::Matrix4f T_WA_;
+    const SeededRegion seeded_region_;
+    /** Fuses the TSDF, colour and semantics of the frame. */
+    FrameUpdater<MapType, SensorT> frame_updater_;
+    std::vector<SeedCandidate> seed_candidates_;
 
     gs::GaussianModel& gs_model_;
     std::vector<gs::Camera>& gs_cam_list_;
     std::vector<torch::Tensor>& gt_img_list_;
-    gs::DataQueue& data_queue_;
+    gs::DataMailbox& data_mailbox_;
     gs::DataPacket data_packet_;
     gs::Camera cur_gs_cam_;
     torch::Tensor cur_gt_img_;
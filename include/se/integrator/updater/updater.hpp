@@ -10,23 +10,30 @@
 #ifndef SE_UPDATER_HPP
 #define SE_UPDATER_HPP
 
+#include <functional>
+
 
 namespace se {
 
+/** Return whether Gaussians have already been seeded around a point in the world frame W, e.g. by
+ * the frames integrated into an earlier submap. An empty function seeds everywhere.
+ */
+typedef std::function<bool(const Eigen::Vector3f& point_W)> SeededRegion;
+
 template<typename MapT, typename SensorT>
 class GSUpdater {
     public:
     GSUpdater(MapT& map,
-              const SensorT& sensor,
+              FrameContext<SensorT>& frame_ctx,
               gs::GaussianModel& gs_model,
               std::vector<gs::Camera>& gs_cam_list,
               std::vector<torch::Tensor>& gt_img_list,
-              gs::DataQueue& data_queue,
-              const se::Image<float>& depth_img,
-              const se::Image<rgb_t>* colour_img,
+              gs::DataMailbox& data_mailbox,
               const Image<semantics_t>* class_img,
               const Eigen::Matrix4f& T_WS,
-              const int frame);
+              const int frame,
+              const Eigen::Matrix4f& T_WA = Eigen::Matrix4f::Identity(),
+              const SeededRegion& seeded_region = SeededRegion());
 
     template<typename UpdateListT>
     void operator()(UpdateListT& updating_list);
@@ -36,8 +43,31 @@ template<se::Colour ColB, se::Semantics SemB, int BlockSize, typename SensorT>
 class GSUpdater<Map<Data<se::Field::TSDF, ColB, SemB>, se::Res::Single, BlockSize>, SensorT>;
 
 
+template<typename MapT, typename SensorT>
+class FrameUpdater {
+    public:
+    FrameUpdater(MapT& map,
+                 const SensorT& sensor,
+                 const se::Image<float>& depth_img,
+                 const se::Image<rgb_t>* colour_img,
+                 const se::Image<semantics_t>* class_img,
+                 const Eigen::Matrix4f& T_WS,
+                 const int frame);
+
+    template<typename UpdateListT>
+    void integrate(UpdateListT& updating_list);
+
+    template<typename UpdateListT>
+    void deintegrate(UpdateListT& updating_list);
+};
+
+template<se::Colour ColB, se::Semantics SemB, int BlockSize, typename SensorT>
+class FrameUpdater<Map<Data<se::Field::TSDF, ColB, SemB>, se::Res::Single, BlockSize>, SensorT>;
+
+
 } // namespace se
 
+#include "singleres_tsdf_frame_updater.hpp"
 #include "singleres_tsdf_gs_updater.hpp"
 
 #endif // SE_UPDATER_HPP
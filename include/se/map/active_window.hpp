@@ -0,0 +1,167 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Smart Robotics Lab, Technical University of Munich
+ * SPDX-FileCopyrightText: 2024 Jiaxin Wei
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef SE_ACTIVE_WINDOW_HPP
+#define SE_ACTIVE_WINDOW_HPP
+
+#include <array>
+#include <map>
+#include <unordered_set>
+#include <vector>
+
+#include "se/map/io/change_feed.hpp"
+#include "se/map/map.hpp"
+#include "se/map/octree/allocator.hpp"
+#include "se/map/octree/iterator.hpp"
+#include "se/map/octree/propagator.hpp"
+
+
+namespace se {
+
+/**
+ * \brief Maintain a sliding active region of MapConfig::active_radius metres around the sensor so
+ * that the per-frame cost and the memory used by the octree don't grow with the trajectory length.
+ * The total memory still grows with the explored volume: compressedBytes() in compress mode and
+ * discardedBytes() in discard mode.
+ *
+ * The integrator only fetches and allocates blocks whose centre is inside the active region of the
+ * map. update() finalises the allocated blocks whose centre left the active region: their mesh is
+ * optionally extracted, then they are either compressed and kept outside the octree or discarded,
+ * see MapConfig::compress_inactive. Compressed blocks are restored losslessly when their centre
+ * re-enters the active region. Only the unobserved voxels are dropped by the compression, so
+ * its ratio depends on how much of each block was observed.
+ *
+ * The compressed blocks are grouped into cells of about the active radius so that restoring only
+ * visits the cells around the sensor.
+ *
+ * Discarded blocks are allocated again unobserved when they re-enter the active region, so pass
+ * discarded() as the se::SeededRegion of the integrator to avoid seeding Gaussians there again.
+ * The keys of the discarded observed blocks are kept for this, see discardedBytes().
+ */
+template<typename MapT>
+class ActiveWindow {
+    public:
+    typedef typename MapT::OctreeType OctreeType;
+    typedef typename OctreeType::BlockType BlockType;
+    typedef typename OctreeType::MeshType MeshType;
+    typedef typename MapT::DataType DataType;
+
+    static_assert(MapT::fld_ == Field::TSDF && MapT::res_ == Res::Single, "ActiveWindow supports single-resolution TSDF maps only");
+
+    /**
+     * \param[in] map      The map whose active region is maintained.
+     * \param[in] compress Whether the blocks leaving the active region are compressed and restored
+     *                     later or discarded.
+     */
+    ActiveWindow(const MapT& map, const bool compress);
+
+    /**
+     * \brief Move the active region of \p map to the sensor position \p t_WS. Call it before
+     * integrating each frame.
+     *
+     * Compressed blocks whose centre is inside the active region are restored and allocated blocks
+     * whose centre is outside it are finalised. Faces between a finalised block and the blocks
+     * finalised at earlier calls are missing from the finalised meshes. A block that re-enters
+     * and leaves the active region again is meshed again.
+     *
+     * \param[in]  map              The map the window was constructed with.
+     * \param[in]  t_WS             The sensor position in the world frame in metres.
+     * \param[out] finalised_mesh_M If not nullptr, the mesh of the finalised blocks is appended to
+     *                              it, in the map frame in units of voxels like the output of
+     *                              se::algorithms::marching_cube_kernel().
+     * \param[out] change_feed      If not nullptr, the finalised blocks are forgotten by it so that
+     *                              its subscribers mirror the active region only. A restored block
+     *                              is sent to them again once it is updated.
+     * \return The number of finalised blocks.
+     */
+    size_t update(MapT& map, const Eigen::Vector3f& t_WS, MeshType* finalised_mesh_M = nullptr, io::ChangeFeed<MapT>* change_feed = nullptr);
+
+    /**
+     * \brief Return whether \p point_W is in an observed block discarded by update(). Always false
+     * when the blocks are compressed.
+     */
+    bool discarded(const MapT& map, const Eigen::Vector3f& point_W) const;
+
+    /**
+     * \brief Return the number of blocks currently kept compressed outside the octree.
+     */
+    size_t numCompressedBlocks() const
+    {
+        return num_compressed_blocks_;
+    }
+
+    /**
+     * \brief Return the number of bytes used by the compressed blocks.
+     */
+    size_t compressedBytes() const
+    {
+        return compressed_bytes_;
+    }
+
+    /**
+     * \brief Return an estimate of the number of bytes used to remember the discarded blocks, see
+     * discarded().
+     */
+    size_t discardedBytes() const
+    {
+        // Each element is a heap node holding the key and the next pointer, plus the bucket array
+        return discarded_keys_.size() * (sizeof(key_t) + sizeof(void*)) + discarded_keys_.bucket_count() * sizeof(void*);
+    }
+
+    /**
+     * \brief Return the number of blocks restored by the last call to update().
+     */
+    size_t numRestoredBlocks() const
+    {
+        return num_restored_blocks_;
+    }
+
+    private:
+    typedef std::array<int, 3> CellKey;
+
+    struct CompressedBlock {
+        Eigen::Vector3i coord;
+        timestamp_t timestamp;
+        /** One bit per voxel in block data order, set for the voxels stored in data. */
+        std::vector<uint8_t> observed_mask;
+        /** The data of the observed voxels in block data order. */
+        std::vector<DataType> data;
+
+        size_t bytes() const
+        {
+            return sizeof(CompressedBlock) + observed_mask.capacity() + data.capacity() * sizeof(DataType);
+        }
+    };
+
+    CellKey cellKey(const Eigen::Vector3i& block_coord) const;
+
+    bool isActive(const MapT& map, const Eigen::Vector3i& block_coord, const Eigen::Vector3f& t_WS) const;
+
+    void restore(MapT& map, const Eigen::Vector3f& t_WS);
+
+    void compress(const BlockType& block);
+
+    static bool isUnobserved(const BlockType& block);
+
+    static bool isUnobserved(const DataType& data);
+
+    const float radius_;
+    const bool compress_;
+    /** The edge length of the cells in voxels, a multiple of the block size. */
+    const int cell_size_;
+    std::map<CellKey, std::vector<CompressedBlock>> cells_;
+    /** The keys of the discarded blocks with observed voxels. */
+    std::unordered_set<key_t> discarded_keys_;
+    size_t num_compressed_blocks_;
+    size_t compressed_bytes_;
+    size_t num_restored_blocks_;
+};
+
+} // namespace se
+
+#include "impl/active_window_impl.hpp"
+
+#endif // SE_ACTIVE_WINDOW_HPP
@@ -0,0 +1,366 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Smart Robotics Lab, Technical University of Munich
+ * SPDX-FileCopyrightText: 2024 Jiaxin Wei
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef SE_MESH_DECIMATION_IMPL_HPP
+#define SE_MESH_DECIMATION_IMPL_HPP
+
+#include <Eigen/LU>
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+
+namespace se {
+namespace meshing {
+
+template<typename FaceT>
+DecimationPatch<FaceT>::DecimationPatch(const Mesh<FaceT>& mesh, const std::vector<size_t>& face_idxs, const float weld_dist) :
+        mesh_(mesh), num_faces_(0)
+{
+    static_assert(FaceT::num_vertexes == 3, "Only triangle meshes can be decimated");
+
+    // Weld the duplicated vertices of the face list into an indexed mesh.
+    std::unordered_map<Eigen::Vector3i, int, Vector3iHash> vertex_indices;
+    faces_.reserve(face_idxs.size());
+    face_sources_.reserve(face_idxs.size());
+    for (const size_t face_idx : face_idxs) {
+        const FaceT& face = mesh[face_idx];
+        std::array<int, 3> indices;
+        for (size_t i = 0; i < 3; i++) {
+            const Eigen::Vector3i key = (face.vertexes[i] / weld_dist).array().round().template cast<int>().matrix();
+            const auto [it, inserted] = vertex_indices.emplace(key, positions_.size());
+            if (inserted) {
+                positions_.push_back(face.vertexes[i]);
+                if constexpr (FaceT::colour) {
+                    colours_.push_back(face.vertex_colours[i]);
+                }
+            }
+            indices[i] = it->second;
+        }
+        // Faces that became degenerate after welding carry no area and only complicate the topology.
+        if (indices[0] == indices[1] || indices[1] == indices[2] || indices[2] == indices[0]) {
+            continue;
+        }
+        faces_.push_back(indices);
+        face_sources_.push_back(face_idx);
+    }
+    num_faces_ = faces_.size();
+    face_alive_.assign(faces_.size(), true);
+
+    const size_t num_vertices = positions_.size();
+    quadrics_.assign(num_vertices, Eigen::Matrix4d::Zero());
+    locked_.assign(num_vertices, false);
+    removed_.assign(num_vertices, false);
+    versions_.assign(num_vertices, 0);
+    vertex_faces_.resize(num_vertices);
+
+    // Count how many faces use each edge. Edges used by a single face are on the patch boundary.
+    std::unordered_map<uint64_t, int> edge_face_count;
+    const auto edge_key = [](const int v_0, const int v_1) {
+        return (static_cast<uint64_t>(std::min(v_0, v_1)) << 32) | static_cast<uint64_t>(std::max(v_0, v_1));
+    };
+    for (size_t f = 0; f < faces_.size(); f++) {
+        const std::array<int, 3>& face = faces_[f];
+        const Eigen::Vector3d p_0 = positions_[face[0]].template cast<double>();
+        const Eigen::Vector3d p_1 = positions_[face[1]].template cast<double>();
+        const Eigen::Vector3d p_2 = positions_[face[2]].template cast<double>();
+        Eigen::Vector3d normal = (p_1 - p_0).cross(p_2 - p_0);
+        const double normal_norm = normal.norm();
+        Eigen::Matrix4d face_quadric = Eigen::Matrix4d::Zero();
+        if (normal_norm > 0.0) {
+            normal /= normal_norm;
+            const Eigen::Vector4d plane(normal.x(), normal.y(), normal.z(), -normal.dot(p_0));
+            face_quadric = plane * plane.transpose();
+        }
+        for (size_t i = 0; i < 3; i++) {
+            quadrics_[face[i]] += face_quadric;
+            vertex_faces_[face[i]].push_back(f);
+            edge_face_count[edge_key(face[i], face[(i + 1) % 3])]++;
+        }
+    }
+    for (const auto& [key, count] : edge_face_count) {
+        if (count != 2) {
+            locked_[key >> 32] = true;
+            locked_[key & 0xFFFFFFFF] = true;
+        }
+    }
+
+    for (const auto& edge : edge_face_count) {
+        Collapse collapse;
+        if (computeCollapse(edge.first >> 32, edge.first & 0xFFFFFFFF, collapse)) {
+            heap_.push(collapse);
+        }
+    }
+}
+
+
+template<typename FaceT>
+void DecimationPatch<FaceT>::decimate(const size_t target_faces, const float max_error_sq)
+{
+    while (num_faces_ > target_faces && !heap_.empty()) {
+        const Collapse collapse = heap_.top();
+        if (removed_[collapse.v_keep] || removed_[collapse.v_remove] || versions_[collapse.v_keep] != collapse.version_keep
+            || versions_[collapse.v_remove] != collapse.version_remove) {
+            // Stale entry, the cost of this edge has changed since it was pushed.
+            heap_.pop();
+            continue;
+        }
+        if (collapse.cost > max_error_sq) {
+            // Leave the collapse in the heap so that decimate() can be called again with a larger
+            // error to produce a coarser level of detail.
+            break;
+        }
+        heap_.pop();
+        if (!isValid(collapse)) {
+            continue;
+        }
+        apply(collapse);
+    }
+}
+
+
+template<typename FaceT>
+void DecimationPatch<FaceT>::append(Mesh<FaceT>& mesh) const
+{
+    for (size_t f = 0; f < faces_.size(); f++) {
+        if (!face_alive_[f]) {
+            continue;
+        }
+        // Copy the source face to keep its per-face attributes, e.g. the class ID and scale.
+        FaceT face = mesh_[face_sources_[f]];
+        for (size_t i = 0; i < 3; i++) {
+            face.vertexes[i] = positions_[faces_[f][i]];
+            if constexpr (FaceT::colour) {
+                face.vertex_colours[i] = colours_[faces_[f][i]];
+            }
+        }
+        mesh.push_back(face);
+    }
+}
+
+
+template<typename FaceT>
+bool DecimationPatch<FaceT>::computeCollapse(const int v_0, const int v_1, Collapse& collapse) const
+{
+    if (locked_[v_0] && locked_[v_1]) {
+        return false;
+    }
+    // Always keep the locked vertex so that it doesn't move.
+    collapse.v_keep = locked_[v_1] ? v_1 : v_0;
+    collapse.v_remove = locked_[v_1] ? v_0 : v_1;
+    collapse.version_keep = versions_[collapse.v_keep];
+    collapse.version_remove = versions_[collapse.v_remove];
+
+    const Eigen::Matrix4d quadric = quadrics_[v_0] + quadrics_[v_1];
+    const auto cost = [&quadric](const Eigen::Vector3f& p) {
+        const Eigen::Vector4d p_h = p.template cast<double>().homogeneous();
+        return std::max(p_h.dot(quadric * p_h), 0.0);
+    };
+
+    const Eigen::Vector3f& p_keep = positions_[collapse.v_keep];
+    const Eigen::Vector3f& p_remove = positions_[collapse.v_remove];
+    if (locked_[collapse.v_keep]) {
+        collapse.position = p_keep;
+        collapse.cost = cost(p_keep);
+        return true;
+    }
+
+    // Try the position minimizing the quadric error. Nearly planar neighbourhoods give singular or
+    // ill-conditioned systems whose solution may end up far from the edge, fall back to the best of
+    // the edge endpoints and midpoint in that case.
+    const Eigen::FullPivLU<Eigen::Matrix3d> lu(quadric.topLeftCorner<3, 3>());
+    if (lu.isInvertible()) {
+        const Eigen::Vector3f p_opt = lu.solve(-quadric.topRightCorner<3, 1>()).template cast<float>();
+        const Eigen::Vector3f p_mid = 0.5f * (p_keep + p_remove);
+        if ((p_opt - p_mid).norm() <= (p_keep - p_remove).norm()) {
+            collapse.position = p_opt;
+            collapse.cost = cost(p_opt);
+            return true;
+        }
+    }
+    collapse.position = p_keep;
+    collapse.cost = cost(p_keep);
+    for (const Eigen::Vector3f& p : {p_remove, Eigen::Vector3f(0.5f * (p_keep + p_remove))}) {
+        const double c = cost(p);
+        if (c < collapse.cost) {
+            collapse.position = p;
+            collapse.cost = c;
+        }
+    }
+    return true;
+}
+
+
+template<typename FaceT>
+bool DecimationPatch<FaceT>::isValid(const Collapse& collapse) const
+{
+    // Link condition: the only vertices adjacent to both endpoints must be the opposite vertices of
+    // the two faces sharing the edge, otherwise the collapse creates a non-manifold edge.
+    neighbours(collapse.v_keep, neighbours_keep_);
+    neighbours(collapse.v_remove, neighbours_remove_);
+    common_neighbours_.clear();
+    std::set_intersection(neighbours_keep_.begin(),
+                          neighbours_keep_.end(),
+                          neighbours_remove_.begin(),
+                          neighbours_remove_.end(),
+                          std::back_inserter(common_neighbours_));
+    if (common_neighbours_.size() != 2) {
+        return false;
+    }
+
+    // Reject collapses that flip or strongly rotate any of the remaining faces.
+    for (const int v : {collapse.v_keep, collapse.v_remove}) {
+        for (const int f : vertex_faces_[v]) {
+            if (!face_alive_[f]) {
+                continue;
+            }
+            const std::array<int, 3>& face = faces_[f];
+            if (std::find(face.begin(), face.end(), collapse.v_keep) != face.end()
+                && std::find(face.begin(), face.end(), collapse.v_remove) != face.end()) {
+                // This face is removed by the collapse.
+                continue;
+            }
+            std::array<Eigen::Vector3f, 3> p;
+            std::array<Eigen::Vector3f, 3> p_new;
+            for (size_t i = 0; i < 3; i++) {
+                p[i] = positions_[face[i]];
+                p_new[i] = face[i] == v ? collapse.position : p[i];
+            }
+            const Eigen::Vector3f normal = (p[1] - p[0]).cross(p[2] - p[0]);
+            const Eigen::Vector3f normal_new = (p_new[1] - p_new[0]).cross(p_new[2] - p_new[0]);
+            const float normal_norm = normal.norm();
+            const float normal_new_norm = normal_new.norm();
+            if (normal_norm == 0.0f) {
+                continue;
+            }
+            if (normal_new_norm == 0.0f || normal.dot(normal_new) < 0.2f * normal_norm * normal_new_norm) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+
+template<typename FaceT>
+void DecimationPatch<FaceT>::apply(const Collapse& collapse)
+{
+    const int v_keep = collapse.v_keep;
+    const int v_remove = collapse.v_remove;
+    if constexpr (FaceT::colour) {
+        // Keep the colour of the endpoint closest to the new position.
+        if ((collapse.position - positions_[v_remove]).squaredNorm() < (collapse.position - positions_[v_keep]).squaredNorm()) {
+            colours_[v_keep] = colours_[v_remove];
+        }
+    }
+    positions_[v_keep] = collapse.position;
+    quadrics_[v_keep] += quadrics_[v_remove];
+    removed_[v_remove] = true;
+    versions_[v_keep]++;
+
+    for (const int f : vertex_faces_[v_remove]) {
+        if (!face_alive_[f]) {
+            continue;
+        }
+        std::array<int, 3>& face = faces_[f];
+        if (std::find(face.begin(), face.end(), v_keep) != face.end()) {
+            face_alive_[f] = false;
+            num_faces_--;
+        }
+        else {
+            std::replace(face.begin(), face.end(), v_remove, v_keep);
+            vertex_faces_[v_keep].push_back(f);
+        }
+    }
+    vertex_faces_[v_remove].clear();
+    std::vector<int>& keep_faces = vertex_faces_[v_keep];
+    keep_faces.erase(std::remove_if(keep_faces.begin(), keep_faces.end(), [&](const int f) { return !face_alive_[f]; }), keep_faces.end());
+
+    // The quadric of the kept vertex changed so all of its edges need a new cost.
+    neighbours(v_keep, neighbours_keep_);
+    for (const int v : neighbours_keep_) {
+        Collapse c;
+        if (computeCollapse(v_keep, v, c)) {
+            heap_.push(c);
+        }
+    }
+}
+
+
+template<typename FaceT>
+void DecimationPatch<FaceT>::neighbours(const int v, std::vector<int>& neighbour_vertices) const
+{
+    neighbour_vertices.clear();
+    for (const int f : vertex_faces_[v]) {
+        if (!face_alive_[f]) {
+            continue;
+        }
+        for (const int u : faces_[f]) {
+            if (u != v) {
+                neighbour_vertices.push_back(u);
+            }
+        }
+    }
+    std::sort(neighbour_vertices.begin(), neighbour_vertices.end());
+    neighbour_vertices.erase(std::unique(neighbour_vertices.begin(), neighbour_vertices.end()), neighbour_vertices.end());
+}
+
+} // namespace meshing
+
+
+namespace algorithms {
+
+template<typename FaceT>
+Mesh<FaceT> decimate_mesh(const Mesh<FaceT>& mesh, const float cell_size, const float target_ratio, const float max_error)
+{
+    if (target_ratio >= 1.0f || mesh.empty()) {
+        return mesh;
+    }
+    TICK("mesh-decimation")
+
+    // Group the faces into cells by their centroid. The marching cubes faces of a block have their
+    // centroid inside the block so cells aligned with blocks contain whole blocks.
+    std::unordered_map<Eigen::Vector3i, std::vector<size_t>, meshing::Vector3iHash> cell_faces;
+    for (size_t i = 0; i < mesh.size(); i++) {
+        const Eigen::Vector3f centroid = (mesh[i].vertexes[0] + mesh[i].vertexes[1] + mesh[i].vertexes[2]) / 3.0f;
+        const Eigen::Vector3i cell = (centroid / cell_size).array().floor().template cast<int>().matrix();
+        cell_faces[cell].push_back(i);
+    }
+    std::vector<const std::vector<size_t>*> cells;
+    cells.reserve(cell_faces.size());
+    for (const auto& cell : cell_faces) {
+        cells.push_back(&cell.second);
+    }
+
+    const float weld_dist = 1e-4f * cell_size;
+    const float max_error_sq = std::isinf(max_error) ? max_error : max_error * max_error;
+    std::vector<Mesh<FaceT>> cell_meshes(cells.size());
+#pragma omp parallel for schedule(dynamic)
+    for (size_t i = 0; i < cells.size(); i++) {
+        meshing::DecimationPatch<FaceT> patch(mesh, *cells[i], weld_dist);
+        const size_t target_faces = std::ceil(target_ratio * patch.numFaces());
+        patch.decimate(target_faces, max_error_sq);
+        cell_meshes[i].reserve(patch.numFaces());
+        patch.append(cell_meshes[i]);
+    }
+
+    Mesh<FaceT> decimated_mesh;
+    size_t num_faces = 0;
+    for (const auto& m : cell_meshes) {
+        num_faces += m.size();
+    }
+    decimated_mesh.reserve(num_faces);
+    for (const auto& m : cell_meshes) {
+        decimated_mesh.insert(decimated_mesh.end(), m.begin(), m.end());
+    }
+
+    TOCK("mesh-decimation")
+    return decimated_mesh;
+}
+
+} // namespace algorithms
+} // namespace se
+
+#endif // SE_MESH_DECIMATION_IMPL_HPP
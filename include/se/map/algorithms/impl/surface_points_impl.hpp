@@ -0,0 +1,131 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Smart Robotics Lab, Technical University of Munich
+ * SPDX-FileCopyrightText: 2024 Jiaxin Wei
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef SE_SURFACE_POINTS_IMPL_HPP
+#define SE_SURFACE_POINTS_IMPL_HPP
+
+#include <cmath>
+
+namespace se {
+namespace algorithms {
+
+template<typename OctreeT>
+SurfacePointCloud surface_points(OctreeT& octree)
+{
+    static_assert(OctreeT::fld_ == Field::TSDF && OctreeT::res_ == Res::Single, "Surface points can only be extracted from single-res TSDF octrees");
+    typedef typename OctreeT::BlockType BlockType;
+    typedef typename OctreeT::DataType DataType;
+    constexpr int block_size = BlockType::getSize();
+
+    TICK("surface-points")
+    std::vector<const BlockType*> block_ptrs;
+    for (auto block_ptr_itr = BlocksIterator<OctreeT>(&octree); block_ptr_itr != BlocksIterator<OctreeT>(); ++block_ptr_itr) {
+        block_ptrs.push_back(static_cast<const BlockType*>(*block_ptr_itr));
+    }
+
+    std::vector<SurfacePointCloud> block_points(block_ptrs.size());
+#pragma omp parallel for
+    for (size_t block_idx = 0; block_idx < block_ptrs.size(); block_idx++) {
+        const BlockType& block = *block_ptrs[block_idx];
+        const Eigen::Vector3i& block_coord = block.getCoord();
+        SurfacePointCloud& points = block_points[block_idx];
+
+        // Only the voxels on the positive faces of the block need the octree to be traversed.
+        const auto data_at = [&](const Eigen::Vector3i& voxel_coord) {
+            const Eigen::Vector3i voxel_coord_rel = voxel_coord - block_coord;
+            if ((voxel_coord_rel.array() >= 0).all() && (voxel_coord_rel.array() < block_size).all()) {
+                return block.getData(voxel_coord);
+            }
+            if (!octree.contains(voxel_coord)) {
+                return DataType();
+            }
+            return visitor::getData(octree, voxel_coord);
+        };
+
+        // Central differences, falling back to one-sided differences next to unobserved voxels.
+        const auto gradient = [&](const Eigen::Vector3i& voxel_coord, const float value) {
+            Eigen::Vector3f grad = Eigen::Vector3f::Zero();
+            for (int a = 0; a < 3; a++) {
+                const DataType data_pos = data_at(voxel_coord + Eigen::Vector3i::Unit(a));
+                const DataType data_neg = data_at(voxel_coord - Eigen::Vector3i::Unit(a));
+                const bool valid_pos = is_valid(data_pos);
+                const bool valid_neg = is_valid(data_neg);
+                if (valid_pos && valid_neg) {
+                    grad[a] = 0.5f * (get_field(data_pos) - get_field(data_neg));
+                }
+                else if (valid_pos) {
+                    grad[a] = get_field(data_pos) - value;
+                }
+                else if (valid_neg) {
+                    grad[a] = value - get_field(data_neg);
+                }
+            }
+            return grad;
+        };
+
+        for (int z = 0; z < block_size; z++) {
+            for (int y = 0; y < block_size; y++) {
+                for (int x = 0; x < block_size; x++) {
+                    const Eigen::Vector3i voxel_coord = block_coord + Eigen::Vector3i(x, y, z);
+                    const DataType& data = block.getData(voxel_coord);
+                    if (!is_valid(data)) {
+                        continue;
+                    }
+                    const float value = get_field(data);
+
+                    for (int a = 0; a < 3; a++) {
+                        const Eigen::Vector3i next_voxel_coord = voxel_coord + Eigen::Vector3i::Unit(a);
+                        const DataType next_data = data_at(next_voxel_coord);
+                        if (!is_valid(next_data)) {
+                            continue;
+                        }
+                        const float next_value = get_field(next_data);
+                        if ((value < 0.0f) == (next_value < 0.0f) || std::fabs(value - next_value) > 1.0f) {
+                            continue;
+                        }
+
+                        const float t = value / (value - next_value);
+                        const Eigen::Vector3f point_M = voxel_coord.cast<float>() + se::sample_offset_frac + t * Eigen::Vector3f::Unit(a);
+                        const Eigen::Vector3f grad = (1.0f - t) * gradient(voxel_coord, value) + t * gradient(next_voxel_coord, next_value);
+                        if (grad.isZero()) {
+                            continue;
+                        }
+                        points.points.push_back(point_M);
+                        // Use the same normal orientation as the raycaster.
+                        points.normals.push_back(DataType::invert_normals ? (-grad).normalized() : grad.normalized());
+                        if constexpr (OctreeT::col_ == Colour::On) {
+                            const auto lerp = [t](const uint8_t c_0, const uint8_t c_1) {
+                                return static_cast<uint8_t>(std::round((1.0f - t) * c_0 + t * c_1));
+                            };
+                            points.colours.push_back(rgb_t{lerp(data.rgb.r, next_data.rgb.r), lerp(data.rgb.g, next_data.rgb.g), lerp(data.rgb.b, next_data.rgb.b)});
+                        }
+                    }
+                } // x
+            }     // y
+        }         // z
+    }
+
+    SurfacePointCloud surface_points;
+    size_t num_points = 0;
+    for (const auto& p : block_points) {
+        num_points += p.size();
+    }
+    surface_points.points.reserve(num_points);
+    surface_points.normals.reserve(num_points);
+    surface_points.colours.reserve(OctreeT::col_ == Colour::On ? num_points : 0);
+    for (const auto& p : block_points) {
+        surface_points.points.insert(surface_points.points.end(), p.points.begin(), p.points.end());
+        surface_points.normals.insert(surface_points.normals.end(), p.normals.begin(), p.normals.end());
+        surface_points.colours.insert(surface_points.colours.end(), p.colours.begin(), p.colours.end());
+    }
+    TOCK("surface-points")
+    return surface_points;
+}
+
+} // namespace algorithms
+} // namespace se
+
+#endif // SE_SURFACE_POINTS_IMPL_HPP
@@ -0,0 +1,149 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Smart Robotics Lab, Technical University of Munich
+ * SPDX-FileCopyrightText: 2024 Jiaxin Wei
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef SE_MESH_DECIMATION_HPP
+#define SE_MESH_DECIMATION_HPP
+
+#include <Eigen/Core>
+#include <Eigen/StdVector>
+#include <array>
+#include <cstdint>
+#include <limits>
+#include <queue>
+#include <unordered_map>
+#include <vector>
+
+#include "se/common/timings.hpp"
+#include "se/map/algorithms/mesh.hpp"
+
+
+namespace se {
+namespace meshing {
+
+struct Vector3iHash {
+    size_t operator()(const Eigen::Vector3i& v) const
+    {
+        // Large primes from Teschner et al., Optimized Spatial Hashing for Collision Detection of
+        // Deformable Objects, 2003.
+        return (static_cast<size_t>(v.x()) * 73856093) ^ (static_cast<size_t>(v.y()) * 19349663) ^ (static_cast<size_t>(v.z()) * 83492791);
+    }
+};
+
+
+/**
+ * \brief An indexed triangle patch that is simplified independently of all other patches using
+ * quadric error metric edge collapses (Garland and Heckbert, Surface Simplification Using Quadric
+ * Error Metrics, 1997).
+ *
+ * Vertices on edges used by a single triangle of the patch are locked. These are the vertices shared
+ * with neighbouring patches and the vertices on holes of the surface, so decimating patches
+ * independently doesn't open cracks between them.
+ */
+template<typename FaceT>
+class DecimationPatch {
+    public:
+    /**
+     * \param[in] mesh      The mesh the patch is part of.
+     * \param[in] face_idxs The indices of the faces of mesh belonging to the patch.
+     * \param[in] weld_dist Vertices closer than this are considered the same vertex.
+     */
+    DecimationPatch(const Mesh<FaceT>& mesh, const std::vector<size_t>& face_idxs, const float weld_dist);
+
+    /**
+     * \brief Collapse edges in order of increasing error until at most target_faces remain or the
+     * next collapse would exceed max_error_sq. It can be called repeatedly with decreasing
+     * target_faces and increasing max_error_sq to produce successively coarser levels of detail.
+     */
+    void decimate(const size_t target_faces, const float max_error_sq);
+
+    /**
+     * \brief Append the remaining faces to mesh.
+     */
+    void append(Mesh<FaceT>& mesh) const;
+
+    size_t numFaces() const
+    {
+        return num_faces_;
+    }
+
+    private:
+    struct Collapse {
+        double cost;
+        int v_keep;
+        int v_remove;
+        uint32_t version_keep;
+        uint32_t version_remove;
+        Eigen::Vector3f position;
+
+        // Reversed so that std::priority_queue returns the cheapest collapse first.
+        bool operator<(const Collapse& other) const
+        {
+            return cost > other.cost;
+        }
+    };
+
+    bool computeCollapse(const int v_0, const int v_1, Collapse& collapse) const;
+
+    /** Return whether the collapse keeps the patch manifold and doesn't flip any face.
+     */
+    bool isValid(const Collapse& collapse) const;
+
+    void apply(const Collapse& collapse);
+
+    void neighbours(const int v, std::vector<int>& neighbour_vertices) const;
+
+    const Mesh<FaceT>& mesh_;
+    std::vector<Eigen::Vector3f> positions_;
+    std::vector<Eigen::Matrix4d, Eigen::aligned_allocator<Eigen::Matrix4d>> quadrics_;
+    std::vector<rgb_t> colours_;
+    std::vector<bool> locked_;
+    std::vector<bool> removed_;
+    std::vector<uint32_t> versions_;
+    std::vector<std::vector<int>> vertex_faces_;
+    std::vector<std::array<int, 3>> faces_;
+    std::vector<size_t> face_sources_;
+    std::vector<bool> face_alive_;
+    size_t num_faces_;
+    std::priority_queue<Collapse> heap_;
+    // Scratch buffers of isValid() and apply(), reused across collapses so that testing a collapse
+    // doesn't allocate. Each patch is decimated by a single thread.
+    mutable std::vector<int> neighbours_keep_;
+    mutable std::vector<int> neighbours_remove_;
+    mutable std::vector<int> common_neighbours_;
+};
+
+} // namespace meshing
+
+
+namespace algorithms {
+
+/**
+ * \brief Simplify a triangle mesh with quadric error metric edge collapses.
+ *
+ * The faces are grouped into cubic cells of side cell_size by their centroid and each cell is
+ * decimated in parallel. Vertices on cell boundaries are kept in place so the decimated cells still
+ * stitch together without cracks. The patch of each cell is simplified until at most target_ratio
+ * of its faces remain or until the next collapse would move the surface more than max_error away
+ * from the planes of the faces it replaces.
+ *
+ * \param[in] mesh         The mesh to decimate.
+ * \param[in] cell_size    The side of the cells decimated independently, in the units of the mesh.
+ * \param[in] target_ratio The fraction of faces to keep, in the interval (0, 1].
+ * \param[in] max_error    The maximum allowed error, in the units of the mesh.
+ * \return The decimated mesh.
+ */
+template<typename FaceT>
+Mesh<FaceT> decimate_mesh(const Mesh<FaceT>& mesh,
+                          const float cell_size,
+                          const float target_ratio,
+                          const float max_error = std::numeric_limits<float>::infinity());
+
+} // namespace algorithms
+} // namespace se
+
+#include "impl/mesh_decimation_impl.hpp"
+
+#endif // SE_MESH_DECIMATION_HPP
@@ -0,0 +1,64 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Smart Robotics Lab, Technical University of Munich
+ * SPDX-FileCopyrightText: 2024 Jiaxin Wei
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef SE_SURFACE_POINTS_HPP
+#define SE_SURFACE_POINTS_HPP
+
+#include <Eigen/Core>
+#include <vector>
+
+#include "se/common/timings.hpp"
+#include "se/map/octree/iterator.hpp"
+#include "se/map/octree/visitor.hpp"
+
+
+namespace se {
+
+/** \brief Surface points with normals and, for maps with colour, colours. The normals and colours
+ * have either the same number of elements as the points or are empty.
+ */
+struct SurfacePointCloud {
+    std::vector<Eigen::Vector3f> points;
+    std::vector<Eigen::Vector3f> normals;
+    std::vector<rgb_t> colours;
+
+    size_t size() const
+    {
+        return points.size();
+    }
+
+    bool empty() const
+    {
+        return points.empty();
+    }
+};
+
+
+namespace algorithms {
+
+/**
+ * \brief Extract the zero crossings of a single-resolution TSDF octree.
+ *
+ * The allocated blocks are scanned in parallel and a point is created wherever the TSDF changes sign
+ * between two observed voxels adjacent along the x, y or z axis. Its position is linearly interpolated
+ * between the voxels. Its normal is interpolated from the central difference TSDF gradients of the
+ * voxels, oriented like the raycaster normals. Sign changes between nearly opposite truncated values
+ * are skipped, since they are back face artifacts rather than surfaces. Each voxel edge crossing the
+ * surface yields a single point, unlike the marching cubes face list which repeats each vertex for
+ * every face using it.
+ *
+ * \param[in] octree The octree to extract the points from.
+ * \return The surface points and normals in the octree frame in units of voxels.
+ */
+template<typename OctreeT>
+SurfacePointCloud surface_points(OctreeT& octree);
+
+} // namespace algorithms
+} // namespace se
+
+#include "impl/surface_points_impl.hpp"
+
+#endif // SE_SURFACE_POINTS_HPP
@@ -0,0 +1,121 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Smart Robotics Lab, Technical University of Munich
+ * SPDX-FileCopyrightText: 2024 Jiaxin Wei
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef SE_FRAME_CONTEXT_HPP
+#define SE_FRAME_CONTEXT_HPP
+
+#include <Eigen/Core>
+#include <vector>
+
+#include "se/common/colour_types.hpp"
+#include "se/image/image.hpp"
+#include "se/map/preprocessor.hpp"
+
+
+namespace se {
+
+/**
+ * \brief The images derived from a single depth/colour frame, shared by all pipeline stages.
+ *
+ * Each derived image (depth and colour pyramid levels, the point cloud, the normals and the colour
+ * integral images) is computed the first time a stage requests it and returned from the cache for
+ * the rest of the frame. The buffers are owned by the context and reused by the following frames,
+ * so a context should be kept for the whole sequence and reset() for every new frame. Allocation
+ * only happens when a derived image is requested for the first time or the input resolution
+ * changes.
+ *
+ * The lazy accessors are not thread-safe, request the derived images before entering parallel
+ * regions.
+ *
+ * \tparam SensorT The type of the sensor the frame was captured with.
+ */
+template<typename SensorT>
+class FrameContext {
+    public:
+    /** The maximum depth difference in metres between pixels averaged when building the depth
+     * pyramid, see se::preprocessor::half_sample_robust_image().
+     */
+    static constexpr float depth_pyramid_threshold = 0.1f;
+
+    /**
+     * \param[in] sensor The sensor the frames are captured with. It must outlive the context.
+     */
+    FrameContext(const SensorT& sensor);
+
+    /**
+     * \brief Start a new frame, invalidating all derived images while keeping their buffers.
+     *
+     * \param[in] depth_img  The depth image of the frame. It must outlive the frame.
+     * \param[in] colour_img The colour image of the frame or nullptr if none. It must outlive the
+     *                       frame and have the same dimensions as the depth image, otherwise
+     *                       std::invalid_argument is thrown.
+     */
+    void reset(const Image<float>& depth_img, const Image<rgb_t>* colour_img = nullptr);
+
+    const SensorT& sensor() const;
+
+    bool hasColour() const;
+
+    /** Return the depth image at pyramid \p level. Level 0 is the input depth image and each
+     * following level has half the resolution of the previous one.
+     */
+    const Image<float>& depth(const int level = 0);
+
+    /** Return the colour image at pyramid \p level. Level 0 is the input colour image and each
+     * following level averages 2x2 pixels of the previous one. The frame must have colour.
+     */
+    const Image<rgb_t>& colour(const int level = 0);
+
+    /** Return the points of the depth image in the sensor frame. The points of invalid depth
+     * pixels are zero.
+     */
+    const Image<Eigen::Vector3f>& pointCloud();
+
+    /** Return the normals of pointCloud() in the sensor frame. The x coordinate of invalid
+     * normals is -2.
+     */
+    const Image<Eigen::Vector3f>& normals();
+
+    /** Return the integral image of the colour channels. It is one pixel larger than the colour
+     * image in each dimension and element (x, y) contains the sum of all pixels above and to the
+     * left of pixel (x, y). The frame must have colour.
+     */
+    const Image<Eigen::Vector3d>& colourSum();
+
+    /** Return the integral image of the squared colour channels with the same layout as
+     * colourSum(). The frame must have colour.
+     */
+    const Image<Eigen::Vector3d>& colourSquaredSum();
+
+    EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+
+    private:
+    void computeColourIntegrals();
+
+    const SensorT& sensor_;
+    const Image<float>* depth_img_;
+    const Image<rgb_t>* colour_img_;
+
+    /** Pyramid level l > 0 is stored at index l - 1. Levels past the valid ones are kept for reuse. */
+    std::vector<Image<float>> depth_pyramid_;
+    std::vector<Image<rgb_t>> colour_pyramid_;
+    int num_depth_levels_;
+    int num_colour_levels_;
+
+    Image<Eigen::Vector3f> point_cloud_;
+    Image<Eigen::Vector3f> normals_;
+    Image<Eigen::Vector3d> colour_sum_;
+    Image<Eigen::Vector3d> colour_squared_sum_;
+    bool point_cloud_valid_;
+    bool normals_valid_;
+    bool colour_integrals_valid_;
+};
+
+} // namespace se
+
+#include "impl/frame_context_impl.hpp"
+
+#endif // SE_FRAME_CONTEXT_HPP
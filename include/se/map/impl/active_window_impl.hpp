@@ -0,0 +1,217 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Smart Robotics Lab, Technical University of Munich
+ * SPDX-FileCopyrightText: 2024 Jiaxin Wei
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef SE_ACTIVE_WINDOW_IMPL_HPP
+#define SE_ACTIVE_WINDOW_IMPL_HPP
+
+#include <algorithm>
+#include <cmath>
+
+namespace se {
+
+
+template<typename MapT>
+ActiveWindow<MapT>::ActiveWindow(const MapT& map, const bool compress) :
+        radius_(map.getActiveRadius()),
+        compress_(compress),
+        cell_size_(std::isfinite(radius_) ? std::max(static_cast<int>(std::ceil(radius_ / map.getRes() / BlockType::getSize())), 1) * BlockType::getSize()
+                                          : BlockType::getSize()),
+        num_compressed_blocks_(0),
+        compressed_bytes_(0),
+        num_restored_blocks_(0)
+{
+}
+
+
+template<typename MapT>
+size_t ActiveWindow<MapT>::update(MapT& map, const Eigen::Vector3f& t_WS, MeshType* finalised_mesh_M, io::ChangeFeed<MapT>* change_feed)
+{
+    num_restored_blocks_ = 0;
+    if (!std::isfinite(radius_)) {
+        return 0;
+    }
+    OctreeType& octree = *map.getOctree();
+
+    TICK("active-window-restore")
+    restore(map, t_WS);
+    TOCK("active-window-restore")
+
+    // Only the active region is allocated, so this is bounded by its size.
+    TICK("active-window-finalise")
+    std::vector<BlockType*> finalised_block_ptrs;
+    for (auto block_ptr_itr = BlocksIterator<OctreeType>(&octree); block_ptr_itr != BlocksIterator<OctreeType>(); ++block_ptr_itr) {
+        BlockType* block_ptr = static_cast<BlockType*>(*block_ptr_itr);
+        if (!isActive(map, block_ptr->getCoord(), t_WS)) {
+            finalised_block_ptrs.push_back(block_ptr);
+        }
+    }
+
+    if (finalised_mesh_M && !finalised_block_ptrs.empty()) {
+        // Mesh before deleting any block so that the faces between finalised blocks are kept.
+        const MeshType mesh = algorithms::marching_cube_kernel(octree, finalised_block_ptrs);
+        finalised_mesh_M->insert(finalised_mesh_M->end(), mesh.begin(), mesh.end());
+    }
+
+    for (BlockType* block_ptr : finalised_block_ptrs) {
+        const key_t block_key = keyops::encode_key(block_ptr->getCoord(), OctreeType::max_block_scale);
+        if (compress_) {
+            compress(*block_ptr);
+        }
+        else if (!isUnobserved(*block_ptr)) {
+            discarded_keys_.insert(block_key);
+        }
+        if (change_feed) {
+            change_feed->forget(block_key);
+        }
+        octree.deleteBlock(block_ptr);
+    }
+    TOCK("active-window-finalise")
+    return finalised_block_ptrs.size();
+}
+
+
+template<typename MapT>
+bool ActiveWindow<MapT>::discarded(const MapT& map, const Eigen::Vector3f& point_W) const
+{
+    if (discarded_keys_.empty()) {
+        return false;
+    }
+    Eigen::Vector3i voxel_coord;
+    if (!map.template pointToVoxel<Safe::On>(point_W, voxel_coord)) {
+        return false;
+    }
+    const Eigen::Vector3i block_coord = voxel_coord / BlockType::getSize() * BlockType::getSize();
+    return discarded_keys_.count(keyops::encode_key(block_coord, OctreeType::max_block_scale));
+}
+
+
+template<typename MapT>
+typename ActiveWindow<MapT>::CellKey ActiveWindow<MapT>::cellKey(const Eigen::Vector3i& block_coord) const
+{
+    // Block coordinates are non-negative so integer division rounds down.
+    return {block_coord.x() / cell_size_, block_coord.y() / cell_size_, block_coord.z() / cell_size_};
+}
+
+
+template<typename MapT>
+bool ActiveWindow<MapT>::isActive(const MapT& map, const Eigen::Vector3i& block_coord, const Eigen::Vector3f& t_WS) const
+{
+    // Same test as se::RaycastCarver so that newly allocated blocks are never finalised.
+    Eigen::Vector3f block_centre_W;
+    map.voxelToPoint(block_coord, BlockType::getSize(), block_centre_W);
+    return (block_centre_W - t_WS).squaredNorm() <= radius_ * radius_;
+}
+
+
+template<typename MapT>
+void ActiveWindow<MapT>::restore(MapT& map, const Eigen::Vector3f& t_WS)
+{
+    if (num_compressed_blocks_ == 0) {
+        return;
+    }
+    OctreeType& octree = *map.getOctree();
+
+    // Visit the cells overlapping the axis-aligned bounding box of the active region in the map
+    // frame, the cells are at least as large as the radius so there are at most 27 of them.
+    Eigen::Vector3f t_MS_vox;
+    map.template pointToVoxel<Safe::Off>(t_WS, t_MS_vox);
+    const float cell_size = cell_size_;
+    const float radius_vox = radius_ / map.getRes();
+    const Eigen::Vector3i min_cell = ((t_MS_vox.array() - radius_vox) / cell_size).floor().template cast<int>().max(0).matrix();
+    const Eigen::Vector3i max_cell = ((t_MS_vox.array() + radius_vox) / cell_size).floor().template cast<int>().matrix();
+
+    std::vector<OctantBase*> restored_block_ptrs;
+    for (int z = min_cell.z(); z <= max_cell.z(); z++) {
+        for (int y = min_cell.y(); y <= max_cell.y(); y++) {
+            for (int x = min_cell.x(); x <= max_cell.x(); x++) {
+                const auto cell_itr = cells_.find({x, y, z});
+                if (cell_itr == cells_.end()) {
+                    continue;
+                }
+                std::vector<CompressedBlock>& compressed_blocks = cell_itr->second;
+                for (size_t i = 0; i < compressed_blocks.size();) {
+                    CompressedBlock& compressed = compressed_blocks[i];
+                    if (!isActive(map, compressed.coord, t_WS)) {
+                        i++;
+                        continue;
+                    }
+                    BlockType& block = *static_cast<BlockType*>(allocator::block(compressed.coord, octree, octree.getRoot()));
+                    size_t data_idx = 0;
+                    for (int voxel_idx = 0; voxel_idx < BlockType::size_cu; voxel_idx++) {
+                        const bool observed = compressed.observed_mask[voxel_idx / 8] & (1 << (voxel_idx % 8));
+                        block.getData(voxel_idx) = observed ? compressed.data[data_idx++] : DataType();
+                    }
+                    block.setTimeStamp(compressed.timestamp);
+                    restored_block_ptrs.push_back(&block);
+
+                    compressed_bytes_ -= compressed.bytes();
+                    num_compressed_blocks_--;
+                    std::swap(compressed, compressed_blocks.back());
+                    compressed_blocks.pop_back();
+                }
+                if (compressed_blocks.empty()) {
+                    cells_.erase(cell_itr);
+                }
+            }
+        }
+    }
+    propagator::propagateTimeStampToRoot(restored_block_ptrs);
+    num_restored_blocks_ = restored_block_ptrs.size();
+}
+
+
+template<typename MapT>
+void ActiveWindow<MapT>::compress(const BlockType& block)
+{
+    CompressedBlock compressed;
+    compressed.coord = block.getCoord();
+    compressed.timestamp = block.getTimeStamp();
+    compressed.observed_mask.resize((BlockType::size_cu + 7) / 8, 0);
+    for (int voxel_idx = 0; voxel_idx < BlockType::size_cu; voxel_idx++) {
+        const DataType& data = block.getData(voxel_idx);
+        if (!isUnobserved(data)) {
+            compressed.observed_mask[voxel_idx / 8] |= 1 << (voxel_idx % 8);
+            compressed.data.push_back(data);
+        }
+    }
+    if (compressed.data.empty()) {
+        // Nothing to restore, the block is allocated again if it's observed.
+        return;
+    }
+    compressed.data.shrink_to_fit();
+    compressed_bytes_ += compressed.bytes();
+    num_compressed_blocks_++;
+    cells_[cellKey(compressed.coord)].push_back(std::move(compressed));
+}
+
+
+template<typename MapT>
+bool ActiveWindow<MapT>::isUnobserved(const BlockType& block)
+{
+    for (int voxel_idx = 0; voxel_idx < BlockType::size_cu; voxel_idx++) {
+        if (!isUnobserved(block.getData(voxel_idx))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+
+template<typename MapT>
+bool ActiveWindow<MapT>::isUnobserved(const DataType& data)
+{
+    static const DataType unobserved_data;
+    bool unobserved = data.tsdf == unobserved_data.tsdf && data.weight == unobserved_data.weight;
+    if constexpr (MapT::col_ == Colour::On) {
+        unobserved = unobserved && data.rgb == unobserved_data.rgb && data.rgb_weight == unobserved_data.rgb_weight;
+    }
+    return unobserved;
+}
+
+
+} // namespace se
+
+#endif // SE_ACTIVE_WINDOW_IMPL_HPP
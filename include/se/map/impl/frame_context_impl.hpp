@@ -0,0 +1,209 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Smart Robotics Lab, Technical University of Munich
+ * SPDX-FileCopyrightText: 2024 Jiaxin Wei
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef SE_FRAME_CONTEXT_IMPL_HPP
+#define SE_FRAME_CONTEXT_IMPL_HPP
+
+#include <cassert>
+#include <sstream>
+#include <stdexcept>
+
+namespace se {
+
+
+template<typename SensorT>
+FrameContext<SensorT>::FrameContext(const SensorT& sensor) :
+        sensor_(sensor),
+        depth_img_(nullptr),
+        colour_img_(nullptr),
+        num_depth_levels_(0),
+        num_colour_levels_(0),
+        point_cloud_(1, 1),
+        normals_(1, 1),
+        colour_sum_(1, 1),
+        colour_squared_sum_(1, 1),
+        point_cloud_valid_(false),
+        normals_valid_(false),
+        colour_integrals_valid_(false)
+{
+}
+
+
+template<typename SensorT>
+void FrameContext<SensorT>::reset(const Image<float>& depth_img, const Image<rgb_t>* colour_img)
+{
+    if (colour_img && (depth_img.width() != colour_img->width() || depth_img.height() != colour_img->height())) {
+        std::ostringstream oss;
+        oss << "depth (" << depth_img.width() << "x" << depth_img.height() << ") and colour (" << colour_img->width() << "x" << colour_img->height() << ") image dimensions differ";
+        throw std::invalid_argument(oss.str());
+    }
+    depth_img_ = &depth_img;
+    colour_img_ = colour_img;
+    num_depth_levels_ = 0;
+    num_colour_levels_ = 0;
+    point_cloud_valid_ = false;
+    normals_valid_ = false;
+    colour_integrals_valid_ = false;
+}
+
+
+template<typename SensorT>
+const SensorT& FrameContext<SensorT>::sensor() const
+{
+    return sensor_;
+}
+
+
+template<typename SensorT>
+bool FrameContext<SensorT>::hasColour() const
+{
+    return colour_img_;
+}
+
+
+template<typename SensorT>
+const Image<float>& FrameContext<SensorT>::depth(const int level)
+{
+    assert(depth_img_ && "reset() was called");
+    assert(level >= 0);
+    if (level == 0) {
+        return *depth_img_;
+    }
+    while (num_depth_levels_ < level) {
+        if (depth_pyramid_.size() <= static_cast<size_t>(num_depth_levels_)) {
+            depth_pyramid_.emplace_back(1, 1);
+        }
+        // half_sample_robust_image() reallocates the output only if its dimensions differ.
+        const Image<float>& input = (num_depth_levels_ == 0) ? *depth_img_ : depth_pyramid_[num_depth_levels_ - 1];
+        preprocessor::half_sample_robust_image(depth_pyramid_[num_depth_levels_], input, depth_pyramid_threshold, 1);
+        num_depth_levels_++;
+    }
+    return depth_pyramid_[level - 1];
+}
+
+
+template<typename SensorT>
+const Image<rgb_t>& FrameContext<SensorT>::colour(const int level)
+{
+    assert(colour_img_ && "The frame has colour");
+    assert(level >= 0);
+    if (level == 0) {
+        return *colour_img_;
+    }
+    while (num_colour_levels_ < level) {
+        if (colour_pyramid_.size() <= static_cast<size_t>(num_colour_levels_)) {
+            colour_pyramid_.emplace_back(1, 1);
+        }
+        const Image<rgb_t>& input = (num_colour_levels_ == 0) ? *colour_img_ : colour_pyramid_[num_colour_levels_ - 1];
+        preprocessor::downsample_image(colour_pyramid_[num_colour_levels_], input, 2);
+        num_colour_levels_++;
+    }
+    return colour_pyramid_[level - 1];
+}
+
+
+template<typename SensorT>
+const Image<Eigen::Vector3f>& FrameContext<SensorT>::pointCloud()
+{
+    assert(depth_img_ && "reset() was called");
+    if (!point_cloud_valid_) {
+        if (point_cloud_.width() != depth_img_->width() || point_cloud_.height() != depth_img_->height()) {
+            point_cloud_ = Image<Eigen::Vector3f>(depth_img_->width(), depth_img_->height());
+        }
+        preprocessor::depth_to_point_cloud(point_cloud_, *depth_img_, sensor_);
+        point_cloud_valid_ = true;
+    }
+    return point_cloud_;
+}
+
+
+template<typename SensorT>
+const Image<Eigen::Vector3f>& FrameContext<SensorT>::normals()
+{
+    if (!normals_valid_) {
+        const Image<Eigen::Vector3f>& point_cloud = pointCloud();
+        if (normals_.width() != point_cloud.width() || normals_.height() != point_cloud.height()) {
+            normals_ = Image<Eigen::Vector3f>(point_cloud.width(), point_cloud.height());
+        }
+        if (sensor_.left_hand_frame) {
+            preprocessor::point_cloud_to_normal<true>(normals_, point_cloud);
+        }
+        else {
+            preprocessor::point_cloud_to_normal<false>(normals_, point_cloud);
+        }
+        normals_valid_ = true;
+    }
+    return normals_;
+}
+
+
+template<typename SensorT>
+const Image<Eigen::Vector3d>& FrameContext<SensorT>::colourSum()
+{
+    computeColourIntegrals();
+    return colour_sum_;
+}
+
+
+template<typename SensorT>
+const Image<Eigen::Vector3d>& FrameContext<SensorT>::colourSquaredSum()
+{
+    computeColourIntegrals();
+    return colour_squared_sum_;
+}
+
+
+template<typename SensorT>
+void FrameContext<SensorT>::computeColourIntegrals()
+{
+    assert(colour_img_ && "The frame has colour");
+    if (colour_integrals_valid_) {
+        return;
+    }
+    const int width = colour_img_->width();
+    const int height = colour_img_->height();
+    if (colour_sum_.width() != width + 1 || colour_sum_.height() != height + 1) {
+        colour_sum_ = Image<Eigen::Vector3d>(width + 1, height + 1);
+        colour_squared_sum_ = Image<Eigen::Vector3d>(width + 1, height + 1);
+    }
+    // The first row and column are zero. Doubles hold the sums of squares of up to 2^37 8-bit
+    // pixels exactly, so variances computed from the integrals don't suffer from cancellation.
+    for (int x = 0; x <= width; x++) {
+        colour_sum_(x, 0) = Eigen::Vector3d::Zero();
+        colour_squared_sum_(x, 0) = Eigen::Vector3d::Zero();
+    }
+
+    // Compute the prefix sum of each row independently.
+#pragma omp parallel for
+    for (int y = 0; y < height; y++) {
+        Eigen::Vector3d row_sum = Eigen::Vector3d::Zero();
+        Eigen::Vector3d row_squared_sum = Eigen::Vector3d::Zero();
+        colour_sum_(0, y + 1) = row_sum;
+        colour_squared_sum_(0, y + 1) = row_squared_sum;
+        for (int x = 0; x < width; x++) {
+            const rgb_t pixel = (*colour_img_)(x, y);
+            const Eigen::Vector3d value(pixel.r, pixel.g, pixel.b);
+            row_sum += value;
+            row_squared_sum += value.cwiseProduct(value);
+            colour_sum_(x + 1, y + 1) = row_sum;
+            colour_squared_sum_(x + 1, y + 1) = row_squared_sum;
+        }
+    }
+
+    // Accumulate the rows.
+    for (int y = 1; y < height; y++) {
+        for (int x = 1; x <= width; x++) {
+            colour_sum_(x, y + 1) += colour_sum_(x, y);
+            colour_squared_sum_(x, y + 1) += colour_squared_sum_(x, y);
+        }
+    }
+    colour_integrals_valid_ = true;
+}
+
+
+} // namespace se
+
+#endif // SE_FRAME_CONTEXT_IMPL_HPP
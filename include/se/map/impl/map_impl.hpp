@@ -36,7 +36,10 @@ Map<Data<FldT, ColB, SemB>, ResT, BlockSize>::Map(const MapConfig& map_config, c
         T_WM_(se::math::to_inverse_transformation(T_MW_)),
         lb_M_(Eigen::Vector3f::Zero()),
         ub_M_(dimension_),
-        data_config_(data_config)
+        data_config_(data_config),
+        mesh_decimation_ratio_(map_config.mesh_decimation_ratio),
+        mesh_decimation_error_(map_config.mesh_decimation_error),
+        active_radius_(map_config.active_radius > 0.0f ? map_config.active_radius : std::numeric_limits<float>::infinity())
 {
     const Eigen::Vector3f t_MW = se::math::to_translation(T_MW_);
     if (t_MW.x() < 0 || t_MW.x() >= dimension_.x() || t_MW.y() < 0 || t_MW.y() >= dimension_.y() || t_MW.z() < 0 || t_MW.z() >= dimension_.z()) {
@@ -183,23 +186,29 @@ std::optional<Eigen::Vector3f> Map<Data<FldT, ColB, SemB>, ResT, BlockSize>::get
 
 
 template<Field FldT, Colour ColB, Semantics SemB, Res ResT, int BlockSize>
-int Map<Data<FldT, ColB, SemB>, ResT, BlockSize>::saveFieldSlices(const std::string& filename_x, const std::string& filename_y, const std::string& filename_z, const Eigen::Vector3f& point_W) const
+int Map<Data<FldT, ColB, SemB>, ResT, BlockSize>::saveFieldSlices(const std::string& filename_x,
+                                                                 const std::string& filename_y,
+                                                                 const std::string& filename_z,
+                                                                 const Eigen::Vector3f& point_W,
+                                                                 const std::optional<float> fill_value) const
 {
     Eigen::Vector3i voxel_coord;
-    pointToVoxel(point_W, voxel_coord);
+    if (!pointToVoxel<Safe::On>(point_W, voxel_coord)) {
+        std::cerr << "Slice point is outside the map\n";
+        return 1;
+    }
 
-    auto get_field_value = [&](const Eigen::Vector3i& coord) { return se::get_field(se::visitor::getData(*octree_ptr_, coord)); };
+    auto get_field_value = [](const DataType& data) { return se::get_field(data); };
+    const float fill = fill_value ? *fill_value : se::get_field(DataType());
 
-    if (!filename_x.empty()) {
-        se::io::save_3d_slice_vtk(filename_x, Eigen::Vector3i(voxel_coord.x(), 0, 0), Eigen::Vector3i(voxel_coord.x() + 1, octree_ptr_->getSize(), octree_ptr_->getSize()), get_field_value);
-    }
-    if (!filename_y.empty()) {
-        se::io::save_3d_slice_vtk(filename_y, Eigen::Vector3i(0, voxel_coord.y(), 0), Eigen::Vector3i(octree_ptr_->getSize(), voxel_coord.y() + 1, octree_ptr_->getSize()), get_field_value);
-    }
-    if (!filename_z.empty()) {
-        se::io::save_3d_slice_vtk(filename_z, Eigen::Vector3i(0, 0, voxel_coord.z()), Eigen::Vector3i(octree_ptr_->getSize(), octree_ptr_->getSize(), voxel_coord.z() + 1), get_field_value);
+    const std::array<const std::string*, 3> filenames = {&filename_x, &filename_y, &filename_z};
+    int num_errors = 0;
+    for (int axis = 0; axis < 3; axis++) {
+        if (!filenames[axis]->empty()) {
+            num_errors += !se::io::save_slice_vtk_binary(*filenames[axis], *octree_ptr_, axis, voxel_coord[axis], get_field_value, fill);
+        }
     }
-    return 0;
+    return num_errors;
 }
 
 
@@ -295,12 +304,21 @@ typename Map<Data<FldT, ColB, SemB>, ResT, BlockSize>::OctreeType::MeshType Map<
 template<Field FldT, Colour ColB, Semantics SemB, Res ResT, int BlockSize>
 typename Map<Data<FldT, ColB, SemB>, ResT, BlockSize>::OctreeType::MeshType Map<Data<FldT, ColB, SemB>, ResT, BlockSize>::meshVoxel() const
 {
+    typename OctreeType::MeshType mesh;
     if constexpr (ResT == se::Res::Single) {
-        return se::algorithms::marching_cube(*octree_ptr_);
+        mesh = se::algorithms::marching_cube(*octree_ptr_);
     }
     else {
-        return se::algorithms::dual_marching_cube(*octree_ptr_);
+        mesh = se::algorithms::dual_marching_cube(*octree_ptr_);
+    }
+    if (mesh_decimation_ratio_ < 1.0f) {
+        // Decimate clusters of 4x4x4 blocks, large enough for flat surfaces to collapse to a few
+        // triangles but small enough to keep all threads busy.
+        constexpr float cluster_size = 4 * BlockSize;
+        const float max_error = mesh_decimation_error_ > 0.0f ? mesh_decimation_error_ / resolution_ : std::numeric_limits<float>::infinity();
+        mesh = se::algorithms::decimate_mesh(mesh, cluster_size, mesh_decimation_ratio_, max_error);
     }
+    return mesh;
 }
 
 
@@ -318,6 +336,34 @@ int Map<Data<FldT, ColB, SemB>, ResT, BlockSize>::saveMeshVoxel(const std::strin
 }
 
 
+template<Field FldT, Colour ColB, Semantics SemB, Res ResT, int BlockSize>
+template<Field FldTDummy, Res ResTDummy>
+typename std::enable_if_t<FldTDummy == Field::TSDF && ResTDummy == Res::Single, SurfacePointCloud>
+Map<Data<FldT, ColB, SemB>, ResT, BlockSize>::surfacePoints(const Eigen::Matrix4f& T_OW) const
+{
+    SurfacePointCloud point_cloud = se::algorithms::surface_points(*octree_ptr_);
+    Eigen::Matrix4f T_WM_scale = T_WM_;
+    T_WM_scale.topLeftCorner<3, 3>() *= resolution_;
+    const Eigen::Matrix4f T_OM = T_OW * T_WM_scale;
+    const Eigen::Matrix3f C_OM = math::to_rotation(Eigen::Matrix4f(T_OW * T_WM_));
+#pragma omp parallel for
+    for (size_t i = 0; i < point_cloud.size(); i++) {
+        point_cloud.points[i] = (T_OM * point_cloud.points[i].homogeneous()).template head<3>();
+        point_cloud.normals[i] = C_OM * point_cloud.normals[i];
+    }
+    return point_cloud;
+}
+
+
+template<Field FldT, Colour ColB, Semantics SemB, Res ResT, int BlockSize>
+template<Field FldTDummy, Res ResTDummy>
+typename std::enable_if_t<FldTDummy == Field::TSDF && ResTDummy == Res::Single, int>
+Map<Data<FldT, ColB, SemB>, ResT, BlockSize>::saveSurfacePoints(const std::string& filename, const Eigen::Matrix4f& T_OW) const
+{
+    return io::save_point_cloud_ply(surfacePoints(T_OW), filename);
+}
+
+
 template<Field FldT, Colour ColB, Semantics SemB, Res ResT, int BlockSize>
 void Map<Data<FldT, ColB, SemB>, ResT, BlockSize>::voxelToPoint(const Eigen::Vector3i& voxel_coord, Eigen::Vector3f& point_W) const
 {
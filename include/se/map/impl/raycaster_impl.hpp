@@ -390,15 +390,221 @@ raycast(MapT& map, const typename MapT::OctreeType& octree, const Eigen::Vector3
 }
 
 
+namespace detail {
+
+/**
+ * \brief Access the TSDF of a map through the octree.
+ */
 template<typename MapT>
-inline typename std::enable_if_t<MapT::fld_ == se::Field::TSDF, std::optional<Eigen::Vector4f>>
-raycast(MapT& map, const typename MapT::OctreeType& /* octree */, const Eigen::Vector3f& ray_origin_W, const Eigen::Vector3f& ray_dir_W, const float t_near, const float t_far)
+class MapTSDFAccessor {
+    public:
+    MapTSDFAccessor(const MapT& map) : map_(map)
+    {
+    }
+
+    /** Same as Map::getData<Safe::On>().
+     */
+    typename MapT::DataType getData(const Eigen::Vector3f& point_W) const
+    {
+        return map_.template getData<se::Safe::On>(point_W);
+    }
+
+    /** Same as Map::getInterp() of the TSDF, returning the scale interpolated at for multi-res maps.
+     */
+    std::optional<tsdf_t> getTSDFInterp(const Eigen::Vector3f& point_W, int& scale) const
+    {
+        if constexpr (MapT::res_ == se::Res::Single) {
+            scale = 0;
+            return map_.template getInterp(point_W, [](const auto& data) { return data.tsdf; });
+        }
+        else {
+            return map_.template getInterp(point_W, scale, [](const auto& data) { return data.tsdf; });
+        }
+    }
+
+    private:
+    const MapT& map_;
+};
+
+
+/**
+ * \brief Access the TSDF of a single-res map through a small direct-mapped cache of block pointers
+ * shared by the rays of a packet. Neighbouring rays march through mostly the same blocks in the
+ * same order, so most lookups of all but the first ray of a packet skip the octree traversal.
+ * Unallocated blocks are cached too.
+ */
+template<typename MapT>
+class RayPacketBlockCache {
+    public:
+    typedef typename MapT::OctreeType OctreeType;
+    typedef typename OctreeType::BlockType BlockType;
+    typedef typename MapT::DataType DataType;
+
+    RayPacketBlockCache(const MapT& map) : map_(map), octree_(*map.getOctree())
+    {
+        static_assert(MapT::fld_ == Field::TSDF && MapT::res_ == Res::Single, "The ray packet block cache only supports single-res TSDF maps");
+        for (Entry& entry : entries_) {
+            entry.block_coord = Eigen::Vector3i::Constant(-1);
+        }
+    }
+
+    /** Return the block containing the voxel or nullptr if it isn't allocated.
+     */
+    const BlockType* block(const Eigen::Vector3i& voxel_coord)
+    {
+        const Eigen::Vector3i block_coord = voxel_coord / BlockType::getSize();
+        Entry& entry = entries_[(block_coord.x() + 3 * block_coord.y() + 5 * block_coord.z()) & (num_entries - 1)];
+        if (entry.block_coord != block_coord) {
+            entry.block_coord = block_coord;
+            entry.block_ptr = static_cast<const BlockType*>(fetcher::template block<OctreeType>(voxel_coord, octree_.getRoot()));
+        }
+        return entry.block_ptr;
+    }
+
+    /** Same as Map::getData<Safe::On>().
+     */
+    DataType getData(const Eigen::Vector3f& point_W)
+    {
+        Eigen::Vector3i voxel_coord;
+        if (!map_.template pointToVoxel<se::Safe::On>(point_W, voxel_coord)) {
+            return DataType();
+        }
+        const BlockType* block_ptr = block(voxel_coord);
+        return block_ptr ? block_ptr->getData(voxel_coord) : DataType();
+    }
+
+    /** Same as Map::getInterp() of the TSDF.
+     */
+    std::optional<tsdf_t> getTSDFInterp(const Eigen::Vector3f& point_W, int& scale)
+    {
+        scale = 0;
+        Eigen::Vector3f voxel_coord_f;
+        map_.template pointToVoxel<se::Safe::Off>(point_W, voxel_coord_f);
+        const Eigen::Vector3f scaled_voxel_coord_f = voxel_coord_f - sample_offset_frac;
+        const Eigen::Vector3f factor = math::fracf(scaled_voxel_coord_f);
+        const Eigen::Vector3i base_coord = scaled_voxel_coord_f.template cast<int>();
+        if ((base_coord.array() < 0).any() || ((base_coord + Eigen::Vector3i::Ones()).array() >= static_cast<int>(octree_.getSize())).any()) {
+            return std::nullopt;
+        }
+        tsdf_t values[8];
+        for (int n = 0; n < 8; n++) {
+            const Eigen::Vector3i neighbour_coord = base_coord + visitor::detail::interp_offsets[n];
+            const BlockType* block_ptr = block(neighbour_coord);
+            if (!block_ptr) {
+                return std::nullopt;
+            }
+            const DataType& data = block_ptr->getData(neighbour_coord);
+            if (!is_valid(data)) {
+                return std::nullopt;
+            }
+            values[n] = data.tsdf;
+        }
+        return (((values[0] * (1 - factor.x()) + values[1] * factor.x()) * (1 - factor.y()) + (values[2] * (1 - factor.x()) + values[3] * factor.x()) * factor.y())
+                    * (1 - factor.z())
+                + ((values[4] * (1 - factor.x()) + values[5] * factor.x()) * (1 - factor.y()) + (values[6] * (1 - factor.x()) + values[7] * factor.x()) * factor.y())
+                    * factor.z());
+    }
+
+    private:
+    struct Entry {
+        Eigen::Vector3i block_coord;
+        const BlockType* block_ptr = nullptr;
+    };
+
+    static constexpr int num_entries = 64;
+
+    const MapT& map_;
+    const OctreeType& octree_;
+    std::array<Entry, num_entries> entries_;
+};
+
+} // namespace detail
+
+
+/**
+ * \brief March a ray through a TSDF map starting at distance t until the first zero crossing or
+ * until t_far is reached, reading the TSDF through accessor, e.g. a detail::MapTSDFAccessor.
+ *
+ * \return The intersection in world frame with the scale as the 4th coordinate or zero if the ray
+ * doesn't intersect the surface or starts inside it.
+ */
+template<typename MapT, typename AccessorT>
+inline Eigen::Vector4f
+march_tsdf(const MapT& map, AccessorT& accessor, const Eigen::Vector3f& ray_origin_W, const Eigen::Vector3f& ray_dir_W, float t, const float t_far)
 {
-    se::VoxelBlockRayIterator<MapT> ray(map, ray_origin_W, ray_dir_W, t_near, t_far);
-    ray.next();
+    const float step = map.getRes();
+    const float largestep = MapT::OctreeType::BlockType::getSize() * step;
+    const float truncation_boundary = map.getRes() * map.getDataConfig().truncation_boundary_factor;
+
+    // first walk with largesteps until we found a hit
+    float stepsize = largestep;
+    Eigen::Vector3f point_W = ray_origin_W + ray_dir_W * t;
+    auto data = accessor.getData(point_W);
+    tsdf_t f_t = data.tsdf;
+    tsdf_t f_tt = 0;
+    int scale_tt = 0;
+    if (f_t >= 0) { // ups, if we were already in it, then don't render anything here
+        for (; t < t_far; t += stepsize) {
+            data = accessor.getData(point_W);
+            if (!se::is_valid(data)) {
+                stepsize = largestep;
+                point_W += stepsize * ray_dir_W;
+                continue;
+            }
+
+            f_tt = data.tsdf;
+            if (-tsdf_t_scale / 2 <= f_tt && f_tt <= tsdf_t_scale / 10) {
+                const std::optional<tsdf_t> field_value = accessor.getTSDFInterp(point_W, scale_tt);
+                if (field_value) {
+                    f_tt = *field_value;
+                }
+            }
+
+            if (f_tt < 0) {
+                break;
+            } // got it, jump out of inner loop
+
+            stepsize = std::max(f_tt * truncation_boundary / tsdf_t_scale, step);
+            point_W += stepsize * ray_dir_W;
+            f_t = f_tt;
+        }
+        if (f_tt < 0) { // got it, calculate accurate intersection
+            // tsdf_t_scale in the numerator and denominator cancel-out.
+            t = t + stepsize * f_tt / (f_t - f_tt);
+            Eigen::Vector4f intersection_W = (ray_origin_W + ray_dir_W * t).homogeneous();
+            intersection_W.w() = scale_tt;
+            return intersection_W;
+        }
+    }
+    return Eigen::Vector4f::Zero();
+}
 
-    float step = map.getRes();
-    float largestep = MapT::OctreeType::BlockType::getSize() * step;
+
+/**
+ * \brief March a ray through a TSDF map starting at distance t until the first zero crossing or
+ * until t_far is reached.
+ *
+ * \return The intersection in world frame with the scale as the 4th coordinate or zero if the ray
+ * doesn't intersect the surface or starts inside it.
+ */
+template<typename MapT>
+inline Eigen::Vector4f march_tsdf(const MapT& map, const Eigen::Vector3f& ray_origin_W, const Eigen::Vector3f& ray_dir_W, float t, const float t_far)
+{
+    detail::MapTSDFAccessor<MapT> accessor(map);
+    return march_tsdf(map, accessor, ray_origin_W, ray_dir_W, t, t_far);
+}
+
+
+/**
+ * \brief Raycast a TSDF map from the first block the ray intersects, reading the TSDF through
+ * accessor, see march_tsdf().
+ */
+template<typename MapT, typename AccessorT>
+inline Eigen::Vector4f
+raycast_tsdf(const MapT& map, AccessorT& accessor, const Eigen::Vector3f& ray_origin_W, const Eigen::Vector3f& ray_dir_W, const float t_near, const float t_far)
+{
+    se::VoxelBlockRayIterator<const MapT> ray(map, ray_origin_W, ray_dir_W, t_near, t_far);
+    ray.next();
 
     const float t_min = ray.tcmin(); /* Get distance to the first intersected block */
     if (t_min <= 0.f) {
@@ -406,60 +612,143 @@ raycast(MapT& map, const typename MapT::OctreeType& /* octree */, const Eigen::V
     }
     const float t_max = ray.tmax();
 
-    float t = t_min;
+    if (t_near < t_max) {
+        return march_tsdf(map, accessor, ray_origin_W, ray_dir_W, t_min, t_far);
+    }
+    return Eigen::Vector4f::Zero();
+}
 
-    const float truncation_boundary = map.getRes() * map.getDataConfig().truncation_boundary_factor;
 
-    if (t_near < t_max) {
-        // first walk with largesteps until we found a hit
-        float stepsize = largestep;
-        Eigen::Vector3f point_W = ray_origin_W + ray_dir_W * t;
-        auto data = map.template getData<se::Safe::On>(point_W);
-        tsdf_t f_t = data.tsdf;
-        tsdf_t f_tt = 0;
-        int scale_tt = 0;
-        if (f_t >= 0) { // ups, if we were already in it, then don't render anything here
-            for (; t < t_far; t += stepsize) {
-                data = map.template getData<se::Safe::On>(point_W);
-                if (!se::is_valid(data)) {
-                    stepsize = largestep;
-                    point_W += stepsize * ray_dir_W;
-                    continue;
-                }
+template<typename MapT>
+inline typename std::enable_if_t<MapT::fld_ == se::Field::TSDF, std::optional<Eigen::Vector4f>>
+raycast(MapT& map, const typename MapT::OctreeType& /* octree */, const Eigen::Vector3f& ray_origin_W, const Eigen::Vector3f& ray_dir_W, const float t_near, const float t_far)
+{
+    detail::MapTSDFAccessor<MapT> accessor(map);
+    return raycast_tsdf(map, accessor, ray_origin_W, ray_dir_W, t_near, t_far);
+}
 
-                f_tt = data.tsdf;
-                if (-tsdf_t_scale / 2 <= f_tt && f_tt <= tsdf_t_scale / 10) {
-                    const std::optional<tsdf_t> field_value = [&]() {
-                        if constexpr (MapT::res_ == se::Res::Single) {
-                            return map.template getInterp(point_W, [](const auto& data) { return data.tsdf; });
-                        }
-                        else {
-                            return map.template getInterp(point_W, scale_tt, [](const auto& data) { return data.tsdf; });
-                        }
-                    }();
-                    if (field_value) {
-                        f_tt = *field_value;
-                    }
-                }
 
-                if (f_tt < 0) {
-                    break;
-                } // got it, jump out of inner loop
+/**
+ * \brief Resize the raycasting output images to the dimensions of the surface point cloud.
+ */
+static inline void resize_surface_images(const int w,
+                                         const int h,
+                                         se::Image<Eigen::Vector3f>& surface_normals_W,
+                                         se::Image<int8_t>& surface_scale,
+                                         se::Image<rgb_t>* surface_colour,
+                                         se::Image<semantics_t>* surface_class_id)
+{
+    if (surface_normals_W.width() != w || surface_normals_W.height() != h) {
+        surface_normals_W = Image<Eigen::Vector3f>(w, h);
+    }
+    if (surface_scale.width() != w || surface_scale.height() != h) {
+        surface_scale = Image<int8_t>(w, h);
+    }
+    if (surface_colour && (surface_colour->width() != w || surface_colour->height() != h)) {
+        *surface_colour = Image<rgb_t>(w, h);
+    }
+    if (surface_class_id && (surface_class_id->width() != w || surface_class_id->height() != h)) {
+        *surface_class_id = Image<semantics_t>(w, h);
+    }
+}
 
-                stepsize = std::max(f_tt * truncation_boundary / tsdf_t_scale, step);
-                point_W += stepsize * ray_dir_W;
-                f_t = f_tt;
+
+/**
+ * \brief Write the surface point, normal, scale and optionally colour and class ID of the ray
+ * intersection of a single pixel.
+ */
+template<typename MapT>
+inline void set_surface_pixel(const MapT& map,
+                              const std::optional<Eigen::Vector4f>& surface_intersection_W,
+                              const size_t pixel_idx,
+                              se::Image<Eigen::Vector3f>& surface_point_cloud_W,
+                              se::Image<Eigen::Vector3f>& surface_normals_W,
+                              se::Image<int8_t>& surface_scale,
+                              se::Image<rgb_t>* surface_colour,
+                              se::Image<semantics_t>* surface_class_id)
+{
+    const bool has_colour = surface_colour;
+    const bool has_semantics = surface_class_id;
+    if (surface_intersection_W) {
+        // Set surface scale
+        surface_scale[pixel_idx] = static_cast<int>(surface_intersection_W->w());
+        // Set surface point
+        surface_point_cloud_W[pixel_idx] = surface_intersection_W->head<3>();
+        // Set surface normal
+        std::optional<Eigen::Vector3f> surface_normal_W = map.template getFieldGrad(surface_intersection_W->head<3>());
+        if (!surface_normal_W) {
+            surface_normals_W[pixel_idx] = Eigen::Vector3f::Constant(SE_INVALID);
+        }
+        else {
+            // Invert surface normals for TSDF representations.
+            surface_normals_W[pixel_idx] = (MapT::DataType::invert_normals) ? -surface_normal_W->normalized() : surface_normal_W->normalized();
+        }
+        if constexpr (MapT::col_ == Colour::On) {
+            if (has_colour) {
+                auto colour = map.template getInterp(surface_intersection_W->head<3>(), [](const auto& x) { return x.rgb; });
+                (*surface_colour)[pixel_idx] = colour ? *colour : rgb_t{0, 0, 0};
             }
-            if (f_tt < 0) { // got it, calculate accurate intersection
-                // tsdf_t_scale in the numerator and denominator cancel-out.
-                t = t + stepsize * f_tt / (f_t - f_tt);
-                Eigen::Vector4f intersection_W = (ray_origin_W + ray_dir_W * t).homogeneous();
-                intersection_W.w() = scale_tt;
-                return intersection_W;
+        }
+        if constexpr (MapT::sem_ != Semantics::Off) {
+            if (has_semantics) {
+                // Interpolate semantic class IDs doesn't make sense, just fetch.
+                (*surface_class_id)[pixel_idx] = map.getData(surface_intersection_W->head<3>()).sem.class_id;
+            }
+        }
+    }
+    else {
+        surface_point_cloud_W[pixel_idx] = Eigen::Vector3f::Zero();
+        surface_normals_W[pixel_idx] = Eigen::Vector3f::Constant(SE_INVALID);
+        surface_scale[pixel_idx] = 0;
+        if (has_colour) {
+            (*surface_colour)[pixel_idx] = rgb_t{0, 0, 0};
+        }
+        if (has_semantics) {
+            (*surface_class_id)[pixel_idx] = semantics_t(0);
+        }
+    }
+}
+
+
+/**
+ * \brief Raycast a single-res TSDF map in packets of 4x4 rays. The rays of a packet are marched one
+ * after the other, each stopping at its own intersection, and share a
+ * detail::RayPacketBlockCache. The result is identical to raycasting every pixel with raycast().
+ */
+template<typename MapT, typename SensorT>
+void raycast_volume_packet_kernel(const MapT& map,
+                                  se::Image<Eigen::Vector3f>& surface_point_cloud_W,
+                                  se::Image<Eigen::Vector3f>& surface_normals_W,
+                                  se::Image<int8_t>& surface_scale,
+                                  se::Image<rgb_t>* surface_colour,
+                                  se::Image<semantics_t>* surface_class_id,
+                                  const Eigen::Matrix4f& T_WS,
+                                  const SensorT& sensor)
+{
+    constexpr int packet_size = 4;
+    const int w = surface_point_cloud_W.width();
+    const int h = surface_point_cloud_W.height();
+    const Eigen::Matrix3f C_WS = se::math::to_rotation(T_WS);
+    const Eigen::Vector3f t_WS = se::math::to_translation(T_WS);
+    const int num_packets_x = (w + packet_size - 1) / packet_size;
+    const int num_packets_y = (h + packet_size - 1) / packet_size;
+
+#pragma omp parallel for collapse(2) schedule(dynamic)
+    for (int py = 0; py < num_packets_y; py++) {
+        for (int px = 0; px < num_packets_x; px++) {
+            detail::RayPacketBlockCache<MapT> cache(map);
+            for (int y = py * packet_size; y < std::min((py + 1) * packet_size, h); y++) {
+                for (int x = px * packet_size; x < std::min((px + 1) * packet_size, w); x++) {
+                    Eigen::Vector3f ray_dir_S;
+                    sensor.model.backProject(Eigen::Vector2f(x, y), &ray_dir_S);
+                    const Eigen::Vector3f ray_dir_W = C_WS * ray_dir_S.normalized();
+                    const std::optional<Eigen::Vector4f> surface_intersection_W =
+                        raycast_tsdf(map, cache, t_WS, ray_dir_W, sensor.nearDist(ray_dir_S), sensor.farDist(ray_dir_S));
+                    set_surface_pixel(map, surface_intersection_W, x + y * w, surface_point_cloud_W, surface_normals_W, surface_scale, surface_colour, surface_class_id);
+                }
             }
         }
     }
-    return Eigen::Vector4f::Zero();
 }
 
 
@@ -475,22 +764,14 @@ void raycast_volume_kernel(const MapT& map,
 {
     const int w = surface_point_cloud_W.width();
     const int h = surface_point_cloud_W.height();
-    if (surface_normals_W.width() != w || surface_normals_W.height() != h) {
-        surface_normals_W = Image<Eigen::Vector3f>(w, h);
-    }
-    if (surface_scale.width() != w || surface_scale.height() != h) {
-        surface_scale = Image<int8_t>(w, h);
-    }
-    if (surface_colour && (surface_colour->width() != w || surface_colour->height() != h)) {
-        *surface_colour = Image<rgb_t>(w, h);
-    }
-    if (surface_class_id && (surface_class_id->width() != w || surface_class_id->height() != h)) {
-        *surface_class_id = Image<semantics_t>(w, h);
+    resize_surface_images(w, h, surface_normals_W, surface_scale, surface_colour, surface_class_id);
+
+    if constexpr (MapT::fld_ == Field::TSDF && MapT::res_ == Res::Single) {
+        raycast_volume_packet_kernel(map, surface_point_cloud_W, surface_normals_W, surface_scale, surface_colour, surface_class_id, T_WS, sensor);
+        return;
     }
 
     const typename MapT::OctreeType& octree = *(map.getOctree());
-    const bool has_colour = surface_colour;
-    const bool has_semantics = surface_class_id;
 #pragma omp parallel for
     for (int y = 0; y < h; y++) {
 #pragma omp simd
@@ -503,46 +784,336 @@ void raycast_volume_kernel(const MapT& map,
             const Eigen::Vector3f t_WS = se::math::to_translation(T_WS);
             std::optional<Eigen::Vector4f> surface_intersection_W = raycast(map, octree, t_WS, ray_dir_W, sensor.nearDist(ray_dir_S), sensor.farDist(ray_dir_S));
 
-            if (surface_intersection_W) {
-                // Set surface scale
-                surface_scale[pixel_idx] = static_cast<int>(surface_intersection_W->w());
-                // Set surface point
-                surface_point_cloud_W[pixel_idx] = surface_intersection_W->head<3>();
-                // Set surface normal
-                std::optional<Eigen::Vector3f> surface_normal_W = map.template getFieldGrad(surface_intersection_W->head<3>());
-                if (!surface_normal_W) {
-                    surface_normals_W[pixel_idx] = Eigen::Vector3f::Constant(SE_INVALID);
-                }
-                else {
-                    // Invert surface normals for TSDF representations.
-                    surface_normals_W[pixel_idx] = (MapT::DataType::invert_normals) ? -surface_normal_W->normalized() : surface_normal_W->normalized();
-                }
-                if constexpr (MapT::col_ == Colour::On) {
-                    if (has_colour) {
-                        auto colour = map.template getInterp(surface_intersection_W->head<3>(), [](const auto& x) { return x.rgb; });
-                        (*surface_colour)[pixel_idx] = colour ? *colour : rgb_t{0, 0, 0};
+            set_surface_pixel(map, surface_intersection_W, pixel_idx, surface_point_cloud_W, surface_normals_W, surface_scale, surface_colour, surface_class_id);
+        } // x
+    }     // y
+}
+
+
+/**
+ * \brief Raycast the ray through the centre of pixel (x, y).
+ */
+template<typename MapT, typename SensorT>
+inline std::optional<Eigen::Vector4f> raycast_pixel(const MapT& map, const Eigen::Matrix4f& T_WS, const SensorT& sensor, const int x, const int y)
+{
+    Eigen::Vector3f ray_dir_S;
+    sensor.model.backProject(Eigen::Vector2f(x, y), &ray_dir_S);
+    const Eigen::Vector3f ray_dir_W = se::math::to_rotation(T_WS) * ray_dir_S.normalized();
+    return raycast(map, *(map.getOctree()), se::math::to_translation(T_WS), ray_dir_W, sensor.nearDist(ray_dir_S), sensor.farDist(ray_dir_S));
+}
+
+
+template<typename MapT, typename SensorT>
+void raycast_volume_subsampled_kernel(const MapT& map,
+                                      se::Image<Eigen::Vector3f>& surface_point_cloud_W,
+                                      se::Image<Eigen::Vector3f>& surface_normals_W,
+                                      se::Image<int8_t>& surface_scale,
+                                      se::Image<rgb_t>* surface_colour,
+                                      const Eigen::Matrix4f& T_WS,
+                                      const SensorT& sensor,
+                                      const int factor,
+                                      const float depth_edge_threshold)
+{
+    if (factor < 1) {
+        throw std::invalid_argument("the raycasting subsampling factor must be positive");
+    }
+    const int w = surface_point_cloud_W.width();
+    const int h = surface_point_cloud_W.height();
+    resize_surface_images(w, h, surface_normals_W, surface_scale, surface_colour, nullptr);
+
+    // Only one in error_sample_stride interpolated pixels is also raycast to estimate the error.
+    constexpr int error_sample_stride = 64;
+    const Eigen::Matrix3f C_WS = se::math::to_rotation(T_WS);
+    const Eigen::Vector3f t_WS = se::math::to_translation(T_WS);
+    const int w_l = (w - 1) / factor + 1;
+    const int h_l = (h - 1) / factor + 1;
+
+    // Raycast the pixels on the subsampled grid, keeping the distance along the ray of each hit and
+    // -1 for misses.
+    se::Image<float> dist_l(w_l, h_l);
+#pragma omp parallel for
+    for (int y_l = 0; y_l < h_l; y_l++) {
+        for (int x_l = 0; x_l < w_l; x_l++) {
+            const int x = x_l * factor;
+            const int y = y_l * factor;
+            const size_t pixel_idx = x + y * w;
+            const std::optional<Eigen::Vector4f> surface_intersection_W = raycast_pixel(map, T_WS, sensor, x, y);
+            set_surface_pixel(map, surface_intersection_W, pixel_idx, surface_point_cloud_W, surface_normals_W, surface_scale, surface_colour, nullptr);
+            const Eigen::Vector3f& point_W = surface_point_cloud_W[pixel_idx];
+            const bool hit = !point_W.isZero() && surface_normals_W[pixel_idx].x() != SE_INVALID;
+            dist_l(x_l, y_l) = hit ? (point_W - t_WS).norm() : -1.0f;
+        }
+    }
+
+    // Upsample the remaining pixels from the 4 surrounding grid samples with a joint-bilateral filter
+    // guided by their depth and normals and raycast them at full resolution near depth
+    // discontinuities. The samples are weighted bilinearly and by the similarity of their distance
+    // and normal to the bilinear estimates at the pixel, so samples on a different surface than the
+    // one the pixel is estimated on contribute less.
+
+    // The standard deviation of the normal weight on 1 - cos of the angle between the normals.
+    constexpr float normal_sigma = 0.5f;
+    size_t num_raycast = static_cast<size_t>(w_l) * h_l;
+    size_t num_error_samples = 0;
+    double error_sum = 0.0;
+    double normal_error_sum = 0.0;
+#pragma omp parallel for reduction(+ : num_raycast, num_error_samples, error_sum, normal_error_sum)
+    for (int y = 0; y < h; y++) {
+        for (int x = 0; x < w; x++) {
+            if (x % factor == 0 && y % factor == 0) {
+                continue;
+            }
+            const size_t pixel_idx = x + y * w;
+            const int x0 = x / factor;
+            const int y0 = y / factor;
+            const int x1 = (x % factor == 0) ? x0 : x0 + 1;
+            const int y1 = (y % factor == 0) ? y0 : y0 + 1;
+
+            bool interpolate = x1 < w_l && y1 < h_l;
+            float dist = 0.0f;
+            Eigen::Vector3f normal_W = Eigen::Vector3f::Zero();
+            if (interpolate) {
+                const float d[4] = {dist_l(x0, y0), dist_l(x1, y0), dist_l(x0, y1), dist_l(x1, y1)};
+                const float d_min = std::min({d[0], d[1], d[2], d[3]});
+                const float d_max = std::max({d[0], d[1], d[2], d[3]});
+                // Misses or samples on different sides of a depth edge.
+                interpolate = d_min > 0.0f && d_max - d_min <= depth_edge_threshold * d_min;
+                if (interpolate) {
+                    const float fx = static_cast<float>(x - x0 * factor) / factor;
+                    const float fy = static_cast<float>(y - y0 * factor) / factor;
+                    const float spatial_weights[4] = {(1 - fx) * (1 - fy), fx * (1 - fy), (1 - fx) * fy, fx * fy};
+                    const size_t sample_idxs[4] = {static_cast<size_t>(x0 * factor + y0 * factor * w),
+                                                   static_cast<size_t>(x1 * factor + y0 * factor * w),
+                                                   static_cast<size_t>(x0 * factor + y1 * factor * w),
+                                                   static_cast<size_t>(x1 * factor + y1 * factor * w)};
+                    // The guide at the pixel, the bilinear estimates of the distance and normal.
+                    float guide_dist = 0.0f;
+                    Eigen::Vector3f guide_normal_W = Eigen::Vector3f::Zero();
+                    for (int i = 0; i < 4; i++) {
+                        guide_dist += spatial_weights[i] * d[i];
+                        guide_normal_W += spatial_weights[i] * surface_normals_W[sample_idxs[i]];
                     }
-                }
-                if constexpr (MapT::sem_ != Semantics::Off) {
-                    if (has_semantics) {
-                        // Interpolate semantic class IDs doesn't make sense, just fetch.
-                        (*surface_class_id)[pixel_idx] = map.getData(surface_intersection_W->head<3>()).sem.class_id;
+                    guide_normal_W.normalize();
+                    const float depth_sigma = depth_edge_threshold * guide_dist;
+
+                    float weights[4];
+                    float weight_sum = 0.0f;
+                    for (int i = 0; i < 4; i++) {
+                        const float depth_diff = d[i] - guide_dist;
+                        const float normal_diff = 1.0f - surface_normals_W[sample_idxs[i]].dot(guide_normal_W);
+                        weights[i] = spatial_weights[i]
+                            * std::exp(-0.5f * (depth_diff * depth_diff / (depth_sigma * depth_sigma) + normal_diff * normal_diff / (normal_sigma * normal_sigma)));
+                        weight_sum += weights[i];
+                    }
+                    Eigen::Vector3f colour = Eigen::Vector3f::Zero();
+                    for (int i = 0; i < 4; i++) {
+                        const float weight = weights[i] / weight_sum;
+                        dist += weight * d[i];
+                        normal_W += weight * surface_normals_W[sample_idxs[i]];
+                        if (surface_colour) {
+                            const rgb_t& c = (*surface_colour)[sample_idxs[i]];
+                            colour += weight * Eigen::Vector3f(c.r, c.g, c.b);
+                        }
+                    }
+                    normal_W.normalize();
+                    // Interpolate the distance along the ray rather than the points to respect the
+                    // perspective projection.
+                    Eigen::Vector3f ray_dir_S;
+                    sensor.model.backProject(Eigen::Vector2f(x, y), &ray_dir_S);
+                    surface_point_cloud_W[pixel_idx] = t_WS + dist * (C_WS * ray_dir_S.normalized());
+                    surface_normals_W[pixel_idx] = normal_W;
+                    surface_scale[pixel_idx] = 0;
+                    if (surface_colour) {
+                        (*surface_colour)[pixel_idx] = {static_cast<uint8_t>(colour.x() + 0.5f), static_cast<uint8_t>(colour.y() + 0.5f), static_cast<uint8_t>(colour.z() + 0.5f)};
                     }
                 }
             }
-            else {
-                surface_point_cloud_W[pixel_idx] = Eigen::Vector3f::Zero();
-                surface_normals_W[pixel_idx] = Eigen::Vector3f::Constant(SE_INVALID);
-                surface_scale[pixel_idx] = 0;
-                if (has_colour) {
-                    (*surface_colour)[pixel_idx] = rgb_t{0, 0, 0};
+
+            if (!interpolate || pixel_idx % error_sample_stride == 0) {
+                const std::optional<Eigen::Vector4f> surface_intersection_W = raycast_pixel(map, T_WS, sensor, x, y);
+                set_surface_pixel(map, surface_intersection_W, pixel_idx, surface_point_cloud_W, surface_normals_W, surface_scale, surface_colour, nullptr);
+                if (interpolate && surface_intersection_W && !surface_intersection_W->head<3>().isZero() && surface_normals_W[pixel_idx].x() != SE_INVALID) {
+                    error_sum += std::fabs((surface_intersection_W->head<3>() - t_WS).norm() - dist);
+                    normal_error_sum += std::acos(std::clamp(normal_W.dot(surface_normals_W[pixel_idx]), -1.0f, 1.0f));
+                    num_error_samples++;
+                }
+                num_raycast++;
+            }
+        }
+    }
+
+    se::perfstats.sample("raycast pixels", num_raycast, PerfStats::COUNT);
+    se::perfstats.sample("raycast pixel budget", 100.0 * num_raycast / (static_cast<double>(w) * h), PerfStats::PERCENTAGE);
+    if (num_error_samples > 0) {
+        se::perfstats.sample("raycast upsampling error", error_sum / num_error_samples, PerfStats::DISTANCE);
+        // In degrees.
+        se::perfstats.sample("raycast upsampling normal error", 180.0 / M_PI * normal_error_sum / num_error_samples, PerfStats::DOUBLE);
+    }
+}
+
+
+template<typename MapT, typename SensorT>
+void raycast_volume_subsampled(const MapT& map,
+                               se::Image<Eigen::Vector3f>& surface_point_cloud_W,
+                               se::Image<Eigen::Vector3f>& surface_normals_W,
+                               se::Image<int8_t>& surface_scale,
+                               const Eigen::Matrix4f& T_WS,
+                               const SensorT& sensor,
+                               const int factor,
+                               const float depth_edge_threshold)
+{
+    raycast_volume_subsampled_kernel(map, surface_point_cloud_W, surface_normals_W, surface_scale, nullptr, T_WS, sensor, factor, depth_edge_threshold);
+}
+
+
+template<typename MapT, typename SensorT>
+typename std::enable_if_t<MapT::col_ == Colour::On> raycast_volume_subsampled(const MapT& map,
+                                                                              se::Image<Eigen::Vector3f>& surface_point_cloud_W,
+                                                                              se::Image<Eigen::Vector3f>& surface_normals_W,
+                                                                              se::Image<int8_t>& surface_scale,
+                                                                              se::Image<rgb_t>& surface_colour,
+                                                                              const Eigen::Matrix4f& T_WS,
+                                                                              const SensorT& sensor,
+                                                                              const int factor,
+                                                                              const float depth_edge_threshold)
+{
+    raycast_volume_subsampled_kernel(map, surface_point_cloud_W, surface_normals_W, surface_scale, &surface_colour, T_WS, sensor, factor, depth_edge_threshold);
+}
+
+
+template<typename MapT, typename SensorT>
+void raycast_volume_reprojected_kernel(const MapT& map,
+                                       se::Image<Eigen::Vector3f>& surface_point_cloud_W,
+                                       se::Image<Eigen::Vector3f>& surface_normals_W,
+                                       se::Image<int8_t>& surface_scale,
+                                       se::Image<rgb_t>* surface_colour,
+                                       const Eigen::Matrix4f& T_WS,
+                                       const SensorT& sensor,
+                                       const se::Image<Eigen::Vector3f>& prev_surface_point_cloud_W)
+{
+    static_assert(MapT::fld_ == Field::TSDF, "The reprojection raycaster only supports TSDF maps");
+    const int w = surface_point_cloud_W.width();
+    const int h = surface_point_cloud_W.height();
+    resize_surface_images(w, h, surface_normals_W, surface_scale, surface_colour, nullptr);
+
+    const Eigen::Matrix4f T_SW = se::math::to_inverse_transformation(T_WS);
+    const Eigen::Matrix3f C_WS = se::math::to_rotation(T_WS);
+    const Eigen::Vector3f t_WS = se::math::to_translation(T_WS);
+    // Start the march this far before the predicted surface and give up this far after it.
+    const float search_margin = 2.0f * map.getRes() * map.getDataConfig().truncation_boundary_factor;
+
+    // Forward-project the previous surface into the current view keeping the closest point per
+    // pixel. Each thread splats into its own distance image to avoid write races and the images are
+    // then merged by keeping the minimum distance, so the result doesn't depend on the number of
+    // threads.
+    constexpr float no_prediction = std::numeric_limits<float>::infinity();
+#ifdef _OPENMP
+    const int num_threads = omp_get_max_threads();
+#else
+    const int num_threads = 1;
+#endif
+    std::vector<se::Image<float>> thread_splatted_dists(num_threads, se::Image<float>(w, h, no_prediction));
+#pragma omp parallel for
+    for (size_t i = 0; i < prev_surface_point_cloud_W.size(); i++) {
+        const Eigen::Vector3f& point_W = prev_surface_point_cloud_W[i];
+        if (point_W.isZero()) {
+            continue;
+        }
+        const Eigen::Vector3f point_S = (T_SW * point_W.homogeneous()).head<3>();
+        Eigen::Vector2f pixel_f;
+        if (sensor.model.project(point_S, &pixel_f) != srl::projection::ProjectionStatus::Successful) {
+            continue;
+        }
+        const Eigen::Vector2i pixel = se::round_pixel(pixel_f);
+        if (pixel.x() < 0 || pixel.x() >= w || pixel.y() < 0 || pixel.y() >= h) {
+            continue;
+        }
+#ifdef _OPENMP
+        se::Image<float>& splatted_dist = thread_splatted_dists[omp_get_thread_num()];
+#else
+        se::Image<float>& splatted_dist = thread_splatted_dists[0];
+#endif
+        float& dist = splatted_dist(pixel.x(), pixel.y());
+        dist = std::min(dist, point_S.norm());
+    }
+    se::Image<float>& splatted_dist = thread_splatted_dists[0];
+#pragma omp parallel for
+    for (size_t i = 0; i < splatted_dist.size(); i++) {
+        for (int t = 1; t < num_threads; t++) {
+            splatted_dist[i] = std::min(splatted_dist[i], thread_splatted_dists[t][i]);
+        }
+    }
+
+    size_t num_reprojected = 0;
+    size_t num_fallback = 0;
+#pragma omp parallel for reduction(+ : num_reprojected, num_fallback)
+    for (int y = 0; y < h; y++) {
+        for (int x = 0; x < w; x++) {
+            const size_t pixel_idx = x + y * w;
+            // Fill the holes left by the forward projection from the 3x3 neighbourhood.
+            float predicted_dist = splatted_dist(x, y);
+            if (predicted_dist == no_prediction) {
+                for (int v = std::max(y - 1, 0); v <= std::min(y + 1, h - 1); v++) {
+                    for (int u = std::max(x - 1, 0); u <= std::min(x + 1, w - 1); u++) {
+                        predicted_dist = std::min(predicted_dist, splatted_dist(u, v));
+                    }
                 }
-                if (has_semantics) {
-                    (*surface_class_id)[pixel_idx] = semantics_t(0);
+            }
+
+            Eigen::Vector3f ray_dir_S;
+            sensor.model.backProject(Eigen::Vector2f(x, y), &ray_dir_S);
+            const Eigen::Vector3f ray_dir_W = C_WS * ray_dir_S.normalized();
+            const float t_near = sensor.nearDist(ray_dir_S);
+            const float t_far = sensor.farDist(ray_dir_S);
+
+            std::optional<Eigen::Vector4f> surface_intersection_W;
+            if (predicted_dist != no_prediction) {
+                const float t_start = std::max(predicted_dist - search_margin, t_near);
+                const float t_end = std::min(predicted_dist + search_margin, t_far);
+                const Eigen::Vector4f intersection_W = march_tsdf(map, t_WS, ray_dir_W, t_start, t_end);
+                if (!intersection_W.head<3>().isZero()) {
+                    surface_intersection_W = intersection_W;
+                    num_reprojected++;
                 }
             }
-        } // x
-    }     // y
+            if (!surface_intersection_W) {
+                // Disoccluded pixel or wrong prediction, march the whole ray.
+                surface_intersection_W = raycast(map, *(map.getOctree()), t_WS, ray_dir_W, t_near, t_far);
+                num_fallback++;
+            }
+            set_surface_pixel(map, surface_intersection_W, pixel_idx, surface_point_cloud_W, surface_normals_W, surface_scale, surface_colour, nullptr);
+        }
+    }
+
+    se::perfstats.sample("raycast reprojected pixels", num_reprojected, PerfStats::COUNT);
+    se::perfstats.sample("raycast fallback pixels", num_fallback, PerfStats::COUNT);
+}
+
+
+template<typename MapT, typename SensorT>
+void raycast_volume_reprojected(const MapT& map,
+                                se::Image<Eigen::Vector3f>& surface_point_cloud_W,
+                                se::Image<Eigen::Vector3f>& surface_normals_W,
+                                se::Image<int8_t>& surface_scale,
+                                const Eigen::Matrix4f& T_WS,
+                                const SensorT& sensor,
+                                const se::Image<Eigen::Vector3f>& prev_surface_point_cloud_W)
+{
+    raycast_volume_reprojected_kernel(map, surface_point_cloud_W, surface_normals_W, surface_scale, nullptr, T_WS, sensor, prev_surface_point_cloud_W);
+}
+
+
+template<typename MapT, typename SensorT>
+typename std::enable_if_t<MapT::col_ == Colour::On> raycast_volume_reprojected(const MapT& map,
+                                                                               se::Image<Eigen::Vector3f>& surface_point_cloud_W,
+                                                                               se::Image<Eigen::Vector3f>& surface_normals_W,
+                                                                               se::Image<int8_t>& surface_scale,
+                                                                               se::Image<rgb_t>& surface_colour,
+                                                                               const Eigen::Matrix4f& T_WS,
+                                                                               const SensorT& sensor,
+                                                                               const se::Image<Eigen::Vector3f>& prev_surface_point_cloud_W)
+{
+    raycast_volume_reprojected_kernel(map, surface_point_cloud_W, surface_normals_W, surface_scale, &surface_colour, T_WS, sensor, prev_surface_point_cloud_W);
 }
 
 
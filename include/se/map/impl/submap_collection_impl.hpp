@@ -0,0 +1,348 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Smart Robotics Lab, Technical University of Munich
+ * SPDX-FileCopyrightText: 2024 Jiaxin Wei
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef SE_SUBMAP_COLLECTION_IMPL_HPP
+#define SE_SUBMAP_COLLECTION_IMPL_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <limits>
+
+namespace se {
+
+namespace details {
+
+/** Return the AABB in frame B of an AABB in frame A. Empty boxes stay empty.
+ */
+static inline Eigen::AlignedBox3f transform_aabb(const Eigen::Matrix4f& T_BA, const Eigen::AlignedBox3f& aabb_A)
+{
+    if (aabb_A.isEmpty()) {
+        return Eigen::AlignedBox3f();
+    }
+    Eigen::AlignedBox3f aabb_B;
+    for (int i = 0; i < 8; i++) {
+        const Eigen::Vector3f corner_A = aabb_A.corner(static_cast<Eigen::AlignedBox3f::CornerType>(i));
+        aabb_B.extend((T_BA * corner_A.homogeneous()).head<3>());
+    }
+    return aabb_B;
+}
+
+} // namespace details
+
+
+template<typename MapT>
+SubmapCollection<MapT>::SubmapCollection(const MapConfig& map_config, const DataConfigType& data_config) :
+        map_config_(map_config), data_config_(data_config), cell_size_(map_config.dim.maxCoeff() / 4)
+{
+}
+
+
+template<typename MapT>
+bool SubmapCollection<MapT>::update(const Eigen::Matrix4f& T_WS, const int frame)
+{
+    const Eigen::Vector3f t_WS = math::to_translation(T_WS);
+    bool start_submap = submaps_.empty();
+    if (!start_submap) {
+        const Submap& submap = active();
+        if (map_config_.submap_frames > 0 && frame - submap.start_frame >= map_config_.submap_frames) {
+            start_submap = true;
+        }
+        if (map_config_.submap_distance > 0.0f && (t_WS - submap.t_WS_start).norm() >= map_config_.submap_distance) {
+            start_submap = true;
+        }
+    }
+
+    if (start_submap) {
+        // Anchor the new submap at the sensor position but keep the world orientation so that the
+        // submap volume stays aligned with gravity.
+        const Eigen::Matrix4f T_WA = math::to_transformation(t_WS);
+        submaps_.emplace_back(new Submap(map_config_, data_config_, T_WA, frame, t_WS));
+        aabbs_W_.emplace_back();
+    }
+    active().last_frame = frame;
+    return start_submap;
+}
+
+
+template<typename MapT>
+void SubmapCollection<MapT>::updateBounds(const size_t idx)
+{
+    Submap& submap = *submaps_[idx];
+    // Octree::aabb() is maintained during allocation so this doesn't depend on the submap size.
+    if (submap.map->getOctree()->aabb().isEmpty()) {
+        submap.aabb_A = Eigen::AlignedBox3f();
+    }
+    else {
+        submap.aabb_A = submap.map->aabb();
+    }
+    setBounds(idx, details::transform_aabb(submap.T_WA, submap.aabb_A));
+}
+
+
+template<typename MapT>
+void SubmapCollection<MapT>::setAnchor(const size_t idx, const Eigen::Matrix4f& T_WA)
+{
+    Submap& submap = *submaps_[idx];
+    submap.T_WA = T_WA;
+    submap.T_AW = math::to_inverse_transformation(T_WA);
+    setBounds(idx, details::transform_aabb(submap.T_WA, submap.aabb_A));
+}
+
+
+template<typename MapT>
+std::vector<size_t> SubmapCollection<MapT>::query(const Eigen::Vector3f& point_W) const
+{
+    std::vector<size_t> indices;
+    const auto cell_itr = cells_.find(cellKey(point_W));
+    if (cell_itr == cells_.end()) {
+        return indices;
+    }
+    const std::vector<size_t>& cell = cell_itr->second;
+    for (auto i_itr = cell.rbegin(); i_itr != cell.rend(); ++i_itr) {
+        if (aabbs_W_[*i_itr].contains(point_W)) {
+            indices.push_back(*i_itr);
+        }
+    }
+    return indices;
+}
+
+
+template<typename MapT>
+std::vector<size_t> SubmapCollection<MapT>::query(const Eigen::AlignedBox3f& box_W) const
+{
+    std::vector<size_t> indices;
+    if (box_W.isEmpty()) {
+        return indices;
+    }
+    const Eigen::Array3f num_cells = (box_W.max() / cell_size_).array().floor() - (box_W.min() / cell_size_).array().floor() + 1;
+    if (num_cells.prod() > aabbs_W_.size()) {
+        // Visiting the cells costs more than testing every submap.
+        for (size_t i = aabbs_W_.size(); i-- > 0;) {
+            if (aabbs_W_[i].intersects(box_W)) {
+                indices.push_back(i);
+            }
+        }
+        return indices;
+    }
+    forEachCell(box_W, [&](const CellKey& key) {
+        const auto cell_itr = cells_.find(key);
+        if (cell_itr != cells_.end()) {
+            indices.insert(indices.end(), cell_itr->second.begin(), cell_itr->second.end());
+        }
+    });
+    std::sort(indices.begin(), indices.end(), std::greater<size_t>());
+    indices.erase(std::unique(indices.begin(), indices.end()), indices.end());
+    indices.erase(std::remove_if(indices.begin(), indices.end(), [&](const size_t i) { return !aabbs_W_[i].intersects(box_W); }), indices.end());
+    return indices;
+}
+
+
+template<typename MapT>
+typename SubmapCollection<MapT>::DataType SubmapCollection<MapT>::getData(const Eigen::Vector3f& point_W) const
+{
+    for (const size_t i : query(point_W)) {
+        const Submap& submap = *submaps_[i];
+        const Eigen::Vector3f point_A = (submap.T_AW * point_W.homogeneous()).template head<3>();
+        const DataType data = submap.map->getData(point_A);
+        if (is_valid(data)) {
+            return data;
+        }
+    }
+    return DataType();
+}
+
+
+template<typename MapT>
+std::optional<float> SubmapCollection<MapT>::getFieldInterp(const Eigen::Vector3f& point_W) const
+{
+    for (const size_t i : query(point_W)) {
+        const Submap& submap = *submaps_[i];
+        const Eigen::Vector3f point_A = (submap.T_AW * point_W.homogeneous()).template head<3>();
+        const std::optional<float> field = submap.map->getFieldInterp(point_A);
+        if (field) {
+            return field;
+        }
+    }
+    return std::nullopt;
+}
+
+
+template<typename MapT>
+bool SubmapCollection<MapT>::observedBefore(const Eigen::Vector3f& point_W, const size_t idx) const
+{
+    for (const size_t i : query(point_W)) {
+        if (i >= idx) {
+            continue;
+        }
+        const Submap& submap = *submaps_[i];
+        const Eigen::Vector3f point_A = (submap.T_AW * point_W.homogeneous()).template head<3>();
+        if (is_valid(submap.map->getData(point_A))) {
+            return true;
+        }
+    }
+    return false;
+}
+
+
+template<typename MapT>
+typename SubmapCollection<MapT>::OctreeType::MeshType SubmapCollection<MapT>::mesh(const Eigen::Matrix4f& T_OW) const
+{
+    std::vector<typename OctreeType::MeshType> meshes(submaps_.size());
+#pragma omp parallel for
+    for (size_t i = 0; i < submaps_.size(); i++) {
+        meshes[i] = submaps_[i]->map->mesh(T_OW * submaps_[i]->T_WA);
+    }
+
+    typename OctreeType::MeshType mesh;
+    size_t num_faces = 0;
+    for (const auto& m : meshes) {
+        num_faces += m.size();
+    }
+    mesh.reserve(num_faces);
+    for (auto& m : meshes) {
+        mesh.insert(mesh.end(), m.begin(), m.end());
+    }
+    return mesh;
+}
+
+
+template<typename MapT>
+int SubmapCollection<MapT>::saveMesh(const std::string& filename, const Eigen::Matrix4f& T_OW) const
+{
+    return io::save_mesh(mesh(T_OW), filename);
+}
+
+
+template<typename MapT>
+template<typename SensorT>
+void SubmapCollection<MapT>::raycastVolume(Image<Eigen::Vector3f>& surface_point_cloud_W,
+                                           Image<Eigen::Vector3f>& surface_normals_W,
+                                           Image<int8_t>& surface_scale,
+                                           Image<rgb_t>* surface_colour,
+                                           const Eigen::Matrix4f& T_WS,
+                                           const SensorT& sensor) const
+{
+    const int w = surface_point_cloud_W.width();
+    const int h = surface_point_cloud_W.height();
+    const Eigen::Matrix4f T_SW = math::to_inverse_transformation(T_WS);
+    const Eigen::Vector3f t_WS = math::to_translation(T_WS);
+
+    std::fill(surface_point_cloud_W.data(), surface_point_cloud_W.data() + surface_point_cloud_W.size(), Eigen::Vector3f::Zero());
+    surface_normals_W = Image<Eigen::Vector3f>(w, h, Eigen::Vector3f::Constant(SE_INVALID));
+    surface_scale = Image<int8_t>(w, h, 0);
+    if (surface_colour) {
+        *surface_colour = Image<rgb_t>(w, h, rgb_t{0, 0, 0});
+    }
+    Image<float> surface_dist(w, h, std::numeric_limits<float>::infinity());
+
+    Image<Eigen::Vector3f> submap_point_cloud(w, h);
+    Image<Eigen::Vector3f> submap_normals(w, h);
+    Image<int8_t> submap_scale(w, h);
+    Image<rgb_t> submap_colour(w, h);
+    for (size_t i = 0; i < submaps_.size(); i++) {
+        const Eigen::AlignedBox3f& aabb_W = aabbs_W_[i];
+        if (aabb_W.isEmpty()) {
+            continue;
+        }
+        // Cull submaps whose bounding sphere is outside the sensor frustum.
+        const Eigen::Vector3f centre_S = (T_SW * aabb_W.center().homogeneous()).head<3>();
+        if (!sensor.sphereInFrustum(centre_S, 0.5f * aabb_W.diagonal().norm())) {
+            continue;
+        }
+
+        const Submap& submap = *submaps_[i];
+        const Eigen::Matrix4f T_AS = submap.T_AW * T_WS;
+        bool raycast_colour = false;
+        if constexpr (MapT::col_ == Colour::On) {
+            if (surface_colour) {
+                raycaster::raycast_volume(*submap.map, submap_point_cloud, submap_normals, submap_scale, submap_colour, T_AS, sensor);
+                raycast_colour = true;
+            }
+        }
+        if (!raycast_colour) {
+            raycaster::raycast_volume(*submap.map, submap_point_cloud, submap_normals, submap_scale, T_AS, sensor);
+        }
+
+        const Eigen::Matrix3f C_WA = math::to_rotation(submap.T_WA);
+#pragma omp parallel for
+        for (size_t pixel_idx = 0; pixel_idx < surface_dist.size(); pixel_idx++) {
+            const Eigen::Vector3f& point_A = submap_point_cloud[pixel_idx];
+            if (point_A.isZero()) {
+                continue;
+            }
+            const Eigen::Vector3f point_W = (submap.T_WA * point_A.homogeneous()).template head<3>();
+            const float dist = (point_W - t_WS).norm();
+            if (dist >= surface_dist[pixel_idx]) {
+                continue;
+            }
+            surface_dist[pixel_idx] = dist;
+            surface_point_cloud_W[pixel_idx] = point_W;
+            const Eigen::Vector3f& normal_A = submap_normals[pixel_idx];
+            surface_normals_W[pixel_idx] = normal_A.x() == SE_INVALID ? normal_A : (C_WA * normal_A).eval();
+            surface_scale[pixel_idx] = submap_scale[pixel_idx];
+            if (raycast_colour) {
+                (*surface_colour)[pixel_idx] = submap_colour[pixel_idx];
+            }
+        }
+    }
+}
+
+
+template<typename MapT>
+typename SubmapCollection<MapT>::CellKey SubmapCollection<MapT>::cellKey(const Eigen::Vector3f& point_W) const
+{
+    const Eigen::Vector3i cell = (point_W / cell_size_).array().floor().template cast<int>();
+    return {cell.x(), cell.y(), cell.z()};
+}
+
+
+template<typename MapT>
+template<typename FunctionT>
+void SubmapCollection<MapT>::forEachCell(const Eigen::AlignedBox3f& box_W, FunctionT function) const
+{
+    const CellKey min_cell = cellKey(box_W.min());
+    const CellKey max_cell = cellKey(box_W.max());
+    for (int z = min_cell[2]; z <= max_cell[2]; z++) {
+        for (int y = min_cell[1]; y <= max_cell[1]; y++) {
+            for (int x = min_cell[0]; x <= max_cell[0]; x++) {
+                function(CellKey{x, y, z});
+            }
+        }
+    }
+}
+
+
+template<typename MapT>
+void SubmapCollection<MapT>::setBounds(const size_t idx, const Eigen::AlignedBox3f& aabb_W)
+{
+    Eigen::AlignedBox3f& old_aabb_W = aabbs_W_[idx];
+    const bool same_cells = !old_aabb_W.isEmpty() && !aabb_W.isEmpty() && cellKey(old_aabb_W.min()) == cellKey(aabb_W.min())
+        && cellKey(old_aabb_W.max()) == cellKey(aabb_W.max());
+    if (!same_cells) {
+        if (!old_aabb_W.isEmpty()) {
+            forEachCell(old_aabb_W, [&](const CellKey& key) {
+                const auto cell_itr = cells_.find(key);
+                std::vector<size_t>& cell = cell_itr->second;
+                cell.erase(std::lower_bound(cell.begin(), cell.end(), idx));
+                if (cell.empty()) {
+                    cells_.erase(cell_itr);
+                }
+            });
+        }
+        if (!aabb_W.isEmpty()) {
+            forEachCell(aabb_W, [&](const CellKey& key) {
+                std::vector<size_t>& cell = cells_[key];
+                cell.insert(std::lower_bound(cell.begin(), cell.end(), idx), idx);
+            });
+        }
+    }
+    old_aabb_W = aabb_W;
+}
+
+} // namespace se
+
+#endif // SE_SUBMAP_COLLECTION_IMPL_HPP
@@ -0,0 +1,161 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Smart Robotics Lab, Technical University of Munich
+ * SPDX-FileCopyrightText: 2024 Jiaxin Wei
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef SE_CHANGE_FEED_HPP
+#define SE_CHANGE_FEED_HPP
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "se/common/timings.hpp"
+#include "se/map/data.hpp"
+#include "se/map/octree/allocator.hpp"
+#include "se/map/octree/fetcher.hpp"
+#include "se/map/octree/iterator.hpp"
+#include "se/map/octree/propagator.hpp"
+#include "se/map/utils/key_util.hpp"
+
+
+namespace se {
+namespace io {
+
+/**
+ * \brief Publish the changes of a single-resolution TSDF map after each integration so that
+ * subscribers can mirror it with bandwidth proportional to the change.
+ *
+ * changedBlocks() returns the keys of the blocks whose time stamp is newer than at the previous
+ * call. encode() serialises the voxels of those blocks that differ from what the subscribers were
+ * last sent, and apply() updates a mirror map from the serialised deltas.
+ *
+ * The feed keeps a shadow copy of the quantised voxels sent for every block, costing
+ * record_size bytes per voxel, so that changes are computed against the subscriber state rather
+ * than the full-precision map. Without an se::ActiveWindow this is a second, smaller copy of every
+ * observed block, see shadowBytes(). Changes smaller than the quantisation step are not sent until they
+ * accumulate. Blocks that were only touched, e.g. fetched but culled by the updater, produce no
+ * delta. Blocks removed from the map, e.g. by se::ActiveWindow, must be passed to forget() so that
+ * their state is dropped and the subscribers are told to remove them.
+ *
+ * Delta format, all values little-endian:
+ * - Header: the magic `GSCF`, uint8 version, uint8 flags (bit 0: colour), uint8 block size,
+ *   uint8 reserved, int32 map time stamp, uint32 number of changed blocks and uint32 number of
+ *   removed blocks.
+ * - Per removed block: the int32 x, y and z voxel coordinates of the block. Removed blocks come
+ *   before the changed blocks so that a block removed and observed again is sent in full.
+ * - Per block: the int32 x, y and z voxel coordinates of the block followed by runs covering all
+ *   voxels in block data order. Each run is a varint number of unchanged voxels, a varint number
+ *   of changed voxels and the records of the changed voxels.
+ * - Per voxel record: int8 TSDF quantised to [-127, 127], uint8 weight and, with colour, uint8 R,
+ *   G and B.
+ *
+ * Varints are unsigned LEB128.
+ */
+template<typename MapT>
+class ChangeFeed {
+    public:
+    typedef typename MapT::OctreeType OctreeType;
+    typedef typename OctreeType::BlockType BlockType;
+    typedef typename MapT::DataType DataType;
+
+    static_assert(MapT::fld_ == Field::TSDF && MapT::res_ == Res::Single, "ChangeFeed supports single-resolution TSDF maps only");
+
+    static constexpr char magic[4] = {'G', 'S', 'C', 'F'};
+    static constexpr uint8_t version = 2;
+    static constexpr size_t header_size = 20;
+    static constexpr size_t record_size = MapT::col_ == Colour::On ? 5 : 2;
+
+    ChangeFeed();
+
+    /**
+     * \brief Return the keys of the blocks modified since the previous call, i.e. the blocks
+     * updated by the integrations in between.
+     */
+    std::vector<key_t> changedBlocks(const MapT& map);
+
+    /**
+     * \brief Drop the state kept for a block removed from the map. The next call to encode()
+     * tells the subscribers to remove it if it was sent to them. If the block is allocated again
+     * it is compared against unobserved voxels.
+     */
+    void forget(const key_t block_key);
+
+    /**
+     * \brief Serialise the changes of the provided blocks since they were last encoded and the
+     * blocks forgotten since the previous call, and append them to deltas. Blocks encoded for the
+     * first time are compared against unobserved voxels.
+     *
+     * \param[in]  map        The map the blocks belong to.
+     * \param[in]  block_keys The keys of the blocks to encode, usually from changedBlocks().
+     * \param[out] deltas     The buffer the serialised deltas are appended to.
+     * \return The number of blocks with changed voxels plus the number of removed blocks.
+     */
+    size_t encode(const MapT& map, const std::vector<key_t>& block_keys, std::vector<uint8_t>& deltas);
+
+    /**
+     * \brief Apply serialised deltas to a mirror map, deleting the removed blocks and allocating
+     * blocks as needed. The mirror must have the same block size and colour configuration as the
+     * published map.
+     *
+     * \param[in] map    The mirror map to update.
+     * \param[in] deltas The buffer containing the serialised deltas of one call to encode().
+     * \param[in] size   The size of deltas in bytes.
+     * \return Zero on success, non-zero if the deltas are malformed or incompatible with the map.
+     */
+    static int apply(MapT& map, const uint8_t* deltas, const size_t size);
+
+    /**
+     * \brief Return the number of blocks whose state is kept for the subscribers.
+     */
+    size_t numShadowBlocks() const
+    {
+        return shadow_.size();
+    }
+
+    /**
+     * \brief Return an estimate of the number of bytes used by the state kept for the subscribers.
+     * Without forget() it grows with every block ever encoded.
+     */
+    size_t shadowBytes() const
+    {
+        // Each element is a heap node holding the key, the vector and the next pointer, plus the
+        // records and the bucket array
+        return shadow_.size() * (sizeof(key_t) + sizeof(std::vector<Record>) + sizeof(void*) + BlockType::size_cu * sizeof(Record))
+            + shadow_.bucket_count() * sizeof(void*);
+    }
+
+    private:
+    typedef std::array<uint8_t, record_size> Record;
+
+    static Record quantise(const DataType& data);
+
+    static void dequantise(const uint8_t* record, DataType& data);
+
+    /** The time stamp of the root at the previous call to changedBlocks(). */
+    timestamp_t last_timestamp_;
+    /** The quantised records last encoded for each block, in block data order. */
+    std::unordered_map<key_t, std::vector<Record>> shadow_;
+    /** The keys of the forgotten blocks the subscribers haven't been told to remove yet. */
+    std::vector<key_t> removed_keys_;
+};
+
+
+/**
+ * \brief Write the deltas of the blocks modified or removed since the previous call to filename,
+ * see se::io::ChangeFeed. No file is written when nothing changed.
+ *
+ * \return Zero on success, non-zero on error.
+ */
+template<typename MapT>
+int save_change_feed(ChangeFeed<MapT>& feed, const MapT& map, const std::string& filename);
+
+} // namespace io
+} // namespace se
+
+#include "impl/change_feed_impl.hpp"
+
+#endif // SE_CHANGE_FEED_HPP
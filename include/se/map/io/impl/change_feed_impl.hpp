@@ -0,0 +1,322 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Smart Robotics Lab, Technical University of Munich
+ * SPDX-FileCopyrightText: 2024 Jiaxin Wei
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef SE_CHANGE_FEED_IMPL_HPP
+#define SE_CHANGE_FEED_IMPL_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+namespace se {
+namespace io {
+namespace detail {
+
+inline void append_varint(std::vector<uint8_t>& buffer, uint32_t value)
+{
+    while (value >= 0x80) {
+        buffer.push_back((value & 0x7F) | 0x80);
+        value >>= 7;
+    }
+    buffer.push_back(value);
+}
+
+
+inline void append_uint32(std::vector<uint8_t>& buffer, const uint32_t value)
+{
+    for (int i = 0; i < 4; i++) {
+        buffer.push_back((value >> (8 * i)) & 0xFF);
+    }
+}
+
+
+inline void write_uint32(uint8_t* buffer, const uint32_t value)
+{
+    for (int i = 0; i < 4; i++) {
+        buffer[i] = (value >> (8 * i)) & 0xFF;
+    }
+}
+
+
+inline uint32_t read_uint32(const uint8_t* buffer)
+{
+    return buffer[0] | (buffer[1] << 8) | (buffer[2] << 16) | (static_cast<uint32_t>(buffer[3]) << 24);
+}
+
+
+/** Read a varint at offset and advance offset past it. Return false if it is truncated or
+ * doesn't fit in 32 bits.
+ */
+inline bool read_varint(const uint8_t* buffer, const size_t size, size_t& offset, uint32_t& value)
+{
+    value = 0;
+    for (int shift = 0; shift < 35; shift += 7) {
+        if (offset >= size) {
+            return false;
+        }
+        const uint8_t byte = buffer[offset++];
+        value |= static_cast<uint32_t>(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+} // namespace detail
+
+
+template<typename MapT>
+constexpr char ChangeFeed<MapT>::magic[4];
+
+
+template<typename MapT>
+ChangeFeed<MapT>::ChangeFeed() : last_timestamp_(-1)
+{
+}
+
+
+template<typename MapT>
+std::vector<key_t> ChangeFeed<MapT>::changedBlocks(const MapT& map)
+{
+    // GSUpdater stamps every block it updates with the frame and propagates the time stamp to the
+    // root, so the iterator skips the subtrees that didn't change since the previous call.
+    OctreeType* octree_ptr = map.getOctree().get();
+    std::vector<key_t> block_keys;
+    for (auto block_ptr_itr = UpdateIterator<OctreeType>(octree_ptr, last_timestamp_ + 1); block_ptr_itr != UpdateIterator<OctreeType>(); ++block_ptr_itr) {
+        const BlockType* block_ptr = static_cast<const BlockType*>(*block_ptr_itr);
+        block_keys.push_back(keyops::encode_key(block_ptr->getCoord(), OctreeType::max_block_scale));
+    }
+    last_timestamp_ = std::max(last_timestamp_, octree_ptr->getRoot()->getTimeStamp());
+    return block_keys;
+}
+
+
+template<typename MapT>
+void ChangeFeed<MapT>::forget(const key_t block_key)
+{
+    // Blocks never encoded don't exist in the subscribers' maps.
+    if (shadow_.erase(block_key)) {
+        removed_keys_.push_back(block_key);
+    }
+}
+
+
+template<typename MapT>
+size_t ChangeFeed<MapT>::encode(const MapT& map, const std::vector<key_t>& block_keys, std::vector<uint8_t>& deltas)
+{
+    const OctreeType& octree = *map.getOctree();
+    const size_t header_offset = deltas.size();
+    deltas.insert(deltas.end(), magic, magic + 4);
+    deltas.push_back(version);
+    deltas.push_back(MapT::col_ == Colour::On ? 1 : 0);
+    deltas.push_back(BlockType::getSize());
+    deltas.push_back(0);
+    detail::append_uint32(deltas, last_timestamp_);
+    detail::append_uint32(deltas, 0);
+    detail::append_uint32(deltas, removed_keys_.size());
+
+    for (const key_t block_key : removed_keys_) {
+        const Eigen::Vector3i block_coord = keyops::key_to_coord(block_key);
+        for (int i = 0; i < 3; i++) {
+            detail::append_uint32(deltas, block_coord[i]);
+        }
+    }
+    const size_t num_removed_blocks = removed_keys_.size();
+    removed_keys_.clear();
+
+    const Record unobserved_record = quantise(DataType());
+    size_t num_changed_blocks = 0;
+    for (const key_t block_key : block_keys) {
+        const Eigen::Vector3i block_coord = keyops::key_to_coord(block_key);
+        const OctantBase* octant_ptr = fetcher::block<OctreeType>(block_coord, octree.getRoot());
+        if (!octant_ptr) {
+            continue;
+        }
+        const BlockType& block = *static_cast<const BlockType*>(octant_ptr);
+        auto shadow_itr = shadow_.find(block_key);
+        if (shadow_itr == shadow_.end()) {
+            shadow_itr = shadow_.emplace(block_key, std::vector<Record>(BlockType::size_cu, unobserved_record)).first;
+        }
+        std::vector<Record>& shadow = shadow_itr->second;
+
+        // Write the runs to the end of the buffer and drop them again if nothing changed.
+        const size_t block_offset = deltas.size();
+        for (int i = 0; i < 3; i++) {
+            detail::append_uint32(deltas, block_coord[i]);
+        }
+        bool changed = false;
+        int voxel_idx = 0;
+        while (voxel_idx < BlockType::size_cu) {
+            const int run_start = voxel_idx;
+            while (voxel_idx < BlockType::size_cu && quantise(block.getData(voxel_idx)) == shadow[voxel_idx]) {
+                voxel_idx++;
+            }
+            const int num_unchanged = voxel_idx - run_start;
+            const int changed_start = voxel_idx;
+            Record record;
+            while (voxel_idx < BlockType::size_cu && (record = quantise(block.getData(voxel_idx))) != shadow[voxel_idx]) {
+                shadow[voxel_idx] = record;
+                voxel_idx++;
+            }
+            const int num_changed = voxel_idx - changed_start;
+            detail::append_varint(deltas, num_unchanged);
+            detail::append_varint(deltas, num_changed);
+            for (int i = changed_start; i < voxel_idx; i++) {
+                deltas.insert(deltas.end(), shadow[i].begin(), shadow[i].end());
+            }
+            changed |= num_changed > 0;
+        }
+        if (changed) {
+            num_changed_blocks++;
+        }
+        else {
+            deltas.resize(block_offset);
+        }
+    }
+    detail::write_uint32(deltas.data() + header_offset + 12, num_changed_blocks);
+    return num_changed_blocks + num_removed_blocks;
+}
+
+
+template<typename MapT>
+int ChangeFeed<MapT>::apply(MapT& map, const uint8_t* deltas, const size_t size)
+{
+    if (size < header_size || std::memcmp(deltas, magic, 4) != 0 || deltas[4] != version) {
+        std::cerr << "Error: Invalid change feed header\n";
+        return 1;
+    }
+    if (deltas[5] != (MapT::col_ == Colour::On ? 1 : 0) || deltas[6] != BlockType::getSize()) {
+        std::cerr << "Error: The change feed doesn't match the block size or colour of the map\n";
+        return 1;
+    }
+    const timestamp_t timestamp = detail::read_uint32(deltas + 8);
+    const uint32_t num_blocks = detail::read_uint32(deltas + 12);
+    const uint32_t num_removed_blocks = detail::read_uint32(deltas + 16);
+
+    OctreeType& octree = *map.getOctree();
+    size_t offset = header_size;
+    for (uint32_t b = 0; b < num_removed_blocks; b++) {
+        if (offset + 12 > size) {
+            std::cerr << "Error: Truncated change feed\n";
+            return 1;
+        }
+        Eigen::Vector3i block_coord;
+        for (int i = 0; i < 3; i++) {
+            block_coord[i] = static_cast<int32_t>(detail::read_uint32(deltas + offset));
+            offset += 4;
+        }
+        if (!octree.contains(block_coord)) {
+            std::cerr << "Error: Change feed block " << block_coord.transpose() << " is outside the map\n";
+            return 1;
+        }
+        OctantBase* octant_ptr = fetcher::block<OctreeType>(block_coord, octree.getRoot());
+        if (octant_ptr) {
+            octree.deleteBlock(static_cast<BlockType*>(octant_ptr));
+        }
+    }
+
+    std::vector<OctantBase*> block_ptrs;
+    block_ptrs.reserve(num_blocks);
+    for (uint32_t b = 0; b < num_blocks; b++) {
+        if (offset + 12 > size) {
+            std::cerr << "Error: Truncated change feed\n";
+            return 1;
+        }
+        Eigen::Vector3i block_coord;
+        for (int i = 0; i < 3; i++) {
+            block_coord[i] = static_cast<int32_t>(detail::read_uint32(deltas + offset));
+            offset += 4;
+        }
+        if (!octree.contains(block_coord)) {
+            std::cerr << "Error: Change feed block " << block_coord.transpose() << " is outside the map\n";
+            return 1;
+        }
+        BlockType& block = *static_cast<BlockType*>(allocator::block(block_coord, octree, octree.getRoot()));
+        int voxel_idx = 0;
+        while (voxel_idx < BlockType::size_cu) {
+            uint32_t num_unchanged;
+            uint32_t num_changed;
+            if (!detail::read_varint(deltas, size, offset, num_unchanged) || !detail::read_varint(deltas, size, offset, num_changed)
+                || num_unchanged + static_cast<uint64_t>(num_changed) == 0
+                || num_unchanged + static_cast<uint64_t>(num_changed) > static_cast<uint64_t>(BlockType::size_cu - voxel_idx)
+                || offset + num_changed * record_size > size) {
+                std::cerr << "Error: Malformed change feed block " << block_coord.transpose() << "\n";
+                return 1;
+            }
+            voxel_idx += num_unchanged;
+            for (uint32_t i = 0; i < num_changed; i++) {
+                dequantise(deltas + offset, block.getData(voxel_idx));
+                offset += record_size;
+                voxel_idx++;
+            }
+        }
+        block.setTimeStamp(timestamp);
+        block_ptrs.push_back(&block);
+    }
+    propagator::propagateTimeStampToRoot(block_ptrs);
+    return 0;
+}
+
+
+template<typename MapT>
+typename ChangeFeed<MapT>::Record ChangeFeed<MapT>::quantise(const DataType& data)
+{
+    Record record;
+    record[0] = static_cast<int8_t>(std::lround(std::clamp(data.tsdf / static_cast<float>(tsdf_t_scale), -1.0f, 1.0f) * 127.0f));
+    record[1] = data.weight;
+    if constexpr (MapT::col_ == Colour::On) {
+        record[2] = data.rgb.r;
+        record[3] = data.rgb.g;
+        record[4] = data.rgb.b;
+    }
+    return record;
+}
+
+
+template<typename MapT>
+void ChangeFeed<MapT>::dequantise(const uint8_t* record, DataType& data)
+{
+    data.tsdf = static_cast<tsdf_t>(static_cast<int8_t>(record[0]) / 127.0f * tsdf_t_scale);
+    data.weight = record[1];
+    if constexpr (MapT::col_ == Colour::On) {
+        data.rgb.r = record[2];
+        data.rgb.g = record[3];
+        data.rgb.b = record[4];
+    }
+}
+
+
+template<typename MapT>
+int save_change_feed(ChangeFeed<MapT>& feed, const MapT& map, const std::string& filename)
+{
+    TICK("change-feed")
+    const std::vector<key_t> block_keys = feed.changedBlocks(map);
+    std::vector<uint8_t> deltas;
+    const size_t num_changed_blocks = feed.encode(map, block_keys, deltas);
+    se::perfstats.sample("change feed blocks", num_changed_blocks, PerfStats::COUNT);
+    se::perfstats.sample("change feed size", deltas.size() / 1024.0 / 1024.0, PerfStats::MEMORY);
+    if (num_changed_blocks == 0) {
+        TOCK("change-feed")
+        return 0;
+    }
+    std::ofstream file(filename, std::ios::out | std::ios::binary);
+    file.write(reinterpret_cast<const char*>(deltas.data()), deltas.size());
+    file.close();
+    TOCK("change-feed")
+    if (file.fail()) {
+        std::cerr << "Error writing change feed " << filename << "\n";
+        return 1;
+    }
+    return 0;
+}
+
+} // namespace io
+} // namespace se
+
+#endif // SE_CHANGE_FEED_IMPL_HPP
@@ -185,6 +185,91 @@ int save_mesh_ply(const Mesh<FaceT>& mesh_M, const std::string& filename, const
 }
 
 
+template<typename FaceT>
+int save_mesh_ply_binary(const Mesh<FaceT>& mesh_M, const std::string& filename, const Eigen::Matrix4f& T_OM)
+{
+    // Open the file for writing.
+    std::ofstream file(filename.c_str(), std::ios::binary);
+    if (!file.is_open()) {
+        std::cerr << "Error writing mesh file " << filename << "\n";
+        return 1;
+    }
+
+    const size_t num_faces = mesh_M.size();
+    const size_t num_vertices = FaceT::num_vertexes * num_faces;
+
+    // Write header
+    file << "ply\n";
+    file << "format binary_little_endian 1.0\n";
+    file << "comment Mesh generated by supereight 2\n";
+    file << "element vertex " << num_vertices << "\n";
+    file << "property float x\n";
+    file << "property float y\n";
+    file << "property float z\n";
+    if constexpr (FaceT::colour) {
+        file << "property uchar red\n";
+        file << "property uchar green\n";
+        file << "property uchar blue\n";
+    }
+    file << "element face " << num_faces << "\n";
+    file << "property list uchar int vertex_index\n";
+    file << "property uchar red\n";
+    file << "property uchar green\n";
+    file << "property uchar blue\n";
+    if constexpr (FaceT::semantics) {
+        file << "property uchar class_id\n";
+    }
+    file << "end_header\n";
+
+    // Serialize into a buffer and write it at once, this is much faster than writing each value.
+    // The host is assumed to be little-endian.
+    constexpr size_t vertex_bytes = 3 * sizeof(float) + (FaceT::colour ? 3 : 0);
+    constexpr size_t face_bytes = 1 + FaceT::num_vertexes * sizeof(int32_t) + 3 + (FaceT::semantics ? 1 : 0);
+    std::vector<char> buffer(num_vertices * vertex_bytes + num_faces * face_bytes);
+    char* p = buffer.data();
+    const auto write = [&p](const auto& value) {
+        std::memcpy(p, &value, sizeof(value));
+        p += sizeof(value);
+    };
+
+    // Write the vertices.
+    for (const auto& face : mesh_M) {
+        for (size_t v = 0; v < FaceT::num_vertexes; ++v) {
+            const Eigen::Vector3f vertex_W = (T_OM * face.vertexes[v].homogeneous()).template head<3>();
+            write(vertex_W.x());
+            write(vertex_W.y());
+            write(vertex_W.z());
+            if constexpr (FaceT::colour) {
+                write(face.vertex_colours[v].r);
+                write(face.vertex_colours[v].g);
+                write(face.vertex_colours[v].b);
+            }
+        }
+    }
+
+    // Write the faces.
+    for (size_t f = 0; f < num_faces; ++f) {
+        write(static_cast<uint8_t>(FaceT::num_vertexes));
+        for (size_t v = 0; v < FaceT::num_vertexes; ++v) {
+            write(static_cast<int32_t>(FaceT::num_vertexes * f + v));
+        }
+        // Write the face scale colour.
+        const Eigen::Vector3f& rgb = se::colours::scale[mesh_M[f].max_vertex_scale];
+        write(static_cast<uint8_t>(rgb.x()));
+        write(static_cast<uint8_t>(rgb.y()));
+        write(static_cast<uint8_t>(rgb.z()));
+        // Write the face class ID.
+        if constexpr (FaceT::semantics) {
+            write(static_cast<uint8_t>(mesh_M[f].class_id));
+        }
+    }
+
+    file.write(buffer.data(), buffer.size());
+    file.close();
+    return file.fail() ? 1 : 0;
+}
+
+
 template<typename FaceT>
 int save_mesh_obj(const Mesh<FaceT>& mesh_M, const std::string& filename, const Eigen::Matrix4f& T_OM)
 {
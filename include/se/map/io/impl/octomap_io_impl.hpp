@@ -8,6 +8,8 @@
 #ifndef SE_MAP_IO_OCTOMAP_IO_IMPL_HPP
 #define SE_MAP_IO_OCTOMAP_IO_IMPL_HPP
 
+#include <algorithm>
+
 namespace se {
 
 template<typename MapT, typename FunctionT>
@@ -68,16 +70,112 @@ octomap::OcTree* to_octomap(const MapT& map, FunctionT convert_data)
 }
 
 
+template<typename MapT, typename FunctionT>
+octomap::OcTree* to_octomap_parallel(const MapT& map, FunctionT convert_value, const bool update)
+{
+    static_assert(MapT::DataType::fld_ == Field::Occupancy, "se::to_octomap_parallel() is only implemented for occupancy maps");
+    typedef typename MapT::OctreeType OctreeType;
+    typedef std::vector<std::pair<octomap::OcTreeKey, float>> KeyValueBatch;
+    const float voxel_centre_offset = map.getRes() / 2.0f;
+    octomap::OcTree* octomap = new octomap::OcTree(map.getRes());
+
+    std::vector<const OctantBase*> leaf_ptrs;
+    for (auto it = se::LeavesIterator(map.getOctree().get()); it != se::LeavesIterator<OctreeType>(); ++it) {
+        leaf_ptrs.push_back(*it);
+    }
+
+    // Only the batches of a chunk of leaves are kept in memory at a time.
+    constexpr size_t chunk_size = 1024;
+    std::vector<KeyValueBatch> batches(std::min(chunk_size, leaf_ptrs.size()));
+    for (size_t chunk_begin = 0; chunk_begin < leaf_ptrs.size(); chunk_begin += chunk_size) {
+        const size_t chunk_end = std::min(chunk_begin + chunk_size, leaf_ptrs.size());
+
+        // Computing the keys and values only reads the OctoMap so it can be done in parallel. The
+        // leaf nodes vary a lot in size so they're scheduled dynamically.
+#pragma omp parallel for schedule(dynamic)
+        for (size_t i = chunk_begin; i < chunk_end; i++) {
+            const OctantBase* octant = leaf_ptrs[i];
+            KeyValueBatch& batch = batches[i - chunk_begin];
+            batch.clear();
+            const auto add_voxel = [&](const Eigen::Vector3i& voxel_coord, const float value) {
+                Eigen::Vector3f point_W;
+                map.voxelToPoint(voxel_coord, point_W);
+                // The sample point is at the centre of voxels.
+                point_W += Eigen::Vector3f::Constant(voxel_centre_offset);
+                octomap::OcTreeKey key;
+                if (octomap->coordToKeyChecked(point_W.x(), point_W.y(), point_W.z(), key)) {
+                    batch.emplace_back(key, value);
+                }
+            };
+
+            if (octant->isBlock()) {
+                const auto& block = *static_cast<const typename OctreeType::BlockType*>(octant);
+                const int current_scale = block.getCurrentScale();
+                const Eigen::Vector3i block_coord = block.getCoord();
+                batch.reserve(OctreeType::BlockType::size_cu);
+                for (unsigned z = 0; z < OctreeType::block_size; z++) {
+                    for (unsigned y = 0; y < OctreeType::block_size; y++) {
+                        for (unsigned x = 0; x < OctreeType::block_size; x++) {
+                            const Eigen::Vector3i voxel_coord = block_coord + Eigen::Vector3i(x, y, z);
+                            const std::optional<float> value = convert_value(*octomap, block.getMaxData(voxel_coord, current_scale));
+                            if (value) {
+                                add_voxel(voxel_coord, *value);
+                            }
+                        }
+                    }
+                }
+            }
+            else {
+                // All voxels of a node have the same value, skip unknown nodes without iterating
+                // over their voxels.
+                const auto& node = *static_cast<const typename OctreeType::NodeType*>(octant);
+                const std::optional<float> value = convert_value(*octomap, node.getMaxData());
+                if (!value) {
+                    continue;
+                }
+                const Eigen::Vector3i node_coord = node.getCoord();
+                for (int z = 0; z < node.getSize(); z++) {
+                    for (int y = 0; y < node.getSize(); y++) {
+                        for (int x = 0; x < node.getSize(); x++) {
+                            add_voxel(node_coord + Eigen::Vector3i(x, y, z), *value);
+                        }
+                    }
+                }
+            }
+        }
+
+        // Inserting into the OctoMap isn't thread-safe. Inserting by key avoids converting the
+        // coordinates again and lazy evaluation defers updating the inner nodes to a single pass.
+        for (size_t i = 0; i < chunk_end - chunk_begin; i++) {
+            for (const auto& key_value : batches[i]) {
+                if (update) {
+                    octomap->updateNode(key_value.first, key_value.second, true);
+                }
+                else {
+                    octomap->setNodeValue(key_value.first, key_value.second, true);
+                }
+            }
+        }
+    }
+
+    // Make the octree consistent at all levels.
+    octomap->updateInnerOccupancy();
+    // Combine children with the same values.
+    octomap->prune();
+    return octomap;
+}
+
+
 template<typename MapT>
 octomap::OcTree* to_octomap(const MapT& map)
 {
-    return to_octomap(map, [](octomap::OcTree& octomap, const octomap::point3d& point_W, const typename MapT::DataType& data) -> void {
+    return to_octomap_parallel(map, [](const octomap::OcTree& /* octomap */, const typename MapT::DataType& data) -> std::optional<float> {
         // Do not store log-odds of 0 because OctoMap interprets it as occupied,
         // whereas in supereight it means unknown.
         if (is_valid(data)) {
-            const float occupancy = get_field(data) * data.weight;
-            octomap.setNodeValue(point_W, occupancy, true);
+            return get_field(data) * data.weight;
         }
+        return std::nullopt;
     });
 }
 
@@ -85,18 +183,19 @@ octomap::OcTree* to_octomap(const MapT& map)
 template<typename MapT>
 octomap::OcTree* to_binary_octomap(const MapT& map)
 {
-    return to_octomap(map, [](octomap::OcTree& octomap, const octomap::point3d& point_W, const typename MapT::DataType& data) -> void {
+    return to_octomap_parallel(map, [](const octomap::OcTree& octomap, const typename MapT::DataType& data) -> std::optional<float> {
         const float occupancy = get_field(data) * data.weight;
         if (occupancy > 0.0f) {
             // Occupied
-            octomap.updateNode(point_W, true, true);
+            return octomap.getProbHitLog();
         }
         else if (occupancy < 0.0f) {
             // Free
-            octomap.updateNode(point_W, false, true);
+            return octomap.getProbMissLog();
         }
         // Do not update unknown voxels.
-    });
+        return std::nullopt;
+    }, true);
 }
 
 } // namespace se
@@ -75,6 +75,152 @@ bool save_3d_slice_vtk(const std::string& filename, const Eigen::Vector3i& lower
 }
 
 
+namespace detail {
+
+/** Write a value in the big-endian byte order required by binary legacy VTK files.
+ */
+template<typename T>
+inline void write_big_endian(char*& p, const T value)
+{
+    static_assert(sizeof(T) == 4, "Only 4-byte values are supported");
+    uint32_t bytes;
+    std::memcpy(&bytes, &value, sizeof(bytes));
+    p[0] = bytes >> 24;
+    p[1] = bytes >> 16;
+    p[2] = bytes >> 8;
+    p[3] = bytes;
+    p += sizeof(bytes);
+}
+
+} // namespace detail
+
+
+template<typename OctreeT, typename GetValueF>
+bool save_slice_vtk_binary(const std::string& filename, const OctreeT& octree, const int axis, const int slice_coord, GetValueF get_value, const float fill_value)
+{
+    typedef typename OctreeT::NodeType NodeType;
+    typedef typename OctreeT::BlockType BlockType;
+    constexpr int block_size = BlockType::getSize();
+    const int octree_size = octree.getSize();
+    if (axis < 0 || axis > 2 || slice_coord < 0 || slice_coord >= octree_size) {
+        std::cerr << "Invalid slice " << slice_coord << " along axis " << axis << "\n";
+        return false;
+    }
+
+    // Open the file for writing.
+    std::ofstream file(filename.c_str(), std::ios::binary);
+    if (!file.is_open()) {
+        std::cerr << "Unable to write file " << filename << "\n";
+        return false;
+    }
+
+    Eigen::Vector3i lower_coord = Eigen::Vector3i::Zero();
+    lower_coord[axis] = slice_coord;
+    Eigen::Vector3i dims = Eigen::Vector3i::Constant(octree_size);
+    dims[axis] = 1;
+    const auto value_idx = [&](const Eigen::Vector3i& voxel_coord) {
+        const Eigen::Vector3i c = voxel_coord - lower_coord;
+        return c.x() + static_cast<size_t>(dims.x()) * (c.y() + static_cast<size_t>(dims.y()) * c.z());
+    };
+    std::vector<float> values(static_cast<size_t>(dims.x()) * dims.y() * dims.z(), fill_value);
+
+    // Find the blocks intersecting the slice plane, pruning the octree at every level.
+    std::vector<const BlockType*> block_ptrs;
+    std::vector<const OctantBase*> octant_stack = {octree.getRoot()};
+    while (!octant_stack.empty()) {
+        const NodeType* node_ptr = static_cast<const NodeType*>(octant_stack.back());
+        octant_stack.pop_back();
+        const int child_size = node_ptr->getSize() / 2;
+        for (int child_idx = 0; child_idx < 8; child_idx++) {
+            const Eigen::Vector3i child_coord = node_ptr->getChildCoord(child_idx);
+            if (slice_coord < child_coord[axis] || slice_coord >= child_coord[axis] + child_size) {
+                continue;
+            }
+            const OctantBase* child_ptr = node_ptr->getChild(child_idx);
+            if (child_ptr) {
+                if (child_ptr->isBlock()) {
+                    block_ptrs.push_back(static_cast<const BlockType*>(child_ptr));
+                }
+                else {
+                    octant_stack.push_back(child_ptr);
+                }
+                continue;
+            }
+            // Unallocated child, use the node data if it's been observed.
+            const auto& node_data = node_ptr->getData();
+            if (!is_valid(node_data)) {
+                continue;
+            }
+            const float node_value = get_value(node_data);
+            Eigen::Vector3i region_size = Eigen::Vector3i::Constant(child_size);
+            region_size[axis] = 1;
+            Eigen::Vector3i region_coord = child_coord;
+            region_coord[axis] = slice_coord;
+            for (int z = 0; z < region_size.z(); z++) {
+                for (int y = 0; y < region_size.y(); y++) {
+                    const size_t idx = value_idx(region_coord + Eigen::Vector3i(0, y, z));
+                    std::fill(values.begin() + idx, values.begin() + idx + region_size.x(), node_value);
+                }
+            }
+        }
+    }
+
+    // Extract the block voxels on the slice plane.
+    Eigen::Vector3i plane_size = Eigen::Vector3i::Constant(block_size);
+    plane_size[axis] = 1;
+#pragma omp parallel for
+    for (size_t i = 0; i < block_ptrs.size(); i++) {
+        const BlockType& block = *block_ptrs[i];
+        Eigen::Vector3i plane_coord = block.getCoord();
+        plane_coord[axis] = slice_coord;
+        for (int z = 0; z < plane_size.z(); z++) {
+            for (int y = 0; y < plane_size.y(); y++) {
+                for (int x = 0; x < plane_size.x(); x++) {
+                    const Eigen::Vector3i voxel_coord = plane_coord + Eigen::Vector3i(x, y, z);
+                    const auto& data = block.getData(voxel_coord);
+                    if (is_valid(data)) {
+                        values[value_idx(voxel_coord)] = get_value(data);
+                    }
+                }
+            }
+        }
+    }
+
+    file << "# vtk DataFile Version 3.0\n";
+    file << "Slice generated by supereight 2\n";
+    file << "BINARY\n";
+    file << "DATASET RECTILINEAR_GRID\n";
+    file << "DIMENSIONS " << dims.x() << " " << dims.y() << " " << dims.z() << "\n";
+
+    const char* axis_names[3] = {"X_COORDINATES", "Y_COORDINATES", "Z_COORDINATES"};
+    for (int a = 0; a < 3; a++) {
+        std::vector<char> buffer(4 * dims[a]);
+        char* p = buffer.data();
+        for (int i = 0; i < dims[a]; i++) {
+            detail::write_big_endian(p, static_cast<int32_t>(lower_coord[a] + i));
+        }
+        file << axis_names[a] << " " << dims[a] << " int\n";
+        file.write(buffer.data(), buffer.size());
+        file << "\n";
+    }
+
+    std::vector<char> buffer(4 * values.size());
+#pragma omp parallel for
+    for (size_t i = 0; i < values.size(); i++) {
+        char* p = buffer.data() + 4 * i;
+        detail::write_big_endian(p, values[i]);
+    }
+    file << "POINT_DATA " << values.size() << "\n";
+    file << "SCALARS scalars float 1\n";
+    file << "LOOKUP_TABLE default\n";
+    file.write(buffer.data(), buffer.size());
+    file << "\n";
+
+    file.close();
+    return !file.fail();
+}
+
+
 } // namespace io
 } // namespace se
 
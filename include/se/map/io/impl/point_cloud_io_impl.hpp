@@ -8,7 +8,7 @@
 #ifndef SE_POINT_CLOUD_IO_IMPL_HPP
 #define SE_POINT_CLOUD_IO_IMPL_HPP
 
-int save_point_cloud_vtk(se::Image<Eigen::Vector3f>& point_cloud, const std::string& filename, const Eigen::Matrix4f& T_WC)
+inline int save_point_cloud_vtk(se::Image<Eigen::Vector3f>& point_cloud, const std::string& filename, const Eigen::Matrix4f& T_WC)
 {
     // Open the file for writing.
     std::ofstream file(filename.c_str());
@@ -33,4 +33,69 @@ int save_point_cloud_vtk(se::Image<Eigen::Vector3f>& point_cloud, const std::str
     return 0;
 }
 
+
+namespace se {
+namespace io {
+
+inline int save_point_cloud_ply(const SurfacePointCloud& point_cloud, const std::string& filename, const Eigen::Matrix4f& T_OM)
+{
+    // Open the file for writing.
+    std::ofstream file(filename.c_str(), std::ios::binary);
+    if (!file.is_open()) {
+        std::cerr << "Unable to write file " << filename << "\n";
+        return 1;
+    }
+
+    const bool has_normals = point_cloud.normals.size() == point_cloud.size();
+    const bool has_colours = point_cloud.colours.size() == point_cloud.size();
+    file << "ply\n";
+    file << "format binary_little_endian 1.0\n";
+    file << "comment Point cloud generated by supereight 2\n";
+    file << "element vertex " << point_cloud.size() << "\n";
+    file << "property float x\n";
+    file << "property float y\n";
+    file << "property float z\n";
+    if (has_normals) {
+        file << "property float nx\n";
+        file << "property float ny\n";
+        file << "property float nz\n";
+    }
+    if (has_colours) {
+        file << "property uchar red\n";
+        file << "property uchar green\n";
+        file << "property uchar blue\n";
+    }
+    file << "end_header\n";
+
+    // Pack the points into a single buffer. The host is assumed to be little-endian.
+    const size_t point_bytes = 3 * sizeof(float) + (has_normals ? 3 * sizeof(float) : 0) + (has_colours ? 3 : 0);
+    std::vector<char> buffer(point_cloud.size() * point_bytes);
+    const Eigen::Matrix3f C_OM = T_OM.topLeftCorner<3, 3>();
+#pragma omp parallel for
+    for (size_t i = 0; i < point_cloud.size(); ++i) {
+        char* p = buffer.data() + i * point_bytes;
+        const Eigen::Vector3f point_O = (T_OM * point_cloud.points[i].homogeneous()).head<3>();
+        std::memcpy(p, point_O.data(), 3 * sizeof(float));
+        p += 3 * sizeof(float);
+        if (has_normals) {
+            const Eigen::Vector3f normal_O = C_OM * point_cloud.normals[i];
+            std::memcpy(p, normal_O.data(), 3 * sizeof(float));
+            p += 3 * sizeof(float);
+        }
+        if (has_colours) {
+            const rgb_t& colour = point_cloud.colours[i];
+            p[0] = colour.r;
+            p[1] = colour.g;
+            p[2] = colour.b;
+        }
+    }
+
+    file.write(buffer.data(), buffer.size());
+    file.close();
+    return file.fail() ? 1 : 0;
+}
+
+} // namespace io
+} // namespace se
+
 #endif // SE_POINT_CLOUD_IO_IMPL_HPP
@@ -0,0 +1,238 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Smart Robotics Lab, Technical University of Munich
+ * SPDX-FileCopyrightText: 2024 Jiaxin Wei
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef SE_TILED_MESH_IO_IMPL_HPP
+#define SE_TILED_MESH_IO_IMPL_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <numeric>
+
+namespace se {
+namespace io {
+
+template<typename MapT>
+TiledMeshWriter<MapT>::TiledMeshWriter(const std::string& directory, const int tile_blocks, const int num_lods) :
+        directory_(directory), tile_blocks_(std::max(tile_blocks, 1)), num_lods_(std::max(num_lods, 1)), num_written_tiles_(0)
+{
+}
+
+
+template<typename MapT>
+int TiledMeshWriter<MapT>::save(const MapT& map)
+{
+    TICK("tiled-mesh-export")
+    num_written_tiles_ = 0;
+    std::error_code ec;
+    stdfs::create_directories(directory_, ec);
+    if (ec) {
+        std::cerr << "Error creating tile directory " << directory_ << ": " << ec.message() << "\n";
+        TOCK("tiled-mesh-export")
+        return 1;
+    }
+
+    OctreeType& octree = *map.getOctree();
+    const int tile_size = tile_blocks_ * BlockType::getSize();
+
+    // Group the blocks into tiles and find the newest block of each tile.
+    std::map<TileKey, std::vector<BlockType*>> tile_blocks;
+    std::map<TileKey, timestamp_t> tile_timestamps;
+    for (auto block_ptr_itr = BlocksIterator<OctreeType>(&octree); block_ptr_itr != BlocksIterator<OctreeType>(); ++block_ptr_itr) {
+        BlockType* block_ptr = static_cast<BlockType*>(*block_ptr_itr);
+        const Eigen::Vector3i tile_coord = block_ptr->getCoord() / tile_size;
+        const TileKey key = {tile_coord.x(), tile_coord.y(), tile_coord.z()};
+        tile_blocks[key].push_back(block_ptr);
+        const auto [it, inserted] = tile_timestamps.emplace(key, block_ptr->getTimeStamp());
+        if (!inserted) {
+            it->second = std::max(it->second, block_ptr->getTimeStamp());
+        }
+    }
+
+    // The marching cubes at the positive borders of a tile read the voxels of the neighbouring
+    // tiles, so a tile is also dirty when one of its positive neighbours changed.
+    std::vector<TileKey> dirty_keys;
+    std::vector<timestamp_t> dirty_timestamps;
+    for (const auto& tile : tile_blocks) {
+        const TileKey& key = tile.first;
+        timestamp_t timestamp = tile_timestamps[key];
+        for (int i = 1; i < 8; i++) {
+            const TileKey neighbour_key = {key[0] + (i & 1), key[1] + ((i >> 1) & 1), key[2] + ((i >> 2) & 1)};
+            const auto it = tile_timestamps.find(neighbour_key);
+            if (it != tile_timestamps.end()) {
+                timestamp = std::max(timestamp, it->second);
+            }
+        }
+        const auto it = tiles_.find(key);
+        if (it == tiles_.end() || timestamp > it->second.timestamp) {
+            dirty_keys.push_back(key);
+            dirty_timestamps.push_back(timestamp);
+        }
+    }
+
+    // Mesh the dirty tiles one at a time, the marching cubes kernels are parallel over blocks.
+    std::vector<std::vector<MeshType>> tile_meshes(dirty_keys.size(), std::vector<MeshType>(num_lods_));
+    for (size_t i = 0; i < dirty_keys.size(); i++) {
+        std::vector<BlockType*>& block_ptrs = tile_blocks[dirty_keys[i]];
+        if constexpr (MapT::res_ == Res::Single) {
+            tile_meshes[i][0] = algorithms::marching_cube_kernel(octree, block_ptrs);
+        }
+        else {
+            tile_meshes[i][0] = algorithms::dual_marching_cube_kernel(octree, block_ptrs);
+        }
+    }
+
+    // Transform from the map frame in units of voxels to the world frame in units of metres.
+    Eigen::Matrix4f T_WM_scale = map.getTWM();
+    T_WM_scale.topLeftCorner<3, 3>() *= map.getRes();
+
+    // Decimate and write the tiles in parallel.
+    int num_errors = 0;
+#pragma omp parallel for schedule(dynamic) reduction(+ : num_errors)
+    for (size_t i = 0; i < dirty_keys.size(); i++) {
+        std::vector<MeshType>& lods = tile_meshes[i];
+        if (lods[0].empty()) {
+            continue;
+        }
+        if (num_lods_ > 1) {
+            // The whole tile is a single patch so only its border vertices are locked. Each LOD is
+            // produced by further decimating the previous one.
+            std::vector<size_t> face_idxs(lods[0].size());
+            std::iota(face_idxs.begin(), face_idxs.end(), 0);
+            meshing::DecimationPatch<typename OctreeType::TriangleType> patch(lods[0], face_idxs, 1e-4f * tile_size);
+            const size_t num_faces = patch.numFaces();
+            for (int lod = 1; lod < num_lods_; lod++) {
+                const float max_error = lodError(lod, map.getRes()) / map.getRes();
+                patch.decimate(std::ceil(num_faces / std::pow(4.0f, lod)), max_error * max_error);
+                patch.append(lods[lod]);
+            }
+        }
+        const std::string name = tileName(dirty_keys[i]);
+        for (int lod = 0; lod < num_lods_; lod++) {
+            num_errors += save_mesh_ply_binary(lods[lod], directory_ + "/" + name + "_lod" + std::to_string(lod) + ".ply", T_WM_scale);
+        }
+    }
+
+    for (size_t i = 0; i < dirty_keys.size(); i++) {
+        Tile& tile = tiles_[dirty_keys[i]];
+        tile.timestamp = dirty_timestamps[i];
+        tile.num_faces.resize(num_lods_);
+        for (int lod = 0; lod < num_lods_; lod++) {
+            tile.num_faces[lod] = tile_meshes[i][lod].size();
+        }
+        if (!tile_meshes[i][0].empty()) {
+            num_written_tiles_++;
+        }
+    }
+    num_errors += saveIndex(map);
+    TOCK("tiled-mesh-export")
+    return num_errors;
+}
+
+
+template<typename MapT>
+std::string TiledMeshWriter<MapT>::tileName(const TileKey& key) const
+{
+    return "tile_" + std::to_string(key[0]) + "_" + std::to_string(key[1]) + "_" + std::to_string(key[2]);
+}
+
+
+template<typename MapT>
+int TiledMeshWriter<MapT>::saveIndex(const MapT& map) const
+{
+    const int tile_size = tile_blocks_ * BlockType::getSize();
+    const auto write_bounds = [](std::ostream& os, const Eigen::AlignedBox3f& bounds) {
+        if (bounds.isEmpty()) {
+            os << "null";
+            return;
+        }
+        os << "{\"min\": [" << bounds.min().x() << ", " << bounds.min().y() << ", " << bounds.min().z() << "], ";
+        os << "\"max\": [" << bounds.max().x() << ", " << bounds.max().y() << ", " << bounds.max().z() << "]}";
+    };
+
+    // Write to a temporary file and rename it so that viewers never read a partially written index.
+    const std::string filename = directory_ + "/tiles.json";
+    const std::string tmp_filename = filename + ".tmp";
+    std::ofstream file(tmp_filename);
+    if (!file.is_open()) {
+        std::cerr << "Error writing tile index " << tmp_filename << "\n";
+        return 1;
+    }
+
+    std::vector<TileKey> keys;
+    std::vector<Eigen::AlignedBox3f> tile_bounds_W;
+    Eigen::AlignedBox3f root_bounds_W;
+    for (const auto& [key, tile] : tiles_) {
+        if (tile.num_faces.empty() || tile.num_faces[0] == 0) {
+            continue;
+        }
+        const Eigen::Vector3f tile_min_M = Eigen::Vector3f(key[0], key[1], key[2]) * tile_size * map.getRes();
+        const Eigen::AlignedBox3f tile_bounds_M(tile_min_M, tile_min_M + Eigen::Vector3f::Constant(tile_size * map.getRes()));
+        Eigen::AlignedBox3f tile_bounds;
+        for (int c = 0; c < 8; c++) {
+            const Eigen::Vector3f corner_M = tile_bounds_M.corner(static_cast<Eigen::AlignedBox3f::CornerType>(c));
+            tile_bounds.extend((map.getTWM() * corner_M.homogeneous()).template head<3>());
+        }
+        keys.push_back(key);
+        tile_bounds_W.push_back(tile_bounds);
+        root_bounds_W.extend(tile_bounds);
+    }
+
+    file << "{\n";
+    file << "  \"resolution\": " << map.getRes() << ",\n";
+    file << "  \"tile_size\": " << tile_size * map.getRes() << ",\n";
+    file << "  \"num_lods\": " << num_lods_ << ",\n";
+    file << "  \"root\": {\n";
+    file << "    \"bounds\": ";
+    write_bounds(file, root_bounds_W);
+    file << ",\n";
+    file << "    \"children\": [";
+    for (size_t i = 0; i < keys.size(); i++) {
+        file << (i == 0 ? "" : ", ") << "\"" << tileName(keys[i]) << "\"";
+    }
+    file << "]\n";
+    file << "  },\n";
+    file << "  \"tiles\": [";
+    for (size_t i = 0; i < keys.size(); i++) {
+        const Tile& tile = tiles_.at(keys[i]);
+        const std::string name = tileName(keys[i]);
+        file << (i == 0 ? "\n" : ",\n");
+        file << "    {\n";
+        file << "      \"id\": \"" << name << "\",\n";
+        file << "      \"bounds\": ";
+        write_bounds(file, tile_bounds_W[i]);
+        file << ",\n";
+        file << "      \"timestamp\": " << tile.timestamp << ",\n";
+        file << "      \"lods\": [";
+        for (int lod = 0; lod < num_lods_; lod++) {
+            file << (lod == 0 ? "\n" : ",\n");
+            file << "        {\"lod\": " << lod << ", \"error\": " << lodError(lod, map.getRes()) << ", \"faces\": " << tile.num_faces[lod]
+                 << ", \"file\": \"" << name << "_lod" << lod << ".ply\"}";
+        }
+        file << "\n      ]\n";
+        file << "    }";
+    }
+    file << "\n  ]\n";
+    file << "}\n";
+    file.close();
+    if (file.fail()) {
+        std::cerr << "Error writing tile index " << tmp_filename << "\n";
+        return 1;
+    }
+
+    std::error_code ec;
+    stdfs::rename(tmp_filename, filename, ec);
+    if (ec) {
+        std::cerr << "Error writing tile index " << filename << ": " << ec.message() << "\n";
+        return 1;
+    }
+    return 0;
+}
+
+} // namespace io
+} // namespace se
+
+#endif // SE_TILED_MESH_IO_IMPL_HPP
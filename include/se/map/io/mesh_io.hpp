@@ -11,8 +11,10 @@
 
 #include <algorithm>
 #include <array>
+#include <cstring>
 #include <fstream>
 #include <iostream>
+#include <vector>
 
 #include "se/common/colour_utils.hpp"
 #include "se/common/str_utils.hpp"
@@ -71,6 +73,17 @@ int save_mesh_vtk(const Mesh<FaceT>& mesh_M, const std::string& filename, const
 template<typename FaceT>
 int save_mesh_ply(const Mesh<FaceT>& mesh_M, const std::string& filename, const Eigen::Matrix4f& T_OM = Eigen::Matrix4f::Identity());
 
+/** \brief Save a mesh as a binary little-endian PLY file with the same elements and properties as
+ * se::io::save_mesh_ply(). Binary files are several times smaller and faster to write and load.
+ * \param[in] mesh_M   The mesh to be saved expressed in some mesh frame M.
+ * \param[in] filename The file where the mesh will be saved.
+ * \param[in] T_OM     The transformation from the mesh frame M to some output frame O. The
+ *                     transformation will be applied to each mesh vertex before saving it.
+ * \return Zero on success, non-zero on error.
+ */
+template<typename FaceT>
+int save_mesh_ply_binary(const Mesh<FaceT>& mesh_M, const std::string& filename, const Eigen::Matrix4f& T_OM = Eigen::Matrix4f::Identity());
+
 /** \brief Save a mesh as an Wavefront OBJ file.
  * The Wavefront OBJ file format is documented here:
  * http://fegemo.github.io/cefet-cg/attachments/obj-spec.pdf
@@ -10,6 +10,9 @@
 #ifdef SE_OCTOMAP
 
 #    include <octomap/octomap.h>
+#    include <optional>
+#    include <utility>
+#    include <vector>
 
 #    include "se/map/map.hpp"
 
@@ -45,6 +48,35 @@ template<typename MapT, typename FunctionT>
 octomap::OcTree* to_octomap(const MapT& map, FunctionT convert_data);
 
 
+/** Convert an se::Map to an OctoMap octomap::OcTree, computing the OctoMap data of the se::Map
+ * leaves in parallel.
+ *
+ * Unlike to_octomap(), the function argument doesn't modify the OctoMap but returns the log-odds
+ * value a point should be set to. Its signature must be
+ * ```
+ * [](const octomap::OcTree& octomap, const typename MapT::DataType& data) -> std::optional<float>
+ * ```
+ * where `octomap` is the OctoMap format octree being created, only to be used for querying its
+ * parameters, and `data` the data stored in the se::Map for a point. Points for which
+ * `std::nullopt` is returned are not stored in the OctoMap. The value replaces the log-odds of the
+ * OctoMap node like `octomap.setNodeValue()`, or is added to it like `octomap.updateNode()` if
+ * update is true.
+ *
+ * The leaves are processed in chunks. The OctoMap keys and values of each leaf of a chunk are
+ * computed in parallel and then inserted serially without updating the inner nodes, since OctoMap
+ * insertion isn't thread-safe. The inner nodes are updated and pruned once at the end.
+ *
+ * \param[in] map           The map to convert.
+ * \param[in] convert_value The function used to convert the map data.
+ * \param[in] update        Add the values to the log-odds of the OctoMap nodes instead of
+ *                          replacing them.
+ * \return A pointer to an OctoMap, allocated by `new`. Wrap it in a smart pointer or manually
+ *         deallocate the memory with `delete` after use.
+ */
+template<typename MapT, typename FunctionT>
+octomap::OcTree* to_octomap_parallel(const MapT& map, FunctionT convert_value, const bool update = false);
+
+
 /** Convert an se::Map to an OctoMap. The log-odds occupancy probability of the se::Map is saved
  * directly in the OctoMap.
  *
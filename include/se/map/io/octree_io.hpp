@@ -9,9 +9,12 @@
 #ifndef SE_OCTREE_IO_HPP
 #define SE_OCTREE_IO_HPP
 
+#include <cstdint>
+#include <cstring>
 #include <fstream>
 #include <iostream>
 #include <sstream>
+#include <vector>
 
 #include "se/map/octree/octree.hpp"
 
@@ -33,6 +36,27 @@ namespace io {
 template<typename GetValueF>
 bool save_3d_slice_vtk(const std::string& filename, const Eigen::Vector3i& lower_coord, const Eigen::Vector3i& upper_coord, GetValueF& get_value);
 
+/**
+ * \brief Save a slice of the octree perpendicular to an axis as a binary VTK rectilinear grid.
+ *
+ * Only the octants intersecting the slice plane are visited. The voxels of the intersecting blocks
+ * are extracted in parallel into a dense buffer which is written at once. Unobserved voxels and
+ * unallocated space are set to fill_value, except for unallocated space inside nodes holding
+ * observed data (e.g. in multi-res occupancy octrees), which is set to the value of the node data.
+ *
+ * \param filename      The file name to save the slice to
+ * \param octree        The octree to extract the slice from
+ * \param axis          The axis the slice is perpendicular to, 0, 1 or 2 for x, y or z
+ * \param slice_coord   The voxel coordinate of the slice along axis
+ * \param get_value     The function (float get_value(const DataType&)) extracting the value from
+ *                      observed data
+ * \param fill_value    The value of unobserved voxels and unallocated space
+ *
+ * \return True if the file can be written, false otherwise
+ */
+template<typename OctreeT, typename GetValueF>
+bool save_slice_vtk_binary(const std::string& filename, const OctreeT& octree, const int axis, const int slice_coord, GetValueF get_value, const float fill_value);
+
 } // namespace io
 } // namespace se
 
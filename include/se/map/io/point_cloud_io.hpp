@@ -8,10 +8,13 @@
 #ifndef SE_POINT_CLOUD_IO_HPP
 #define SE_POINT_CLOUD_IO_HPP
 
+#include <cstring>
 #include <fstream>
 #include <string>
+#include <vector>
 
 #include "se/image/image.hpp"
+#include "se/map/algorithms/surface_points.hpp"
 
 /**
  * \brief Save a point cloud as a VTK file.
@@ -25,7 +28,26 @@
  *
  * \return 0 on success, nonzero on error.
  */
-int save_point_cloud_vtk(se::Image<Eigen::Vector3f>& point_cloud, const std::string& filename, const Eigen::Matrix4f& T_WC);
+inline int save_point_cloud_vtk(se::Image<Eigen::Vector3f>& point_cloud, const std::string& filename, const Eigen::Matrix4f& T_WC);
+
+
+namespace se {
+namespace io {
+
+/**
+ * \brief Save surface points as a binary little-endian PLY file with vertex normals and, if
+ * available, vertex colours.
+ *
+ * \param[in] point_cloud The surface points expressed in some frame M.
+ * \param[in] filename    The name of the PLY file to create.
+ * \param[in] T_OM        The transformation from the frame M to the output frame O.
+ *
+ * \return 0 on success, nonzero on error.
+ */
+inline int save_point_cloud_ply(const SurfacePointCloud& point_cloud, const std::string& filename, const Eigen::Matrix4f& T_OM = Eigen::Matrix4f::Identity());
+
+} // namespace io
+} // namespace se
 
 
 #include "impl/point_cloud_io_impl.hpp"
@@ -0,0 +1,103 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Smart Robotics Lab, Technical University of Munich
+ * SPDX-FileCopyrightText: 2024 Jiaxin Wei
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef SE_TILED_MESH_IO_HPP
+#define SE_TILED_MESH_IO_HPP
+
+#include <array>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "se/common/filesystem.hpp"
+#include "se/map/algorithms/marching_cube.hpp"
+#include "se/map/algorithms/mesh_decimation.hpp"
+#include "se/map/io/mesh_io.hpp"
+
+
+namespace se {
+namespace io {
+
+/**
+ * \brief Export the mesh of a map as fixed-size spatial tiles at several levels of detail (LODs)
+ * for streaming viewers.
+ *
+ * Each tile contains tile_blocks^3 blocks and each LOD of a tile is written to a separate binary PLY
+ * file named `tile_X_Y_Z_lodL.ply`. LOD 0 is the marching cubes mesh and every coarser LOD is
+ * decimated to about a quarter of the faces of the previous one with a maximum error of
+ * `resolution * 2^(L - 1)` metres. The tile borders are kept in place at all LODs so neighbouring
+ * tiles at different LODs don't have cracks between them. Since no border vertex is removed, a tile
+ * can't be decimated below about one face per border vertex and the coarsest LODs of small tiles
+ * stop shrinking by a quarter per level. Use larger tiles when many LODs are needed.
+ *
+ * A JSON index `tiles.json` lists the bounds, files, face counts and error bound of each LOD of the
+ * non-empty tiles. The writer remembers the block time stamps each tile was written at, so calling
+ * save() again only remeshes and rewrites the tiles that changed since.
+ */
+template<typename MapT>
+class TiledMeshWriter {
+    public:
+    typedef typename MapT::OctreeType OctreeType;
+    typedef typename OctreeType::BlockType BlockType;
+    typedef typename OctreeType::MeshType MeshType;
+
+    /**
+     * \param[in] directory   The directory where the tiles and index are written.
+     * \param[in] tile_blocks The number of blocks along each side of a tile.
+     * \param[in] num_lods    The number of LODs written for each tile, including LOD 0.
+     */
+    TiledMeshWriter(const std::string& directory, const int tile_blocks = 8, const int num_lods = 3);
+
+    /**
+     * \brief Write the tiles of map that changed since the last call and update the index.
+     *
+     * \return Zero on success, non-zero on error.
+     */
+    int save(const MapT& map);
+
+    /**
+     * \brief Return the number of tiles written by the last call to save().
+     */
+    size_t numWrittenTiles() const
+    {
+        return num_written_tiles_;
+    }
+
+    /**
+     * \brief Return the error bound of the provided LOD in metres.
+     */
+    static float lodError(const int lod, const float resolution)
+    {
+        return lod == 0 ? 0.0f : resolution * (1 << (lod - 1));
+    }
+
+    private:
+    typedef std::array<int, 3> TileKey;
+
+    struct Tile {
+        /** The newest block time stamp the tile was written for. */
+        timestamp_t timestamp = -1;
+        /** The number of faces of each LOD. */
+        std::vector<size_t> num_faces;
+    };
+
+    std::string tileName(const TileKey& key) const;
+
+    int saveIndex(const MapT& map) const;
+
+    const std::string directory_;
+    const int tile_blocks_;
+    const int num_lods_;
+    std::map<TileKey, Tile> tiles_;
+    size_t num_written_tiles_;
+};
+
+} // namespace io
+} // namespace se
+
+#include "impl/tiled_mesh_io_impl.hpp"
+
+#endif // SE_TILED_MESH_IO_HPP
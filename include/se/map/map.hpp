@@ -10,15 +10,20 @@
 #define SE_MAP_HPP
 
 #include <Eigen/StdVector>
+#include <array>
+#include <limits>
 #include <optional>
 
 #include "se/common/math_util.hpp"
 #include "se/common/str_utils.hpp"
 #include "se/map/algorithms/marching_cube.hpp"
+#include "se/map/algorithms/mesh_decimation.hpp"
+#include "se/map/algorithms/surface_points.hpp"
 #include "se/map/algorithms/structure_meshing.hpp"
 #include "se/map/data.hpp"
 #include "se/map/io/mesh_io.hpp"
 #include "se/map/io/octree_io.hpp"
+#include "se/map/io/point_cloud_io.hpp"
 #include "se/map/octree/visitor.hpp"
 #include "se/map/raycaster.hpp"
 #include "se/map/utils/octant_util.hpp"
@@ -39,6 +44,46 @@ struct MapConfig {
      */
     Eigen::Matrix4f T_MW = math::to_transformation((dim / 2).eval());
 
+    /** Start a new submap every submap_frames frames. Set to 0 to disable.
+     */
+    int submap_frames = 0;
+
+    /** Start a new submap once the sensor has moved submap_distance metres away from where the
+     * active submap was started. Set to 0 to disable.
+     */
+    float submap_distance = 0.0f;
+
+    /** Whether submap mode is enabled, see se::SubmapCollection.
+     */
+    bool useSubmaps() const
+    {
+        return submap_frames > 0 || submap_distance > 0.0f;
+    }
+
+    /** The fraction of triangles to keep when decimating meshes, see se::algorithms::decimate_mesh().
+     * Set to 1 to disable mesh decimation.
+     */
+    float mesh_decimation_ratio = 1.0f;
+
+    /** The maximum distance in metres the decimated mesh may deviate from the marching cubes mesh.
+     * Set to 0 to decimate only according to mesh_decimation_ratio.
+     */
+    float mesh_decimation_error = 0.0f;
+
+    /** The radius in metres around the sensor of the active region. Only blocks whose centre is
+     * inside it are fetched and allocated for integration, see se::ActiveWindow. Set to 0 to
+     * integrate the whole frustum.
+     */
+    float active_radius = 0.0f;
+
+    /** Keep a compressed copy of the blocks leaving the active region and restore them when they
+     * re-enter it. When false the blocks leaving the active region are discarded and integrated
+     * again from scratch if they re-enter it, without seeding Gaussians, see se::ActiveWindow.
+     * Either way only the per-frame cost and the octree are bounded, the compressed blocks or the
+     * keys of the discarded blocks grow with the explored volume.
+     */
+    bool compress_inactive = true;
+
     /** Reads the struct members from the "map" node of a YAML file. Members not present in the YAML
      * file aren't modified.
      */
@@ -169,6 +214,17 @@ class Map<se::Data<FldT, ColB, SemB>, ResT, BlockSize> {
         return resolution_;
     }
 
+    /**
+     * \brief Get the radius in metres of the active region around the sensor, see
+     * MapConfig::active_radius.
+     *
+     * \return The radius of the active region, infinity if it's disabled
+     */
+    float getActiveRadius() const
+    {
+        return active_radius_;
+    }
+
     /**
      * \brief Get the data configuration of the map.
      *
@@ -298,9 +354,15 @@ class Map<se::Data<FldT, ColB, SemB>, ResT, BlockSize> {
      * \param[in] point_W    The point in the world frame in units of meters where the slices
      *                       intersect. The x coordinate denotes the position along the x axis that
      *                       the slice perpendicular to the x axis will be computed etc.
+     * \param[in] fill_value The value written for unobserved voxels and unallocated space. Defaults
+     *                       to the field value of default-initialized data.
      * \return Zero on success and non-zero on error.
      */
-    int saveFieldSlices(const std::string& filename_x, const std::string& filename_y, const std::string& filename_z, const Eigen::Vector3f& point_W) const;
+    int saveFieldSlices(const std::string& filename_x,
+                        const std::string& filename_y,
+                        const std::string& filename_z,
+                        const Eigen::Vector3f& point_W,
+                        const std::optional<float> fill_value = std::nullopt) const;
 
     /**
      * \brief Save three slices of the maximum field value, each perpendicular to one of the axes
@@ -363,7 +425,8 @@ class Map<se::Data<FldT, ColB, SemB>, ResT, BlockSize> {
     typename OctreeType::MeshType mesh(const Eigen::Matrix4f& T_OW = Eigen::Matrix4f::Identity()) const;
 
     /**
-     * \brief Create a mesh in the map frame in units of voxels.
+     * \brief Create a mesh in the map frame in units of voxels. The mesh is decimated if
+     * MapConfig::mesh_decimation_ratio is smaller than 1.
      *
      * \return The created mesh.
      */
@@ -390,6 +453,31 @@ class Map<se::Data<FldT, ColB, SemB>, ResT, BlockSize> {
      */
     int saveMeshVoxel(const std::string& filename) const;
 
+    /**
+     * \brief Extract the TSDF zero crossings as points with normals and colours in the world frame
+     * in units of metres, see se::algorithms::surface_points(). Much cheaper than meshing when only
+     * the surface points are needed.
+     *
+     * \param[in] T_OW Transformation from the world frame in units of metres to the output frame.
+     *                 Defaults to identity.
+     * \return The surface points.
+     */
+    template<Field FldTDummy = FldT, Res ResTDummy = ResT>
+    typename std::enable_if_t<FldTDummy == Field::TSDF && ResTDummy == Res::Single, SurfacePointCloud>
+    surfacePoints(const Eigen::Matrix4f& T_OW = Eigen::Matrix4f::Identity()) const;
+
+    /**
+     * \brief Extract the TSDF zero crossings and save them as a binary PLY file.
+     *
+     * \param[in] filename The PLY file where the points will be saved.
+     * \param[in] T_OW     Transformation from the world frame in units of metres to the output
+     *                     frame. Defaults to identity.
+     * \return Zero on success and non-zero on error.
+     */
+    template<Field FldTDummy = FldT, Res ResTDummy = ResT>
+    typename std::enable_if_t<FldTDummy == Field::TSDF && ResTDummy == Res::Single, int>
+    saveSurfacePoints(const std::string& filename, const Eigen::Matrix4f& T_OW = Eigen::Matrix4f::Identity()) const;
+
     /**
      * \brief Convert voxel coordinates in [voxel] to its centre point coordinates in [meter].
      *
@@ -552,6 +640,10 @@ class Map<se::Data<FldT, ColB, SemB>, ResT, BlockSize> {
 
     const DataConfigType data_config_; ///< The configuration of the data
 
+    const float mesh_decimation_ratio_; ///< The fraction of mesh triangles to keep
+    const float mesh_decimation_error_; ///< The maximum mesh decimation error in metres
+    const float active_radius_;         ///< The radius of the active region in metres
+
     /** The eight relative unit corner offsets */
     static const Eigen::Matrix<float, 3, 8> corner_rel_steps_;
 };
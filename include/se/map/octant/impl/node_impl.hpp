@@ -68,7 +68,12 @@ const OctantBase* Node<DataT, ResT>::getChild(const int child_idx) const
 template<typename DataT, Res ResT>
 OctantBase* Node<DataT, ResT>::setChild(const int child_idx, OctantBase* child_ptr)
 {
-    children_mask_ |= 1 << child_idx;
+    if (child_ptr) {
+        children_mask_ |= 1 << child_idx;
+    }
+    else {
+        children_mask_ &= ~(1u << child_idx);
+    }
     std::swap(child_ptr, children_ptr_[child_idx]);
     return child_ptr;
 }
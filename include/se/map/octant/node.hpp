@@ -212,10 +212,13 @@ class Node : public OctantBase, public std::conditional<ResT == Res::Single, Nod
     OctantBase* getChild(const int child_idx);
 
     /**
-     * \brief Set the pointer of one of the children of the node.
+     * \brief Set the pointer of one of the children of the node. Setting it to nullptr clears the
+     * child from the children mask.
      *
      * \param[in] child_idx   The child index of the child to be set
      * \param[in] child_ptr   The pointer to the child to be set
+     *
+     * \return The previous pointer to the child
      */
     OctantBase* setChild(const int child_idx, OctantBase* child_ptr);
 
@@ -150,6 +150,31 @@ void Octree<DataT, ResT, BlockSize>::deleteChildren(NodeType* parent_ptr)
 }
 
 
+template<typename DataT, Res ResT, int BlockSize>
+void Octree<DataT, ResT, BlockSize>::deleteBlock(BlockType* block_ptr)
+{
+    assert(block_ptr);
+    OctantBase* child_ptr = block_ptr;
+    while (child_ptr != root_ptr_) {
+        NodeType* parent_ptr = static_cast<NodeType*>(child_ptr->getParent());
+        assert(parent_ptr);
+        const int child_size = parent_ptr->getSize() / 2;
+        const Eigen::Vector3i child_offset = (child_ptr->getCoord() - parent_ptr->getCoord()) / child_size;
+        parent_ptr->setChild(child_offset.x() + 2 * child_offset.y() + 4 * child_offset.z(), nullptr);
+        if (child_ptr->isBlock()) {
+            memory_pool_.deleteBlock(static_cast<BlockType*>(child_ptr));
+        }
+        else {
+            memory_pool_.deleteNode(static_cast<NodeType*>(child_ptr));
+        }
+        if (!parent_ptr->isLeaf()) {
+            break;
+        }
+        child_ptr = parent_ptr;
+    }
+}
+
+
 template<typename DataT, Res ResT, int BlockSize>
 const Eigen::AlignedBox3i& Octree<DataT, ResT, BlockSize>::aabb() const
 {
@@ -146,7 +146,7 @@ void propagateToRoot(std::vector<se::OctantBase*>& octant_ptrs, PropagateF& prop
         }
     } // block_ptrs
 
-    while (!parent_ptrs.empty()) {
+    while (!child_ptrs.empty()) {
         std::unordered_set<se::OctantBase*>::iterator child_ptr_itr;
 
         for (child_ptr_itr = child_ptrs.begin(); child_ptr_itr != child_ptrs.end(); ++child_ptr_itr) {
@@ -8,6 +8,7 @@
 #ifndef SE_ITERATOR_HPP
 #define SE_ITERATOR_HPP
 
+#include <limits>
 #include <stack>
 
 #include "octree.hpp"
@@ -220,10 +221,14 @@ class FrustumIterator : public BaseIterator<FrustumIterator<MapT, SensorT>> {
     typedef typename MapT::OctreeType::BlockType BlockType;
 
 
-    FrustumIterator() : BaseIterator<FrustumIterator<MapT, SensorT>>(){};
+    FrustumIterator() : BaseIterator<FrustumIterator<MapT, SensorT>>(), max_distance_(0.0f){};
 
-    FrustumIterator(MapT& map, const SensorT& sensor, const Eigen::Matrix4f& T_SM) :
-            BaseIterator<FrustumIterator<MapT, SensorT>>(map.getOctree().get()), map_ptr_(&map), sensor_ptr_(&sensor), T_SM_(T_SM)
+    /** Iterate over the blocks in the frustum of \p sensor. When \p max_distance is finite, only
+     * the blocks whose centre is at most \p max_distance metres from the sensor are visited and
+     * the subtrees farther away are skipped.
+     */
+    FrustumIterator(MapT& map, const SensorT& sensor, const Eigen::Matrix4f& T_SM, const float max_distance = std::numeric_limits<float>::infinity()) :
+            BaseIterator<FrustumIterator<MapT, SensorT>>(map.getOctree().get()), map_ptr_(&map), sensor_ptr_(&sensor), T_SM_(T_SM), max_distance_(max_distance)
     {
         this->init();
     }
@@ -245,6 +250,10 @@ class FrustumIterator : public BaseIterator<FrustumIterator<MapT, SensorT>> {
         const Eigen::Vector3f octant_centre_point_S = (T_SM_ * octant_centre_point_M.homogeneous()).template head<3>();
 
         float octant_radius = std::sqrt(3.0f) / 2.0f * map_ptr_->getRes() * octant_size;
+        // Nodes are kept while any of their blocks may have its centre within max_distance_.
+        if (octant_centre_point_S.norm() > max_distance_ + (octant_ptr->isBlock() ? 0.0f : octant_radius)) {
+            return true;
+        }
         bool do_ignore = !sensor_ptr_->sphereInFrustum(octant_centre_point_S, octant_radius);
         return do_ignore;
     }
@@ -254,6 +263,7 @@ class FrustumIterator : public BaseIterator<FrustumIterator<MapT, SensorT>> {
     MapT* map_ptr_;
     const SensorT* sensor_ptr_;
     const Eigen::Matrix4f T_SM_; // TODO: Needs to be ref?
+    const float max_distance_;
 
     friend class BaseIterator<FrustumIterator<MapT, SensorT>>;
 };
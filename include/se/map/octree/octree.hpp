@@ -110,6 +110,20 @@ class Octree {
         return math::log2_const(size_) - math::log2_const(BlockSize);
     }
 
+    /** Get the number of bytes used by the allocated nodes.
+     */
+    size_t getNodeBytes() const
+    {
+        return memory_pool_.nodeBytes();
+    }
+
+    /** Get the number of bytes used by the allocated blocks.
+     */
+    size_t getBlockBytes() const
+    {
+        return memory_pool_.blockBytes();
+    }
+
     /** Allocate a child of a node.
      *
      * \note The returned pointer is of type se::OctantBase as the child might be a node or block.
@@ -133,6 +147,11 @@ class Octree {
      */
     void deleteChildren(NodeType* parent_ptr);
 
+    /** Delete the block \p block_ptr and the ancestor nodes, except the root, that are left
+     * without children. The AABB returned by se::Octree::aabb() isn't shrunk.
+     */
+    void deleteBlock(BlockType* block_ptr);
+
     /** Return the axis-aligned bounding box of the octree's allocated leaves. The bounding box
      * contains the whole allocated volume, not just the voxel origins thus the coordinates of its
      * vertices can be in the interval [0, size_] inclusive.
@@ -30,6 +30,39 @@ void point_cloud_to_normal(se::Image<Eigen::Vector3f>& out, const se::Image<Eige
 
 void half_sample_robust_image(se::Image<float>& out, const se::Image<float>& in, const float e_d, const int r);
 
+/** Downsample a colour image by averaging each block of \p factor x \p factor pixels. The output
+ * is resized to the input dimensions divided by \p factor if needed.
+ */
+void downsample_image(se::Image<se::rgb_t>& out, const se::Image<se::rgb_t>& in, const int factor);
+
+/** Invalidate flying pixels and isolated noise in place by setting them to 0. A neighbour is
+ * consistent with a pixel if their depths differ by at most \p max_relative_jump times the pixel
+ * depth. Pixels with fewer than \p min_support consistent neighbours among their 8 neighbours are
+ * invalidated. Pixels on either side of a real depth discontinuity keep the support of their own
+ * surface, while pixels interpolated between the two surfaces have none. Border pixels are left
+ * unchanged.
+ *
+ * \param[in,out] depth_image       The depth image to filter.
+ * \param[out]    scratch_image     A copy of the unfiltered image, reused between calls to avoid
+ *                                  allocations.
+ * \param[in]     max_relative_jump The maximum relative depth difference of consistent pixels.
+ * \param[in]     min_support       The minimum number of consistent neighbours of valid pixels.
+ * \return The number of pixels invalidated.
+ */
+size_t remove_flying_pixels(se::Image<float>& depth_image, se::Image<float>& scratch_image, const float max_relative_jump, const int min_support = 3);
+
+/** Smooth the depth image in place with a 3x3 bilateral filter with box spatial and range kernels,
+ * i.e. each valid pixel is replaced by the mean of the neighbours consistent with it as defined in
+ * remove_flying_pixels(). Depth discontinuities are preserved and invalid pixels stay invalid.
+ * Border pixels are left unchanged.
+ *
+ * \param[in,out] depth_image       The depth image to filter.
+ * \param[out]    scratch_image     A copy of the unfiltered image, reused between calls to avoid
+ *                                  allocations.
+ * \param[in]     max_relative_jump The maximum relative depth difference of consistent pixels.
+ */
+void bilateral_filter(se::Image<float>& depth_image, se::Image<float>& scratch_image, const float max_relative_jump);
+
 } // namespace preprocessor
 } // namespace se
 
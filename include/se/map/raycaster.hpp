@@ -11,13 +11,26 @@
 
 #define SE_INVALID -2
 
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
 #include <optional>
+#include <stdexcept>
+#include <vector>
 
 #include "se/common/colour_utils.hpp"
+#include "se/common/image_utils.hpp"
+#include "se/common/perfstats.hpp"
+#include "se/common/projection.hpp"
 #include "se/image/image.hpp"
 #include "se/map/octree/visitor.hpp"
 #include "se/map/octree/voxel_block_ray_iterator.hpp"
 
+#ifdef _OPENMP
+#    include <omp.h>
+#endif
+
 
 namespace se {
 namespace raycaster {
@@ -82,6 +95,72 @@ typename std::enable_if_t<MapT::col_ == Colour::On && MapT::sem_ != Semantics::O
                                                                                                    const Eigen::Matrix4f& T_WS,
                                                                                                    const SensorT& sensor);
 
+/**
+ * \brief Raycast only every factor-th pixel in each direction and upsample the rest with a
+ * joint-bilateral filter guided by the depth and normals of the 4 surrounding samples. The samples
+ * are weighted bilinearly and by how close their distance and normal are to the bilinear estimates
+ * at the pixel. Pixels whose samples include misses or distances differing by more than
+ * depth_edge_threshold, relative to the closest one, are raycast at full resolution. The number of
+ * raycast pixels, the fraction of the full-resolution budget they represent and the mean distance
+ * and normal angle errors of the upsampled pixels, estimated on a sparse subset, are sampled in
+ * se::perfstats.
+ *
+ * \param[in] factor               The subsampling factor, e.g. 2 or 4.
+ * \param[in] depth_edge_threshold The relative distance difference above which the samples are
+ *                                 considered to lie on different surfaces. It's also the relative
+ *                                 standard deviation of the depth weight.
+ */
+template<typename MapT, typename SensorT>
+void raycast_volume_subsampled(const MapT& map,
+                               se::Image<Eigen::Vector3f>& surface_point_cloud_W,
+                               se::Image<Eigen::Vector3f>& surface_normals_W,
+                               se::Image<int8_t>& surface_scale,
+                               const Eigen::Matrix4f& T_WS,
+                               const SensorT& sensor,
+                               const int factor = 2,
+                               const float depth_edge_threshold = 0.02f);
+
+template<typename MapT, typename SensorT>
+typename std::enable_if_t<MapT::col_ == Colour::On> raycast_volume_subsampled(const MapT& map,
+                                                                              se::Image<Eigen::Vector3f>& surface_point_cloud_W,
+                                                                              se::Image<Eigen::Vector3f>& surface_normals_W,
+                                                                              se::Image<int8_t>& surface_scale,
+                                                                              se::Image<rgb_t>& surface_colour,
+                                                                              const Eigen::Matrix4f& T_WS,
+                                                                              const SensorT& sensor,
+                                                                              const int factor = 2,
+                                                                              const float depth_edge_threshold = 0.02f);
+
+/**
+ * \brief Raycast a TSDF map using the surface raycast in the previous frame as a prediction. The
+ * previous surface is forward-projected into the current view and each ray only searches around
+ * the predicted distance. Pixels without a prediction (e.g. disocclusions) or whose short search
+ * fails are raycast over the whole ray. During smooth motion most rays only take a few steps.
+ *
+ * \note Surfaces that appear in front of the predicted one by more than the search margin (twice
+ * the truncation boundary) are missed until the camera stops seeing the old surface there.
+ *
+ * \param[in] prev_surface_point_cloud_W The surface point cloud raycast in the previous frame.
+ */
+template<typename MapT, typename SensorT>
+void raycast_volume_reprojected(const MapT& map,
+                                se::Image<Eigen::Vector3f>& surface_point_cloud_W,
+                                se::Image<Eigen::Vector3f>& surface_normals_W,
+                                se::Image<int8_t>& surface_scale,
+                                const Eigen::Matrix4f& T_WS,
+                                const SensorT& sensor,
+                                const se::Image<Eigen::Vector3f>& prev_surface_point_cloud_W);
+
+template<typename MapT, typename SensorT>
+typename std::enable_if_t<MapT::col_ == Colour::On> raycast_volume_reprojected(const MapT& map,
+                                                                               se::Image<Eigen::Vector3f>& surface_point_cloud_W,
+                                                                               se::Image<Eigen::Vector3f>& surface_normals_W,
+                                                                               se::Image<int8_t>& surface_scale,
+                                                                               se::Image<rgb_t>& surface_colour,
+                                                                               const Eigen::Matrix4f& T_WS,
+                                                                               const SensorT& sensor,
+                                                                               const se::Image<Eigen::Vector3f>& prev_surface_point_cloud_W);
+
 void render_volume(uint32_t* volume_RGBA_image_data,
                    const Eigen::Vector2i& volume_RGBA_image_res,
                    const se::Image<Eigen::Vector3f>& surface_point_cloud_W,
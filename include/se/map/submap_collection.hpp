@@ -0,0 +1,229 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Smart Robotics Lab, Technical University of Munich
+ * SPDX-FileCopyrightText: 2024 Jiaxin Wei
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef SE_SUBMAP_COLLECTION_HPP
+#define SE_SUBMAP_COLLECTION_HPP
+
+#include <array>
+#include <map>
+#include <memory>
+#include <optional>
+#include <vector>
+
+#include "se/map/map.hpp"
+
+
+namespace se {
+
+/**
+ * \brief A collection of submaps, each one a regular se::Map expressed in its own anchor frame A.
+ *
+ * A new submap is started every MapConfig::submap_frames frames or once the sensor has moved
+ * MapConfig::submap_distance metres away from where the active submap was started. Only the active
+ * submap is integrated into, so the per-frame integration cost is bounded by the size of a single
+ * submap. Moving a submap (e.g. after a pose graph optimisation) only changes its anchor T_WA and
+ * never touches its voxels.
+ *
+ * Queries in the world frame W look up a uniform grid over the AABBs of the submaps in W, with
+ * cells a quarter of the largest edge of MapConfig::dim, and only test the AABBs overlapping the
+ * cell of the point. The grid is updated when submaps grow or are moved.
+ */
+template<typename MapT>
+class SubmapCollection {
+    public:
+    typedef MapT MapType;
+    typedef typename MapT::DataType DataType;
+    typedef typename MapT::DataConfigType DataConfigType;
+    typedef typename MapT::OctreeType OctreeType;
+
+    struct Submap {
+        Submap(const MapConfig& map_config, const DataConfigType& data_config, const Eigen::Matrix4f& T_WA, const int start_frame, const Eigen::Vector3f& t_WS_start) :
+                map(new MapT(map_config, data_config)),
+                T_WA(T_WA),
+                T_AW(math::to_inverse_transformation(T_WA)),
+                start_frame(start_frame),
+                last_frame(start_frame),
+                t_WS_start(t_WS_start)
+        {
+        }
+
+        /** The submap, expressed in the anchor frame A. */
+        std::unique_ptr<MapT> map;
+        /** The transformation from the anchor frame A to the world frame W. */
+        Eigen::Matrix4f T_WA;
+        Eigen::Matrix4f T_AW;
+        /** The AABB of the allocated part of the submap in the anchor frame A. */
+        Eigen::AlignedBox3f aabb_A;
+        /** The frame the submap was started at and the last frame integrated into it. */
+        int start_frame;
+        int last_frame;
+        /** The sensor position in the world frame W when the submap was started. */
+        Eigen::Vector3f t_WS_start;
+
+        EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+    };
+
+    /**
+     * \param[in] map_config  The configuration used for every submap.
+     * \param[in] data_config The data configuration used for every submap.
+     */
+    SubmapCollection(const MapConfig& map_config, const DataConfigType& data_config = DataConfigType());
+
+    bool empty() const
+    {
+        return submaps_.empty();
+    }
+
+    size_t size() const
+    {
+        return submaps_.size();
+    }
+
+    const Submap& operator[](const size_t idx) const
+    {
+        return *submaps_[idx];
+    }
+
+    Submap& operator[](const size_t idx)
+    {
+        return *submaps_[idx];
+    }
+
+    /**
+     * \brief Return the index of the submap currently integrated into.
+     * \warning Only valid if the collection isn't empty.
+     */
+    size_t activeIndex() const
+    {
+        return submaps_.size() - 1;
+    }
+
+    Submap& active()
+    {
+        return *submaps_.back();
+    }
+
+    const Submap& active() const
+    {
+        return *submaps_.back();
+    }
+
+    /**
+     * \brief Start a new submap if the collection is empty or if the active submap has exceeded the
+     * frame or distance limit.
+     *
+     * \param[in] T_WS  The pose of the sensor in the world frame W.
+     * \param[in] frame The frame about to be integrated.
+     * \return True if a new submap was started.
+     */
+    bool update(const Eigen::Matrix4f& T_WS, const int frame);
+
+    /**
+     * \brief Update the AABB of a submap in the world frame W after it has been integrated into.
+     */
+    void updateBounds(const size_t idx);
+
+    /**
+     * \brief Move a submap to a new anchor pose in O(1), without touching its voxels.
+     *
+     * \param[in] idx  The index of the submap.
+     * \param[in] T_WA The new transformation from the anchor frame A to the world frame W.
+     */
+    void setAnchor(const size_t idx, const Eigen::Matrix4f& T_WA);
+
+    /**
+     * \brief Return the AABB of a submap in the world frame W.
+     */
+    const Eigen::AlignedBox3f& aabb(const size_t idx) const
+    {
+        return aabbs_W_[idx];
+    }
+
+    /**
+     * \brief Return the indices of the submaps whose AABB contains the point, newest first.
+     */
+    std::vector<size_t> query(const Eigen::Vector3f& point_W) const;
+
+    /**
+     * \brief Return the indices of the submaps whose AABB intersects the box, newest first.
+     */
+    std::vector<size_t> query(const Eigen::AlignedBox3f& box_W) const;
+
+    /**
+     * \brief Get the data at the provided point from the newest submap that has observed it.
+     */
+    DataType getData(const Eigen::Vector3f& point_W) const;
+
+    /**
+     * \brief Get the interpolated field value at the provided point from the newest submap that can
+     * interpolate it.
+     */
+    std::optional<float> getFieldInterp(const Eigen::Vector3f& point_W) const;
+
+    /**
+     * \brief Return whether any submap started before submap \p idx has observed the point.
+     */
+    bool observedBefore(const Eigen::Vector3f& point_W, const size_t idx) const;
+
+    /**
+     * \brief Mesh all submaps and express the result in the output frame O.
+     *
+     * \param[in] T_OW The transformation from the world frame W to the output frame O.
+     */
+    typename OctreeType::MeshType mesh(const Eigen::Matrix4f& T_OW = Eigen::Matrix4f::Identity()) const;
+
+    /**
+     * \brief Mesh all submaps and save the result to a file.
+     *
+     * \param[in] filename The file where the mesh will be saved. Its extension must be one of those
+     *                     in se::io::mesh_extensions.
+     * \param[in] T_OW     The transformation from the world frame W to the output frame O.
+     * \return Zero on success and non-zero on error.
+     */
+    int saveMesh(const std::string& filename, const Eigen::Matrix4f& T_OW = Eigen::Matrix4f::Identity()) const;
+
+    /**
+     * \brief Raycast all submaps visible from the sensor and keep the closest surface per pixel.
+     * The output is expressed in the world frame W.
+     */
+    template<typename SensorT>
+    void raycastVolume(Image<Eigen::Vector3f>& surface_point_cloud_W,
+                       Image<Eigen::Vector3f>& surface_normals_W,
+                       Image<int8_t>& surface_scale,
+                       Image<rgb_t>* surface_colour,
+                       const Eigen::Matrix4f& T_WS,
+                       const SensorT& sensor) const;
+
+    EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+
+    private:
+    typedef std::array<int, 3> CellKey;
+
+    CellKey cellKey(const Eigen::Vector3f& point_W) const;
+
+    /** Call \p function with the key of every grid cell overlapping the non-empty \p box_W. */
+    template<typename FunctionT>
+    void forEachCell(const Eigen::AlignedBox3f& box_W, FunctionT function) const;
+
+    /** Set the AABB of submap \p idx in the world frame W and move it to the overlapping cells. */
+    void setBounds(const size_t idx, const Eigen::AlignedBox3f& aabb_W);
+
+    const MapConfig map_config_;
+    const DataConfigType data_config_;
+    std::vector<std::unique_ptr<Submap>> submaps_;
+    /** The AABBs of the submaps in the world frame W. */
+    std::vector<Eigen::AlignedBox3f, Eigen::aligned_allocator<Eigen::AlignedBox3f>> aabbs_W_;
+    /** The edge length of the grid cells in metres. */
+    const float cell_size_;
+    /** The indices of the submaps whose AABB overlaps each non-empty cell, in increasing order. */
+    std::map<CellKey, std::vector<size_t>> cells_;
+};
+
+} // namespace se
+
+#include "impl/submap_collection_impl.hpp"
+
+#endif // SE_SUBMAP_COLLECTION_HPP
@@ -22,7 +22,7 @@ class MemoryPool {
     public:
     typedef typename NodeT::DataType DataType;
 
-    MemoryPool() : node_buffer_(sizeof(NodeT)), block_buffer_(sizeof(BlockT))
+    MemoryPool() : node_buffer_(sizeof(NodeT)), block_buffer_(sizeof(BlockT)), num_nodes_(0), num_blocks_(0)
     {
     }
 
@@ -31,6 +31,7 @@ class MemoryPool {
      */
     NodeT* allocateRoot(const Eigen::Vector3i& coord, const int size)
     {
+        num_nodes_++;
         return new (node_buffer_.malloc()) NodeT(coord, size, DataType());
     }
 
@@ -44,6 +45,7 @@ class MemoryPool {
      */
     NodeT* allocateNode(NodeT* parent_ptr, const int child_idx, const DataType& init_data)
     {
+        num_nodes_++;
         return new (node_buffer_.malloc()) NodeT(parent_ptr, child_idx, init_data);
     }
 
@@ -57,6 +59,7 @@ class MemoryPool {
      */
     BlockT* allocateBlock(NodeT* parent_ptr, const int child_idx, const DataType& init_data)
     {
+        num_blocks_++;
         return new (block_buffer_.malloc()) BlockT(parent_ptr, child_idx, init_data);
     }
 
@@ -66,6 +69,7 @@ class MemoryPool {
     {
         node_ptr->~NodeT();
         node_buffer_.free(node_ptr);
+        num_nodes_--;
     }
 
     /** Destruct and deallocate the block pointed to by \p block_ptr.
@@ -74,10 +78,32 @@ class MemoryPool {
     {
         block_ptr->~BlockT();
         block_buffer_.free(block_ptr);
+        num_blocks_--;
+    }
+
+    /** Return the number of bytes used by the currently allocated nodes.
+     */
+    size_t nodeBytes() const
+    {
+        return num_nodes_ * sizeof(NodeT);
+    }
+
+    /** Return the number of bytes used by the currently allocated blocks. Memory allocated by the
+     * blocks themselves, e.g. for the mip-mapped data of multi-res blocks, isn't included.
+     */
+    size_t blockBytes() const
+    {
+        return num_blocks_ * sizeof(BlockT);
     }
 
     boost::pool<> node_buffer_;
     boost::pool<> block_buffer_;
+
+    private:
+    // Updated on every (de)allocation so that reporting memory usage doesn't require traversing
+    // the octree.
+    size_t num_nodes_;
+    size_t num_blocks_;
 };
 
 } // namespace se
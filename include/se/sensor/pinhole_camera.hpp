@@ -33,6 +33,11 @@ struct PinholeCameraConfig : public SensorBaseConfig {
      */
     void readYaml(const std::string& filename);
 
+    /** Scale the resolution and intrinsics to those of images downsampled by \p factor, where
+     * each output pixel covers a block of \p factor x \p factor input pixels.
+     */
+    void downsample(const int factor);
+
     EIGEN_MAKE_ALIGNED_OPERATOR_NEW
 };
 
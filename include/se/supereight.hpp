@@ -9,6 +9,10 @@
 #define SE_SUPEREIGHT_HPP
 
 #include "se/integrator/map_integrator.hpp"
+#include "se/map/active_window.hpp"
+#include "se/map/io/change_feed.hpp"
+#include "se/map/io/tiled_mesh_io.hpp"
 #include "se/map/map.hpp"
+#include "se/map/submap_collection.hpp"
 
 #endif // SE_SUPEREIGHT_HPP
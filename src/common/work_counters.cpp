@@ -0,0 +1,61 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Smart Robotics Lab, Technical University of Munich
+ * SPDX-FileCopyrightText: 2024 Jiaxin Wei
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include "se/common/work_counters.hpp"
+
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace {
+
+struct Registry {
+    std::mutex mutex;
+    // The counters are shared so that they outlive the threads that exit before the reduction.
+    std::vector<std::shared_ptr<se::work::ThreadCounters>> thread_counters;
+    std::array<uint64_t, se::work::NumCounters> last_totals = {};
+};
+
+
+Registry& registry()
+{
+    static Registry registry;
+    return registry;
+}
+
+} // namespace
+
+
+se::work::ThreadCounters& se::work::thread_counters()
+{
+    thread_local std::shared_ptr<ThreadCounters> counters = []() {
+        auto c = std::make_shared<ThreadCounters>();
+        Registry& r = registry();
+        std::lock_guard<std::mutex> lock(r.mutex);
+        r.thread_counters.push_back(c);
+        return c;
+    }();
+    return *counters;
+}
+
+
+void se::work::reduce(PerfStats& perfstats)
+{
+    Registry& r = registry();
+    std::array<uint64_t, NumCounters> totals = {};
+    {
+        std::lock_guard<std::mutex> lock(r.mutex);
+        for (const auto& counters : r.thread_counters) {
+            for (int i = 0; i < NumCounters; i++) {
+                totals[i] += counters->counts[i].load(std::memory_order_relaxed);
+            }
+        }
+    }
+    for (int i = 0; i < NumCounters; i++) {
+        perfstats.sample(counter_names[i], totals[i] - r.last_totals[i], PerfStats::COUNT);
+    }
+    r.last_totals = totals;
+}
@@ -201,6 +201,46 @@ void GaussianModel::Save_ply(const std::filesystem::path& file_path, int frame,
 }
 
 
+size_t GaussianModel::Get_param_bytes() const
+{
+    size_t bytes = 0;
+    for (const auto& param : {_xyz, _features_dc, _features_rest, _scaling, _rotation, _opacity}) {
+        if (param.defined()) {
+            bytes += param.nbytes();
+        }
+    }
+    return bytes;
+}
+
+
+size_t GaussianModel::Get_optimizer_bytes() const
+{
+    if (!optimizer) {
+        return 0;
+    }
+    size_t bytes = 0;
+    for (auto& group : optimizer->param_groups()) {
+        for (const auto& param : group.params()) {
+            if (param.grad().defined()) {
+                bytes += param.grad().nbytes();
+            }
+            // The state is only created on the first optimizer step
+            const auto it = optimizer->state().find(c10::guts::to_string(param.unsafeGetTensorImpl()));
+            if (it == optimizer->state().end()) {
+                continue;
+            }
+            const auto& state = static_cast<const torch::optim::AdamParamState&>(*it->second);
+            for (const auto& moment : {state.exp_avg(), state.exp_avg_sq(), state.max_exp_avg_sq()}) {
+                if (moment.defined()) {
+                    bytes += moment.nbytes();
+                }
+            }
+        }
+    }
+    return bytes;
+}
+
+
 void cat_tensors_to_optimizer(torch::optim::Adam* optimizer, torch::Tensor& extension_tensor, torch::Tensor& old_tensor, int param_position)
 {
     auto adamParamStates = std::make_unique<torch::optim::AdamParamState>(
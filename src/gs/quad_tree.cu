@@ -4,6 +4,7 @@
  * SPDX-License-Identifier: BSD-3-Clause
  */
 
+#include <algorithm>
 #include <numeric>
 
 #include "gs/quad_tree.cuh"
@@ -48,9 +49,30 @@ float Node::computeError(const cv::Mat& img) const
     return error * img.rows * img.cols / 90000000.0;
 }
 
+float Node::computeError(const cv::Mat& img, const cv::Mat& sum, const cv::Mat& squared_sum) const
+{
+    const int x1 = x0_ + width_;
+    const int y1 = y0_ + height_;
+    const cv::Vec3d pixel_sum = sum.at<cv::Vec3d>(y1, x1) - sum.at<cv::Vec3d>(y0_, x1) - sum.at<cv::Vec3d>(y1, x0_) + sum.at<cv::Vec3d>(y0_, x0_);
+    const cv::Vec3d pixel_squared_sum =
+        squared_sum.at<cv::Vec3d>(y1, x1) - squared_sum.at<cv::Vec3d>(y0_, x1) - squared_sum.at<cv::Vec3d>(y1, x0_) + squared_sum.at<cv::Vec3d>(y0_, x0_);
+
+    // The mean squared difference from the mean is the mean of the squares minus the squared mean.
+    const double count = width_ * height_;
+    float mse[3];
+    for (int c = 0; c < 3; c++) {
+        const double mean = pixel_sum[c] / count;
+        mse[c] = std::max(pixel_squared_sum[c] / count - mean * mean, 0.0);
+    }
+
+    float error = mse[0] * 0.2989 + mse[1] * 0.5870 + mse[2] * 0.1140;
+
+    return error * img.rows * img.cols / 90000000.0;
+}
+
 void QTree::subdivide()
 {
-    recursive_subdivide(root_, threshold_, min_pixel_size_, img_);
+    recursive_subdivide(root_, threshold_, min_pixel_size_, img_, sum_, squared_sum_);
     all_children_ = find_children(root_);
 }
 
@@ -82,9 +104,10 @@ void QTree::renderImg(int thickness, cv::Scalar color)
     cv::waitKey(0);
 }
 
-void recursive_subdivide(Node& node, float threshold, int min_pixel_size, cv::Mat& img)
+void recursive_subdivide(Node& node, float threshold, int min_pixel_size, cv::Mat& img, const cv::Mat& sum, const cv::Mat& squared_sum)
 {
-    if (node.computeError(img) <= threshold) {
+    const float error = sum.empty() ? node.computeError(img) : node.computeError(img, sum, squared_sum);
+    if (error <= threshold) {
         return;
     }
 
@@ -99,16 +122,16 @@ void recursive_subdivide(Node& node, float threshold, int min_pixel_size, cv::Ma
 
     // top left
     Node n1(node.getOriginX(), node.getOriginY(), w1, h1);
-    recursive_subdivide(n1, threshold, min_pixel_size, img);
+    recursive_subdivide(n1, threshold, min_pixel_size, img, sum, squared_sum);
     // bottom left
     Node n2(node.getOriginX(), node.getOriginY() + h1, w1, h2);
-    recursive_subdivide(n2, threshold, min_pixel_size, img);
+    recursive_subdivide(n2, threshold, min_pixel_size, img, sum, squared_sum);
     // top right
     Node n3(node.getOriginX() + w1, node.getOriginY(), w2, h1);
-    recursive_subdivide(n3, threshold, min_pixel_size, img);
+    recursive_subdivide(n3, threshold, min_pixel_size, img, sum, squared_sum);
     // bottom right
     Node n4(node.getOriginX() + w1, node.getOriginY() + h1, w2, h2);
-    recursive_subdivide(n4, threshold, min_pixel_size, img);
+    recursive_subdivide(n4, threshold, min_pixel_size, img, sum, squared_sum);
 
     std::vector<Node> children{n1, n2, n3, n4};
     node.children = children;
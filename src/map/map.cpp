@@ -58,6 +58,13 @@ void MapConfig::readYaml(const std::string& yaml_file)
         se::yaml::subnode_as_eigen_matrix3f(node, "R_MW", R_MW);
         T_MW.topLeftCorner<3, 3>() = R_MW;
     }
+
+    se::yaml::subnode_as_int(node, "submap_frames", submap_frames);
+    se::yaml::subnode_as_float(node, "submap_distance", submap_distance);
+    se::yaml::subnode_as_float(node, "mesh_decimation_ratio", mesh_decimation_ratio);
+    se::yaml::subnode_as_float(node, "mesh_decimation_error", mesh_decimation_error);
+    se::yaml::subnode_as_float(node, "active_radius", active_radius);
+    se::yaml::subnode_as_bool(node, "compress_inactive", compress_inactive);
 }
 
 
@@ -66,6 +73,12 @@ std::ostream& operator<<(std::ostream& os, const MapConfig& c)
     os << str_utils::volume_to_pretty_str(c.dim, "dim") << " m\n";
     os << str_utils::value_to_pretty_str(c.res, "res") << " m/voxel\n";
     os << str_utils::eigen_matrix_to_pretty_str(c.T_MW, "T_MW") << "\n";
+    os << str_utils::value_to_pretty_str(c.submap_frames, "submap_frames") << " frames\n";
+    os << str_utils::value_to_pretty_str(c.submap_distance, "submap_distance") << " m\n";
+    os << str_utils::value_to_pretty_str(c.mesh_decimation_ratio, "mesh_decimation_ratio") << "\n";
+    os << str_utils::value_to_pretty_str(c.mesh_decimation_error, "mesh_decimation_error") << " m\n";
+    os << str_utils::value_to_pretty_str(c.active_radius, "active_radius") << " m\n";
+    os << str_utils::bool_to_pretty_str(c.compress_inactive, "compress_inactive") << "\n";
     return os;
 }
 } // namespace se
@@ -10,6 +10,7 @@
 #include "se/map/preprocessor.hpp"
 
 #include <Eigen/StdVector>
+#include <cmath>
 #include <iostream>
 
 #include "se/common/math_util.hpp"
@@ -111,5 +112,100 @@ void half_sample_robust_image(se::Image<float>& output_image, const se::Image<fl
     }
 }
 
+
+void downsample_image(se::Image<se::rgb_t>& output_image, const se::Image<se::rgb_t>& input_image, const int factor)
+{
+    if ((input_image.width() / factor != output_image.width()) || (input_image.height() / factor != output_image.height())) {
+        output_image = se::Image<se::rgb_t>(input_image.width() / factor, input_image.height() / factor);
+    }
+    const int num_block_pixels = factor * factor;
+
+#pragma omp parallel for
+    for (int y = 0; y < output_image.height(); y++) {
+        for (int x = 0; x < output_image.width(); x++) {
+            int r_sum = 0;
+            int g_sum = 0;
+            int b_sum = 0;
+            for (int i = 0; i < factor; ++i) {
+                for (int j = 0; j < factor; ++j) {
+                    const se::rgb_t& in_pixel = input_image(factor * x + j, factor * y + i);
+                    r_sum += in_pixel.r;
+                    g_sum += in_pixel.g;
+                    b_sum += in_pixel.b;
+                }
+            }
+            // Round to nearest.
+            output_image(x, y) = {static_cast<uint8_t>((r_sum + num_block_pixels / 2) / num_block_pixels),
+                                  static_cast<uint8_t>((g_sum + num_block_pixels / 2) / num_block_pixels),
+                                  static_cast<uint8_t>((b_sum + num_block_pixels / 2) / num_block_pixels)};
+        }
+    }
+}
+
+
+size_t remove_flying_pixels(se::Image<float>& depth_image, se::Image<float>& scratch_image, const float max_relative_jump, const int min_support)
+{
+    scratch_image = depth_image;
+    const float* in = scratch_image.data();
+    float* out = depth_image.data();
+    const int width = depth_image.width();
+    size_t num_removed = 0;
+
+#pragma omp parallel for reduction(+ : num_removed)
+    for (int y = 1; y < depth_image.height() - 1; y++) {
+        // Branch-free so that the pixels of a row are processed in SIMD lanes.
+#pragma omp simd reduction(+ : num_removed)
+        for (int x = 1; x < width - 1; x++) {
+            const int idx = x + y * width;
+            const float depth = in[idx];
+            const float max_jump = max_relative_jump * depth;
+            int support = 0;
+            for (int i = -1; i <= 1; i++) {
+                for (int j = -1; j <= 1; j++) {
+                    const float neighbour_depth = in[idx + j + i * width];
+                    support += (neighbour_depth > 0.0f) & (std::fabs(neighbour_depth - depth) <= max_jump);
+                }
+            }
+            // The pixel itself was counted if valid.
+            const bool valid = (depth > 0.0f) & (support - 1 >= min_support);
+            out[idx] = valid ? depth : 0.0f;
+            num_removed += (depth > 0.0f) & !valid;
+        }
+    }
+    return num_removed;
+}
+
+
+void bilateral_filter(se::Image<float>& depth_image, se::Image<float>& scratch_image, const float max_relative_jump)
+{
+    scratch_image = depth_image;
+    const float* in = scratch_image.data();
+    float* out = depth_image.data();
+    const int width = depth_image.width();
+
+#pragma omp parallel for
+    for (int y = 1; y < depth_image.height() - 1; y++) {
+        // Branch-free so that the pixels of a row are processed in SIMD lanes.
+#pragma omp simd
+        for (int x = 1; x < width - 1; x++) {
+            const int idx = x + y * width;
+            const float depth = in[idx];
+            const float max_jump = max_relative_jump * depth;
+            float sum = 0.0f;
+            float count = 0.0f;
+            for (int i = -1; i <= 1; i++) {
+                for (int j = -1; j <= 1; j++) {
+                    const float neighbour_depth = in[idx + j + i * width];
+                    const bool consistent = (neighbour_depth > 0.0f) & (std::fabs(neighbour_depth - depth) <= max_jump);
+                    sum += consistent ? neighbour_depth : 0.0f;
+                    count += consistent ? 1.0f : 0.0f;
+                }
+            }
+            // Invalid pixels have no consistent neighbours, not even themselves.
+            out[idx] = (count > 0.0f) ? sum / count : 0.0f;
+        }
+    }
+}
+
 } // namespace preprocessor
 } // namespace se
@@ -29,6 +29,21 @@ void se::PinholeCameraConfig::readYaml(const std::string& filename)
 }
 
 
+void se::PinholeCameraConfig::downsample(const int factor)
+{
+    if (factor <= 1) {
+        return;
+    }
+    width /= factor;
+    height /= factor;
+    fx /= factor;
+    fy /= factor;
+    // Pixel centres are at integer coordinates so the optical centre is scaled around (-0.5, -0.5).
+    cx = (cx + 0.5f) / factor - 0.5f;
+    cy = (cy + 0.5f) / factor - 0.5f;
+}
+
+
 std::ostream& se::operator<<(std::ostream& os, const se::PinholeCameraConfig& c)
 {
     os << str_utils::value_to_pretty_str(c.width, "width") << " px\n";